@@ -585,6 +585,10 @@ WhisperContextInitResult hostInitWhisperContext(
     params.dtw_token_timestamps = false;
     params.use_gpu = false;
     params.flash_attn = options.useFlashAttn;
+    params.use_mmap = options.useMmap;
+    params.type_k = options.cacheTypeK;
+    params.type_v = options.cacheTypeV;
+    params.encoder_cache_size = options.encoderCacheSize;
     params.use_coreml = false;
 
     if (options.useGpu) {
@@ -678,6 +682,7 @@ ParakeetContextInitResult hostInitParakeetContext(
 
     auto params = parakeet_context_default_params();
     params.use_gpu = false;
+    params.use_mmap = options.useMmap;
     if (options.useGpu) {
         result.reasonNoGPU = "Currently not supported";
     }
@@ -744,6 +749,26 @@ std::vector<uint8_t> hostLoadFileBytes(const std::string &path) {
     return bytes;
 }
 
+std::string hostResolveLocalFilePath(const std::string &path) {
+    bool needsDetach = false;
+    JNIEnv *env = getEnv(&needsDetach);
+    if (!env) {
+        return "";
+    }
+
+    std::string resolvedPath = path;
+    if (isRemoteUrl(resolvedPath)) {
+        resolvedPath = downloadToCache(env, resolvedPath, "");
+    }
+    // Same lookup order as hostLoadFileBytes
+    if (isAssetPath(resolvedPath) || getResourceIdentifier(env, resolvedPath) != 0) {
+        resolvedPath.clear();
+    }
+
+    detachThreadIfNeeded(needsDetach);
+    return resolvedPath;
+}
+
 void hostClearCache() {
     bool needsDetach = false;
     JNIEnv *env = getEnv(&needsDetach);
@@ -2,6 +2,7 @@
 #include "ThreadPool.h"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -11,6 +12,7 @@
 #include <cstdio>
 #include <cstring>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
@@ -20,6 +22,11 @@
 #include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #if defined(__ANDROID__)
 #include <android/log.h>
 #endif
@@ -283,10 +290,113 @@ struct SegmentData {
     int t1 = 0;
 };
 
+// Segments and tokens of a result in one buffer, see packedResult in
+// TranscribeOptions. Sections are laid out back to back, 4-byte sections
+// first so every typed array view on the JS side is aligned:
+//   textOffsets  u32 x (nSegments + 1)  byte offsets into text
+//   segmentTimes i32 x nSegments * 2    t0, t1
+//   tokenOffsets u32 x (nSegments + 1)  index of the first token of a segment
+//   tokenIds     i32 x nTokens
+//   tokenTimes   i32 x nTokens * 3      t0, t1, t_dtw
+//   tokenProbs   f32 x nTokens
+//   text         UTF-8 bytes of all segments
+struct PackedResultData {
+    std::vector<uint8_t> bytes;
+    int nSegments = 0;
+    int nTokens = 0;
+};
+
+class PackedResultBuilder {
+public:
+    void addToken(int id, int64_t t0, int64_t t1, int64_t tDtw, float p) {
+        tokenIds_.push_back(id);
+        tokenTimes_.push_back(static_cast<int32_t>(t0));
+        tokenTimes_.push_back(static_cast<int32_t>(t1));
+        tokenTimes_.push_back(static_cast<int32_t>(tDtw));
+        tokenProbs_.push_back(p);
+    }
+
+    // Closes the segment owning the tokens added since the previous one
+    void addSegment(const std::string &text, int64_t t0, int64_t t1) {
+        text_.append(text);
+        textOffsets_.push_back(static_cast<uint32_t>(text_.size()));
+        segmentTimes_.push_back(static_cast<int32_t>(t0));
+        segmentTimes_.push_back(static_cast<int32_t>(t1));
+        tokenOffsets_.push_back(static_cast<uint32_t>(tokenIds_.size()));
+    }
+
+    const std::string &text() const {
+        return text_;
+    }
+
+    std::shared_ptr<PackedResultData> finish() const {
+        auto packed = std::make_shared<PackedResultData>();
+        packed->nSegments = static_cast<int>(segmentTimes_.size() / 2);
+        packed->nTokens = static_cast<int>(tokenIds_.size());
+        packed->bytes.resize(
+            sizeOf(textOffsets_) + sizeOf(segmentTimes_) + sizeOf(tokenOffsets_) +
+            sizeOf(tokenIds_) + sizeOf(tokenTimes_) + sizeOf(tokenProbs_) +
+            text_.size());
+        uint8_t *out = packed->bytes.data();
+        out = append(out, textOffsets_);
+        out = append(out, segmentTimes_);
+        out = append(out, tokenOffsets_);
+        out = append(out, tokenIds_);
+        out = append(out, tokenTimes_);
+        out = append(out, tokenProbs_);
+        if (!text_.empty()) {
+            std::memcpy(out, text_.data(), text_.size());
+        }
+        return packed;
+    }
+
+private:
+    template <typename T>
+    static size_t sizeOf(const std::vector<T> &values) {
+        return values.size() * sizeof(T);
+    }
+
+    template <typename T>
+    static uint8_t *append(uint8_t *out, const std::vector<T> &values) {
+        if (!values.empty()) {
+            std::memcpy(out, values.data(), sizeOf(values));
+        }
+        return out + sizeOf(values);
+    }
+
+    std::string text_;
+    std::vector<uint32_t> textOffsets_{0};
+    std::vector<int32_t> segmentTimes_;
+    std::vector<uint32_t> tokenOffsets_{0};
+    std::vector<int32_t> tokenIds_;
+    std::vector<int32_t> tokenTimes_;
+    std::vector<float> tokenProbs_;
+};
+
+// Hands the packed bytes to the runtime without another copy
+class PackedResultBuffer : public jsi::MutableBuffer {
+public:
+    explicit PackedResultBuffer(std::shared_ptr<PackedResultData> packed)
+        : packed_(std::move(packed)) {}
+
+    size_t size() const override {
+        return packed_->bytes.size();
+    }
+
+    uint8_t *data() override {
+        return packed_->bytes.data();
+    }
+
+private:
+    std::shared_ptr<PackedResultData> packed_;
+};
+
 struct TranscribeResultData {
     std::string language;
     std::string result;
     std::vector<SegmentData> segments;
+    // Set instead of segments when packedResult is enabled
+    std::shared_ptr<PackedResultData> packed;
     bool isAborted = false;
 };
 
@@ -297,6 +407,11 @@ struct NewSegmentsData {
     std::vector<SegmentData> segments;
 };
 
+struct StreamSegmentsData {
+    std::vector<SegmentData> committed;
+    std::vector<SegmentData> partial;
+};
+
 struct VadSegmentData {
     float t0 = 0;
     float t1 = 0;
@@ -307,6 +422,41 @@ struct VadResultData {
     std::vector<VadSegmentData> segments;
 };
 
+struct VadStreamEventData {
+    bool speech = false;
+    float t0 = 0;
+    float t1 = -1;
+};
+
+// Float32 samples passed to the native APIs. They are either decoded into an
+// owned vector or borrowed from a JS Float32Array, `owner` keeps them alive.
+struct AudioSamples {
+    const float *data() const {
+        return samples;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    const float *samples = nullptr;
+    size_t count = 0;
+    std::shared_ptr<const void> owner;
+};
+
+AudioSamples makeAudioSamples(std::vector<float> audio) {
+    auto owned = std::make_shared<std::vector<float>>(std::move(audio));
+    AudioSamples result;
+    result.samples = owned->data();
+    result.count = owned->size();
+    result.owner = std::move(owned);
+    return result;
+}
+
 struct ContextLifecycle {
     void retainTask() {
         std::lock_guard<std::mutex> lock(mutex);
@@ -337,13 +487,17 @@ struct ContextLifecycle {
     int pendingTasks = 0;
 };
 
+struct WhisperStreamSession;
+
 struct WhisperContextHolder : public ContextLifecycle {
     explicit WhisperContextHolder(int contextId)
         : id(contextId) {}
 
+    // Takes the whole context (default state included), fails while any
+    // pooled transcription is running.
     bool beginExclusiveOperation(int jobId) {
         std::lock_guard<std::mutex> lock(operationMutex);
-        if (busy) {
+        if (busy || activeStates > 0) {
             return false;
         }
         busy = true;
@@ -357,18 +511,100 @@ struct WhisperContextHolder : public ContextLifecycle {
         activeJobId = -1;
     }
 
+    // Reserves a state slot for a transcription, returns -1 if the context is
+    // busy or all slots are in use. Slot 0 is the context's default state.
+    int acquireState(int jobId) {
+        std::lock_guard<std::mutex> lock(operationMutex);
+        if (busy) {
+            return -1;
+        }
+        for (size_t slot = 0; slot < stateJobIds.size(); ++slot) {
+            if (stateInUse[slot]) {
+                continue;
+            }
+            stateInUse[slot] = true;
+            stateJobIds[slot] = jobId;
+            activeStates += 1;
+            return static_cast<int>(slot);
+        }
+        return -1;
+    }
+
+    void releaseState(int slot) {
+        std::lock_guard<std::mutex> lock(operationMutex);
+        stateInUse[slot] = false;
+        stateJobIds[slot] = -1;
+        activeStates -= 1;
+    }
+
+    // Only called by the task owning the slot. Pooled states are created on
+    // first use so an unused slot costs nothing.
+    whisper_state *getState(int slot) {
+        if (slot == 0) {
+            return nullptr;
+        }
+        if (states[slot] == nullptr) {
+            states[slot] = whisper_init_state(context);
+        }
+        return states[slot];
+    }
+
+    // nProcessors > 1 splits the audio across temporary states created from
+    // the default one, so it needs the whole context.
+    int beginTranscription(int jobId, int nProcessors) {
+        if (nProcessors > 1) {
+            return beginExclusiveOperation(jobId) ? 0 : -1;
+        }
+        return acquireState(jobId);
+    }
+
+    void endTranscription(int slot, int nProcessors) {
+        if (nProcessors > 1) {
+            endExclusiveOperation();
+        } else {
+            releaseState(slot);
+        }
+    }
+
+    void setMaxStates(int count) {
+        std::lock_guard<std::mutex> lock(operationMutex);
+        size_t size = static_cast<size_t>(std::max(1, count));
+        states.assign(size, nullptr);
+        stateInUse.assign(size, false);
+        stateJobIds.assign(size, -1);
+    }
+
+    // Requires the context to be idle
+    void freeStates() {
+        for (auto *&state : states) {
+            if (state != nullptr) {
+                whisper_free_state(state);
+                state = nullptr;
+            }
+        }
+    }
+
     void abortActiveJob() {
         std::lock_guard<std::mutex> lock(operationMutex);
-        if (activeJobId < 0) {
-            return;
+        if (activeJobId >= 0) {
+            if (auto *job = rnwhisper::job_get(activeJobId)) {
+                job->abort();
+            }
         }
-        if (auto *job = rnwhisper::job_get(activeJobId)) {
-            job->abort();
+        for (size_t slot = 0; slot < stateJobIds.size(); ++slot) {
+            if (!stateInUse[slot] || stateJobIds[slot] < 0) {
+                continue;
+            }
+            if (auto *job = rnwhisper::job_get(stateJobIds[slot])) {
+                job->abort();
+            }
         }
     }
 
     int id = 0;
     whisper_context *context = nullptr;
+    // Drafts tokens for speculative decoding, each state keeps its own draft state
+    whisper_context *draftContext = nullptr;
     long ptr = 0;
     bool gpu = false;
     std::string reasonNoGPU;
@@ -376,17 +612,120 @@ struct WhisperContextHolder : public ContextLifecycle {
     std::mutex operationMutex;
     bool busy = false;
     int activeJobId = -1;
+
+    // Transcription state pool sharing the model weights, states[0] stays
+    // nullptr and stands for the context's default state.
+    std::vector<whisper_state *> states = {nullptr};
+    std::vector<bool> stateInUse = {false};
+    std::vector<int> stateJobIds = {-1};
+    int activeStates = 0;
+
+    // Open whisperStreamStart session, owns the exclusive operation until flushed.
+    std::shared_ptr<WhisperStreamSession> streamSession;
+};
+
+struct WhisperVadStreamSession {
+    ~WhisperVadStreamSession() {
+        release();
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(processMutex);
+        if (stream != nullptr) {
+            whisper_vad_stream_free(stream);
+            stream = nullptr;
+        }
+    }
+
+    // Same scheme as WhisperStreamSession: audio is queued in call order and
+    // drained by at most one pool task. Returns true when the caller has to
+    // schedule the drain task.
+    bool enqueue(const AudioSamples &audio) {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.insert(pending.end(), audio.data(), audio.data() + audio.size());
+        if (drainScheduled) {
+            return false;
+        }
+        drainScheduled = true;
+        return true;
+    }
+
+    // Requires processMutex
+    int drain() {
+        std::vector<float> audio;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            audio.swap(pending);
+        }
+        if (audio.empty() || stream == nullptr) {
+            return 0;
+        }
+        return whisper_vad_stream_push(stream, audio.data(), static_cast<int>(audio.size()));
+    }
+
+    // Body of the drain task, also takes the audio pushed while it runs and
+    // collects the events of all of it
+    int drainScheduledAudio(std::vector<VadStreamEventData> &events) {
+        std::lock_guard<std::mutex> lock(processMutex);
+        for (;;) {
+            int code = drain();
+            if (code > 0) {
+                auto detected = this->events();
+                events.insert(events.end(), detected.begin(), detected.end());
+            }
+            std::lock_guard<std::mutex> pendingLock(pendingMutex);
+            if (code < 0 || pending.empty()) {
+                drainScheduled = false;
+                return code;
+            }
+        }
+    }
+
+    void cancelScheduledDrain() {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        drainScheduled = false;
+    }
+
+    std::vector<VadStreamEventData> events() const {
+        std::vector<VadStreamEventData> result;
+        int count = whisper_vad_stream_n_events(stream);
+        result.reserve(static_cast<size_t>(count));
+        for (int index = 0; index < count; ++index) {
+            result.push_back({
+                whisper_vad_stream_get_event_speech(stream, index),
+                whisper_vad_stream_get_event_t0(stream, index),
+                whisper_vad_stream_get_event_t1(stream, index),
+            });
+        }
+        return result;
+    }
+
+    whisper_vad_stream *stream = nullptr;
+
+    std::mutex pendingMutex;
+    std::vector<float> pending;
+    bool drainScheduled = false;
+    std::mutex processMutex;
 };
 
 struct WhisperVadContextHolder : public ContextLifecycle {
     explicit WhisperVadContextHolder(int contextId)
         : id(contextId) {}
 
+    std::shared_ptr<WhisperVadStreamSession> getStreamSession() {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        return streamSession;
+    }
+
     int id = 0;
     whisper_vad_context *context = nullptr;
     long ptr = 0;
     bool gpu = false;
     std::string reasonNoGPU;
+
+    // Open whisperVadStreamStart session, it owns the LSTM state of the context until flushed.
+    std::mutex streamMutex;
+    std::shared_ptr<WhisperVadStreamSession> streamSession;
 };
 
 std::atomic<int> g_parakeetDetachedContexts{0};
@@ -484,22 +823,180 @@ using PromiseResultGenerator = std::function<jsi::Value(jsi::Runtime &)>;
 using PromiseTask = std::function<PromiseResultGenerator()>;
 using JsiFunctionPtr = std::shared_ptr<jsi::Function>;
 
+// Runs deferred callback deliveries on one thread shared by all callbacks.
+// Started on first use, stopped by cleanupJSIBindings.
+class DeliveryTimer {
+public:
+    static DeliveryTimer &getInstance() {
+        static DeliveryTimer instance;
+        return instance;
+    }
+
+    void schedule(std::chrono::steady_clock::duration delay, std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (g_isShuttingDown.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (!thread_.joinable()) {
+            stop_ = false;
+            thread_ = std::thread([this] { run(); });
+        }
+        tasks_.emplace(std::chrono::steady_clock::now() + delay, std::move(callback));
+        condition_.notify_one();
+    }
+
+    // Drops the deliveries that are not due yet
+    void shutdown() {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            tasks_.clear();
+            thread.swap(thread_);
+        }
+        condition_.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    ~DeliveryTimer() {
+        shutdown();
+    }
+
+private:
+    DeliveryTimer() = default;
+    DeliveryTimer(const DeliveryTimer &) = delete;
+    DeliveryTimer &operator=(const DeliveryTimer &) = delete;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            if (tasks_.empty()) {
+                condition_.wait(lock);
+                continue;
+            }
+            auto due = tasks_.begin()->first;
+            if (std::chrono::steady_clock::now() < due) {
+                condition_.wait_until(lock, due);
+                continue;
+            }
+            auto callback = std::move(tasks_.begin()->second);
+            tasks_.erase(tasks_.begin());
+            lock.unlock();
+            callback();
+            lock.lock();
+        }
+    }
+
+    std::multimap<std::chrono::steady_clock::time_point, std::function<void()>> tasks_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stop_ = false;
+};
+
 struct JsiCallbackState {
     std::shared_ptr<react::CallInvoker> callInvoker;
     JsiFunctionPtr callback;
     std::shared_ptr<jsi::Runtime> runtime;
     int contextId = -1;
+
+    // Progress and new segment events are coalesced: at most one delivery is
+    // queued on the JS thread, events arriving meanwhile are merged into it,
+    // and deliveries are at least intervalMs apart unless forced on completion.
+    // A delivery held back by the interval is deferred to lastDelivery +
+    // intervalMs on the DeliveryTimer, a forced one takes it over right away.
+    // The inference thread only ever takes pendingMutex for the merge.
+    std::mutex pendingMutex;
+    bool deliveryQueued = false;
+    bool deliveryDeferred = false;
+    int intervalMs = 0;
+    std::chrono::steady_clock::time_point lastDelivery;
+    std::chrono::steady_clock::time_point deferredUntil;
+
+    // Requires pendingMutex. Returns false when a delivery is already on its
+    // way, otherwise claims one that has to wait `delay` before it is queued.
+    bool claimDelivery(bool force, std::chrono::steady_clock::duration &delay) {
+        delay = std::chrono::steady_clock::duration::zero();
+        if (deliveryQueued) {
+            if (!force || !deliveryDeferred) {
+                return false;
+            }
+            deliveryDeferred = false;
+            return true;
+        }
+        deliveryQueued = true;
+        if (!force && intervalMs > 0) {
+            auto due = lastDelivery + std::chrono::milliseconds(intervalMs);
+            auto now = std::chrono::steady_clock::now();
+            if (now < due) {
+                delay = due - now;
+                deliveryDeferred = true;
+                deferredUntil = due;
+            }
+        }
+        return true;
+    }
+
+    // Requires pendingMutex, called by the DeliveryTimer. False when a forced
+    // delivery took the deferred one over, or the timer belongs to an earlier
+    // deferral and a later one is still waiting.
+    bool takeDeferredDelivery() {
+        if (!deliveryDeferred || std::chrono::steady_clock::now() < deferredUntil) {
+            return false;
+        }
+        deliveryDeferred = false;
+        return true;
+    }
+
+    // Requires pendingMutex, called by the delivery on the JS thread
+    void finishDelivery() {
+        deliveryQueued = false;
+        lastDelivery = std::chrono::steady_clock::now();
+    }
+};
+
+// Queues `deliver` now, or on the DeliveryTimer when the claim has a delay
+template <typename State>
+void scheduleDelivery(
+    const std::shared_ptr<State> &state,
+    std::chrono::steady_clock::duration delay,
+    void (*deliver)(const std::shared_ptr<State> &)) {
+    if (delay <= std::chrono::steady_clock::duration::zero()) {
+        deliver(state);
+        return;
+    }
+    DeliveryTimer::getInstance().schedule(delay, [state, deliver]() {
+        {
+            std::lock_guard<std::mutex> lock(state->pendingMutex);
+            if (!state->takeDeferredDelivery()) {
+                return;
+            }
+        }
+        deliver(state);
+    });
+}
+
+struct ProgressCallbackState : public JsiCallbackState {
+    int pendingProgress = -1;
 };
 
 struct SegmentCallbackState : public JsiCallbackState {
     bool tdrzEnable = false;
     int totalNNew = 0;
+    bool hasPending = false;
+    NewSegmentsData pending;
 };
 
 jsi::Value createNewSegmentsValue(
     jsi::Runtime &runtime,
     const NewSegmentsData &data);
 
+jsi::Value createStreamSegmentsValue(
+    jsi::Runtime &runtime,
+    const StreamSegmentsData &data);
+
 std::mutex g_logMutex;
 std::weak_ptr<react::CallInvoker> g_logInvoker;
 std::shared_ptr<jsi::Function> g_logHandler;
@@ -577,7 +1074,8 @@ jsi::Value createPromiseTask(
     PromiseTask task,
     int contextId = -1,
     bool trackTask = true,
-    std::function<void()> onTaskAbandoned = {}) {
+    std::function<void()> onTaskAbandoned = {},
+    TaskPriority priority = TaskPriority::Normal) {
     auto promiseCtor =
         runtime.global().getPropertyAsObject(runtime, "Promise").asFunction(runtime);
     auto runtimePtr = std::shared_ptr<jsi::Runtime>(&runtime, [](jsi::Runtime *) {});
@@ -588,7 +1086,7 @@ jsi::Value createPromiseTask(
             runtime,
             jsi::PropNameID::forAscii(runtime, "executor"),
             2,
-            [callInvoker, task, runtimePtr, contextId, trackTask, onTaskAbandoned](
+            [callInvoker, task, runtimePtr, contextId, trackTask, onTaskAbandoned, priority](
                 jsi::Runtime &runtime,
                 const jsi::Value &,
                 const jsi::Value *arguments,
@@ -714,7 +1212,7 @@ jsi::Value createPromiseTask(
                         if (!invokeScheduled && shouldTrack) {
                             TaskManager::getInstance().finishTask(contextId);
                         }
-                    });
+                    }, priority, contextId);
                 } catch (const std::exception &error) {
                     LOG_ERROR(
                         "createPromiseTask enqueue exception contextId=%d message=%s",
@@ -733,14 +1231,16 @@ jsi::Value createPromiseTask(
             }));
 }
 
-jsi::Value createResolvedPromise(jsi::Runtime &runtime) {
+jsi::Value createResolvedPromise(
+    jsi::Runtime &runtime,
+    const jsi::Value &value = jsi::Value::undefined()) {
     auto promiseConstructor =
         runtime.global().getPropertyAsObject(runtime, "Promise");
     auto resolve = promiseConstructor.getPropertyAsFunction(runtime, "resolve");
     return resolve.callWithThis(
         runtime,
         promiseConstructor,
-        jsi::Value::undefined());
+        value);
 }
 
 void invokeAsyncTracked(
@@ -763,25 +1263,104 @@ void invokeAsyncTracked(
     }
 }
 
+void queueProgressDelivery(const std::shared_ptr<ProgressCallbackState> &state) {
+    invokeAsyncTracked(state->callInvoker, state->contextId, [state](bool shouldProceed) {
+        int progress = -1;
+        {
+            std::lock_guard<std::mutex> lock(state->pendingMutex);
+            std::swap(progress, state->pendingProgress);
+            state->finishDelivery();
+        }
+        if (!shouldProceed || progress < 0 || !g_whisperContexts.get(state->contextId)) {
+            return;
+        }
+        auto &rt = *state->runtime;
+        state->callback->call(rt, jsi::Value(progress));
+    });
+}
+
+// Keeps only the latest progress while a delivery is pending or rate limited
 void emitProgressCallback(
-    const std::shared_ptr<JsiCallbackState> &state,
-    int progress) {
+    const std::shared_ptr<ProgressCallbackState> &state,
+    int progress,
+    bool force = false) {
     if (!state || !state->callInvoker || !state->callback || !state->runtime) {
         return;
     }
 
-    invokeAsyncTracked(state->callInvoker, state->contextId, [state, progress](bool shouldProceed) {
-        if (!shouldProceed || !g_whisperContexts.get(state->contextId)) {
+    std::chrono::steady_clock::duration delay;
+    {
+        std::lock_guard<std::mutex> lock(state->pendingMutex);
+        if (progress >= 0) {
+            state->pendingProgress = progress;
+        }
+        if (state->pendingProgress < 0 || !state->claimDelivery(force, delay)) {
+            return;
+        }
+    }
+    scheduleDelivery(state, delay, queueProgressDelivery);
+}
+
+// Delivers what is still pending once the transcription is done
+void flushProgressCallback(const std::shared_ptr<ProgressCallbackState> &state) {
+    emitProgressCallback(state, -1, true);
+}
+
+void queueNewSegmentsDelivery(const std::shared_ptr<SegmentCallbackState> &state) {
+    invokeAsyncTracked(state->callInvoker, state->contextId, [state](bool shouldProceed) {
+        NewSegmentsData payload;
+        bool hasPayload = false;
+        {
+            std::lock_guard<std::mutex> lock(state->pendingMutex);
+            std::swap(payload, state->pending);
+            std::swap(hasPayload, state->hasPending);
+            state->finishDelivery();
+        }
+        if (!shouldProceed || !hasPayload || !g_whisperContexts.get(state->contextId)) {
             return;
         }
         auto &rt = *state->runtime;
-        state->callback->call(rt, jsi::Value(progress));
+        state->callback->call(rt, createNewSegmentsValue(rt, payload));
     });
 }
 
+// Appends to the pending payload, so one call may report several events
 void emitNewSegmentsCallback(
     const std::shared_ptr<SegmentCallbackState> &state,
-    NewSegmentsData payload) {
+    NewSegmentsData payload,
+    bool force = false) {
+    if (!state || !state->callInvoker || !state->callback || !state->runtime) {
+        return;
+    }
+
+    std::chrono::steady_clock::duration delay;
+    {
+        std::lock_guard<std::mutex> lock(state->pendingMutex);
+        if (payload.nNew > 0) {
+            auto &pending = state->pending;
+            pending.nNew += payload.nNew;
+            pending.totalNNew = payload.totalNNew;
+            pending.result.append(payload.result);
+            pending.segments.insert(
+                pending.segments.end(),
+                std::make_move_iterator(payload.segments.begin()),
+                std::make_move_iterator(payload.segments.end()));
+            state->hasPending = true;
+        }
+        if (!state->hasPending || !state->claimDelivery(force, delay)) {
+            return;
+        }
+    }
+    scheduleDelivery(state, delay, queueNewSegmentsDelivery);
+}
+
+void flushNewSegmentsCallback(const std::shared_ptr<SegmentCallbackState> &state) {
+    emitNewSegmentsCallback(state, NewSegmentsData(), true);
+}
+
+void emitStreamSegmentsCallback(
+    const std::shared_ptr<JsiCallbackState> &state,
+    StreamSegmentsData payload) {
     if (!state || !state->callInvoker || !state->callback || !state->runtime) {
         return;
     }
@@ -794,7 +1373,7 @@ void emitNewSegmentsCallback(
             return;
         }
         auto &rt = *state->runtime;
-        state->callback->call(rt, createNewSegmentsValue(rt, payload));
+        state->callback->call(rt, createStreamSegmentsValue(rt, payload));
     });
 }
 
@@ -846,6 +1425,25 @@ std::string getStringProperty(
     return value.isString() ? value.asString(runtime).utf8(runtime) : fallback;
 }
 
+// KV cache type by ggml name ("f16", "q8_0", ...), whisper falls back to f16 for
+// types it can't use as a cache
+wsp_ggml_type getCacheTypeProperty(
+    jsi::Runtime &runtime,
+    const jsi::Object &object,
+    const char *name) {
+    std::string typeName = getStringProperty(runtime, object, name);
+    if (typeName.empty()) {
+        return WSP_GGML_TYPE_F16;
+    }
+    for (int i = 0; i < WSP_GGML_TYPE_COUNT; ++i) {
+        const char *candidate = wsp_ggml_type_name(static_cast<wsp_ggml_type>(i));
+        if (candidate != nullptr && typeName == candidate) {
+            return static_cast<wsp_ggml_type>(i);
+        }
+    }
+    throw jsi::JSError(runtime, std::string("Unknown ") + name + ": " + typeName);
+}
+
 struct TranscribeConfig {
     whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
     std::string prompt;
@@ -853,6 +1451,8 @@ struct TranscribeConfig {
     int nProcessors = 1;
     int jobId = 0;
     bool tdrzEnable = false;
+    bool packedResult = false;
+    int callbackIntervalMs = 50;
     JsiFunctionPtr onProgress;
     JsiFunctionPtr onNewSegments;
 };
@@ -877,6 +1477,10 @@ TranscribeConfig createTranscribeConfig(
         getBoolProperty(runtime, options, "tokenTimestamps", false);
     config.params.tdrz_enable = getBoolProperty(runtime, options, "tdrzEnable", false);
     config.tdrzEnable = config.params.tdrz_enable;
+    config.packedResult = getBoolProperty(runtime, options, "packedResult", false);
+    config.callbackIntervalMs = std::max(
+        0,
+        getIntProperty(runtime, options, "callbackIntervalMs", config.callbackIntervalMs));
     config.params.max_len = getIntProperty(runtime, options, "maxLen", config.params.max_len);
     config.params.n_max_text_ctx =
         getIntProperty(runtime, options, "maxContext", config.params.n_max_text_ctx);
@@ -895,6 +1499,16 @@ TranscribeConfig createTranscribeConfig(
         config.params.temperature_inc);
     config.params.greedy.best_of =
         getIntProperty(runtime, options, "bestOf", config.params.greedy.best_of);
+    config.params.audio_ctx = std::max(
+        0,
+        getIntProperty(runtime, options, "audioCtx", config.params.audio_ctx));
+    config.params.audio_ctx_auto =
+        getBoolProperty(runtime, options, "audioCtxAuto", config.params.audio_ctx_auto);
+    config.params.speculative.n_draft = getIntProperty(
+        runtime,
+        options,
+        "nDraft",
+        config.params.speculative.n_draft);
     config.nProcessors = std::max(1, getIntProperty(runtime, options, "nProcessors", 1));
     config.jobId = getIntProperty(
         runtime,
@@ -938,10 +1552,83 @@ TranscribeConfig createTranscribeConfig(
     return config;
 }
 
+struct WhisperStreamSession {
+    ~WhisperStreamSession() {
+        release();
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(processMutex);
+        if (stream != nullptr) {
+            whisper_stream_free(stream);
+            stream = nullptr;
+        }
+        if (job != nullptr) {
+            rnwhisper::job_remove(config.jobId);
+            job = nullptr;
+        }
+    }
+
+    // Audio is queued in call order on the JS thread. At most one pool task
+    // drains it, a push while that task is queued or running only appends.
+    // Returns true when the caller has to schedule the drain task.
+    bool enqueue(const AudioSamples &audio) {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending.insert(pending.end(), audio.data(), audio.data() + audio.size());
+        if (drainScheduled) {
+            return false;
+        }
+        drainScheduled = true;
+        return true;
+    }
+
+    // Requires processMutex
+    int drain() {
+        std::vector<float> audio;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            audio.swap(pending);
+        }
+        if (audio.empty() || stream == nullptr || job->is_aborted()) {
+            return 0;
+        }
+        return whisper_stream_push_pcm(stream, audio.data(), static_cast<int>(audio.size()));
+    }
+
+    // Body of the drain task, also takes the audio pushed while it runs
+    int drainScheduledAudio() {
+        std::lock_guard<std::mutex> lock(processMutex);
+        for (;;) {
+            int code = drain();
+            std::lock_guard<std::mutex> pendingLock(pendingMutex);
+            if (code != 0 || pending.empty()) {
+                drainScheduled = false;
+                return code;
+            }
+        }
+    }
+
+    void cancelScheduledDrain() {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        drainScheduled = false;
+    }
+
+    whisper_stream *stream = nullptr;
+    rnwhisper::job *job = nullptr;
+    TranscribeConfig config;
+    std::shared_ptr<JsiCallbackState> segmentsState;
+
+    std::mutex pendingMutex;
+    std::vector<float> pending;
+    bool drainScheduled = false;
+    std::mutex processMutex;
+};
+
 struct ParakeetTranscribeConfig {
     parakeet_full_params params =
         parakeet_full_default_params(PARAKEET_SAMPLING_GREEDY);
     int jobId = 0;
+    bool packedResult = false;
 };
 
 ParakeetTranscribeConfig createParakeetTranscribeConfig(
@@ -956,6 +1643,16 @@ ParakeetTranscribeConfig createParakeetTranscribeConfig(
     config.params.audio_ctx =
         getIntProperty(runtime, options, "audioCtx", config.params.audio_ctx);
     config.params.no_context = true;
+
+    int beamSize = getIntProperty(runtime, options, "beamSize", -1);
+    if (beamSize > 1) {
+        config.params.strategy = PARAKEET_SAMPLING_BEAM_SEARCH;
+        config.params.beam_search.beam_size = beamSize;
+    }
+    config.params.n_batch =
+        getIntProperty(runtime, options, "batchSize", config.params.n_batch);
+    config.packedResult = getBoolProperty(runtime, options, "packedResult", false);
+
     config.jobId = getIntProperty(
         runtime,
         options,
@@ -1035,19 +1732,77 @@ std::vector<float> decodePcm16(const uint8_t *bytes, size_t byteLength) {
         throw JsiError("Invalid audio data", -1);
     }
 
-    size_t sampleCount = byteLength / sizeof(int16_t);
-    std::vector<float> audio(sampleCount);
+    std::vector<float> audio(byteLength / sizeof(int16_t));
+    rnwhisper::audio_pcm16_to_f32(bytes, audio.size(), audio.data());
+    return audio;
+}
 
-    for (size_t i = 0; i < sampleCount; ++i) {
-        int16_t sample = 0;
-        std::memcpy(&sample, bytes + (i * sizeof(int16_t)), sizeof(int16_t));
-        audio[i] = std::max(-1.0f, std::min(1.0f, static_cast<float>(sample) / 32767.0f));
+// Read-only view of WAV bytes, either a decoded buffer or a mapped file.
+struct ByteSpan {
+    ByteSpan(const uint8_t *bytes, size_t byteLength)
+        : bytes_(bytes), size_(byteLength) {}
+    ByteSpan(const std::vector<uint8_t> &bytes)
+        : bytes_(bytes.data()), size_(bytes.size()) {}
+
+    const uint8_t *data() const {
+        return bytes_;
     }
 
-    return audio;
-}
+    size_t size() const {
+        return size_;
+    }
+
+    uint8_t operator[](size_t index) const {
+        return bytes_[index];
+    }
+
+private:
+    const uint8_t *bytes_;
+    size_t size_;
+};
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void *mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = static_cast<const uint8_t *>(mapped);
+                size_ = static_cast<size_t>(info.st_size);
+                madvise(mapped, size_, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(const_cast<uint8_t *>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const {
+        return data_;
+    }
 
-uint16_t readUint16LE(const std::vector<uint8_t> &bytes, size_t offset) {
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+uint16_t readUint16LE(const ByteSpan &bytes, size_t offset) {
     if (offset + sizeof(uint16_t) > bytes.size()) {
         throw JsiError("Invalid WAV file", -1);
     }
@@ -1055,7 +1810,7 @@ uint16_t readUint16LE(const std::vector<uint8_t> &bytes, size_t offset) {
         | (static_cast<uint16_t>(bytes[offset + 1]) << 8);
 }
 
-uint32_t readUint32LE(const std::vector<uint8_t> &bytes, size_t offset) {
+uint32_t readUint32LE(const ByteSpan &bytes, size_t offset) {
     if (offset + sizeof(uint32_t) > bytes.size()) {
         throw JsiError("Invalid WAV file", -1);
     }
@@ -1066,7 +1821,7 @@ uint32_t readUint32LE(const std::vector<uint8_t> &bytes, size_t offset) {
 }
 
 bool matchesChunkId(
-    const std::vector<uint8_t> &bytes,
+    const ByteSpan &bytes,
     size_t offset,
     const char (&chunkId)[5]) {
     return offset + 4 <= bytes.size()
@@ -1079,17 +1834,23 @@ struct WaveAudioData {
     uint16_t channels = 0;
     uint32_t sampleRate = 0;
     uint16_t bitsPerSample = 0;
+    rnwhisper::audio_sample_format sampleFormat = rnwhisper::AUDIO_SAMPLE_S16;
 };
 
 constexpr uint16_t kWaveFormatPcm = 1;
+constexpr uint16_t kWaveFormatIeeeFloat = 3;
+constexpr uint16_t kWaveFormatALaw = 6;
+constexpr uint16_t kWaveFormatMuLaw = 7;
 constexpr uint16_t kWaveFormatExtensible = 0xfffe;
 
-bool isPcmSubFormat(
-    const std::vector<uint8_t> &bytes,
+// WAVE_FORMAT_EXTENSIBLE stores the format code in the first two bytes of the
+// sub-format GUID, the rest is the same for all standard formats.
+uint16_t readExtensibleSubFormat(
+    const ByteSpan &bytes,
     size_t fmtDataOffset,
     uint32_t chunkSize) {
-    static constexpr uint8_t kPcmSubFormatGuid[16] = {
-        0x01, 0x00, 0x00, 0x00,
+    static constexpr uint8_t kSubFormatGuidSuffix[14] = {
+        0x00, 0x00,
         0x00, 0x00,
         0x10, 0x00,
         0x80, 0x00,
@@ -1097,15 +1858,46 @@ bool isPcmSubFormat(
     };
 
     constexpr size_t kExtensibleSubFormatOffset = 24;
-    constexpr size_t kExtensibleSubFormatSize = sizeof(kPcmSubFormatGuid);
-    return chunkSize >= kExtensibleSubFormatOffset + kExtensibleSubFormatSize
-        && std::memcmp(
-            bytes.data() + fmtDataOffset + kExtensibleSubFormatOffset,
-            kPcmSubFormatGuid,
-            kExtensibleSubFormatSize) == 0;
+    if (chunkSize < kExtensibleSubFormatOffset + 2 + sizeof(kSubFormatGuidSuffix)
+        || std::memcmp(
+            bytes.data() + fmtDataOffset + kExtensibleSubFormatOffset + 2,
+            kSubFormatGuidSuffix,
+            sizeof(kSubFormatGuidSuffix)) != 0) {
+        return 0;
+    }
+    return readUint16LE(bytes, fmtDataOffset + kExtensibleSubFormatOffset);
+}
+
+bool getWaveSampleFormat(
+    uint16_t audioFormat,
+    uint16_t bitsPerSample,
+    rnwhisper::audio_sample_format &sampleFormat) {
+    switch (audioFormat) {
+        case kWaveFormatPcm:
+            switch (bitsPerSample) {
+                case 8: sampleFormat = rnwhisper::AUDIO_SAMPLE_U8; return true;
+                case 16: sampleFormat = rnwhisper::AUDIO_SAMPLE_S16; return true;
+                case 24: sampleFormat = rnwhisper::AUDIO_SAMPLE_S24; return true;
+                case 32: sampleFormat = rnwhisper::AUDIO_SAMPLE_S32; return true;
+            }
+            return false;
+        case kWaveFormatIeeeFloat:
+            switch (bitsPerSample) {
+                case 32: sampleFormat = rnwhisper::AUDIO_SAMPLE_F32; return true;
+                case 64: sampleFormat = rnwhisper::AUDIO_SAMPLE_F64; return true;
+            }
+            return false;
+        case kWaveFormatALaw:
+            sampleFormat = rnwhisper::AUDIO_SAMPLE_ALAW;
+            return bitsPerSample == 8;
+        case kWaveFormatMuLaw:
+            sampleFormat = rnwhisper::AUDIO_SAMPLE_MULAW;
+            return bitsPerSample == 8;
+    }
+    return false;
 }
 
-WaveAudioData parseWaveAudioData(const std::vector<uint8_t> &bytes) {
+WaveAudioData parseWaveAudioData(const ByteSpan &bytes) {
     if (bytes.size() < 12) {
         throw JsiError("Invalid WAV file", -1);
     }
@@ -1115,7 +1907,7 @@ WaveAudioData parseWaveAudioData(const std::vector<uint8_t> &bytes) {
 
     bool hasFmtChunk = false;
     bool hasDataChunk = false;
-    bool isPcm = false;
+    uint16_t audioFormat = 0;
     WaveAudioData waveData;
     size_t offset = 12;
 
@@ -1139,13 +1931,13 @@ WaveAudioData parseWaveAudioData(const std::vector<uint8_t> &bytes) {
             if (chunkSize < 16) {
                 throw JsiError("Invalid WAV file: malformed fmt chunk", -1);
             }
-            uint16_t audioFormat = readUint16LE(bytes, chunkDataOffset);
+            audioFormat = readUint16LE(bytes, chunkDataOffset);
             waveData.channels = readUint16LE(bytes, chunkDataOffset + 2);
             waveData.sampleRate = readUint32LE(bytes, chunkDataOffset + 4);
             waveData.bitsPerSample = readUint16LE(bytes, chunkDataOffset + 14);
-            isPcm = audioFormat == kWaveFormatPcm
-                || (audioFormat == kWaveFormatExtensible
-                    && isPcmSubFormat(bytes, chunkDataOffset, chunkSize));
+            if (audioFormat == kWaveFormatExtensible) {
+                audioFormat = readExtensibleSubFormat(bytes, chunkDataOffset, chunkSize);
+            }
             hasFmtChunk = true;
         } else if (isDataChunk) {
             waveData.dataOffset = chunkDataOffset;
@@ -1174,8 +1966,13 @@ WaveAudioData parseWaveAudioData(const std::vector<uint8_t> &bytes) {
     if (!hasDataChunk || waveData.dataSize == 0) {
         throw JsiError("Invalid WAV file: missing data chunk", -1);
     }
-    if (!isPcm) {
-        throw JsiError("Unsupported WAV format: only PCM is supported", -1);
+    if (audioFormat != kWaveFormatPcm
+        && audioFormat != kWaveFormatIeeeFloat
+        && audioFormat != kWaveFormatALaw
+        && audioFormat != kWaveFormatMuLaw) {
+        throw JsiError(
+            "Unsupported WAV format: only PCM, IEEE float, A-law and mu-law are supported",
+            -1);
     }
     if (waveData.channels == 0) {
         throw JsiError("Invalid WAV file: channel count must be positive", -1);
@@ -1183,160 +1980,150 @@ WaveAudioData parseWaveAudioData(const std::vector<uint8_t> &bytes) {
     if (waveData.sampleRate == 0) {
         throw JsiError("Invalid WAV file: sample rate must be positive", -1);
     }
-    if (waveData.bitsPerSample != 16) {
-        throw JsiError("Unsupported WAV format: only 16-bit PCM is supported", -1);
+    if (!getWaveSampleFormat(audioFormat, waveData.bitsPerSample, waveData.sampleFormat)) {
+        throw JsiError(
+            "Unsupported WAV format: PCM must be 8, 16, 24 or 32-bit, IEEE float 32 or 64-bit, A-law and mu-law 8-bit",
+            -1);
     }
     return waveData;
 }
 
-std::vector<float> decodeWavePcm16(
-    const uint8_t *bytes,
-    size_t byteLength,
-    uint16_t channels) {
-    if (channels <= 1) {
-        return decodePcm16(bytes, byteLength);
-    }
+// Frames decoded per block, the full-rate audio is never held in memory
+constexpr size_t kWaveDecodeBlockFrames = 1 << 16;
 
-    size_t bytesPerFrame = sizeof(int16_t) * channels;
-    if (byteLength < bytesPerFrame) {
-        throw JsiError("Invalid WAV file: malformed multi-channel PCM data", -1);
+std::vector<float> decodeWaveBytes(const ByteSpan &bytes) {
+    auto waveData = parseWaveAudioData(bytes);
+    size_t bytesPerFrame = rnwhisper::audio_sample_size(waveData.sampleFormat) * waveData.channels;
+    size_t frameCount = waveData.dataSize / bytesPerFrame;
+    if (frameCount == 0) {
+        throw JsiError("Invalid file", -1);
     }
 
-    size_t frameCount = byteLength / bytesPerFrame;
-    std::vector<float> audio(frameCount);
-
-    for (size_t frame = 0; frame < frameCount; ++frame) {
-        float mixed = 0.0f;
-        for (uint16_t channel = 0; channel < channels; ++channel) {
-            int16_t sample = 0;
-            std::memcpy(
-                &sample,
-                bytes + ((frame * channels + channel) * sizeof(int16_t)),
-                sizeof(int16_t));
-            mixed += std::max(
-                -1.0f,
-                std::min(1.0f, static_cast<float>(sample) / 32767.0f));
-        }
-        audio[frame] = mixed / static_cast<float>(channels);
+    std::vector<float> audio;
+    audio.reserve(static_cast<size_t>(
+        (static_cast<uint64_t>(frameCount) * WHISPER_SAMPLE_RATE) / waveData.sampleRate) + 1);
+    rnwhisper::audio_resampler resampler(waveData.sampleRate, WHISPER_SAMPLE_RATE);
+    std::vector<float> block;
+    for (size_t frame = 0; frame < frameCount; frame += kWaveDecodeBlockFrames) {
+        size_t blockFrames = std::min(kWaveDecodeBlockFrames, frameCount - frame);
+        block.resize(blockFrames);
+        rnwhisper::audio_decode_downmix(
+            bytes.data() + waveData.dataOffset + frame * bytesPerFrame,
+            blockFrames,
+            waveData.channels,
+            waveData.sampleFormat,
+            block.data());
+        resampler.push(block.data(), block.size(), audio);
     }
-
+    resampler.finish(audio);
     return audio;
 }
 
-std::vector<float> resampleAudio(
-    const std::vector<float> &audio,
-    uint32_t sourceSampleRate,
-    uint32_t targetSampleRate) {
-    if (audio.empty()) {
-        return {};
-    }
-    if (sourceSampleRate == targetSampleRate) {
-        return audio;
-    }
-    if (sourceSampleRate == 0 || targetSampleRate == 0) {
-        throw JsiError("Invalid WAV file: sample rate must be positive", -1);
-    }
-
-    size_t targetSize = static_cast<size_t>(
-        (static_cast<uint64_t>(audio.size()) * targetSampleRate) / sourceSampleRate);
-    targetSize = std::max<size_t>(1, targetSize);
-    if (targetSize == audio.size()) {
-        return audio;
-    }
-
-    std::vector<float> resampled(targetSize);
-    if (targetSize == 1) {
-        resampled[0] = audio.front();
-        return resampled;
-    }
-
-    double scale = static_cast<double>(audio.size() - 1) / static_cast<double>(targetSize - 1);
-    for (size_t index = 0; index < targetSize; ++index) {
-        double sourceIndex = static_cast<double>(index) * scale;
-        size_t leftIndex = static_cast<size_t>(sourceIndex);
-        size_t rightIndex = std::min(leftIndex + 1, audio.size() - 1);
-        float fraction = static_cast<float>(sourceIndex - static_cast<double>(leftIndex));
-        resampled[index] =
-            audio[leftIndex] + ((audio[rightIndex] - audio[leftIndex]) * fraction);
-    }
-
-    return resampled;
-}
-
-std::vector<float> decodeWaveBytes(const std::vector<uint8_t> &bytes) {
-    auto waveData = parseWaveAudioData(bytes);
-    auto audio = decodeWavePcm16(
-        bytes.data() + waveData.dataOffset,
-        waveData.dataSize,
-        waveData.channels);
-    if (audio.empty()) {
-        throw JsiError("Invalid file", -1);
-    }
-    return resampleAudio(audio, waveData.sampleRate, WHISPER_SAMPLE_RATE);
-}
-
-int decodeBase64Value(char value) {
-    if (value >= 'A' && value <= 'Z') return value - 'A';
-    if (value >= 'a' && value <= 'z') return value - 'a' + 26;
-    if (value >= '0' && value <= '9') return value - '0' + 52;
-    if (value == '+') return 62;
-    if (value == '/') return 63;
-    if (value == '=') return -1;
-    return -2;
+constexpr uint8_t kBase64Pad = 0x40;
+constexpr uint8_t kBase64Skip = 0x80;
+
+// Character -> 6-bit value, kBase64Pad for '=' and kBase64Skip for anything else
+const std::array<uint8_t, 256> &base64DecodeTable() {
+    static const std::array<uint8_t, 256> table = []() {
+        std::array<uint8_t, 256> values;
+        values.fill(kBase64Skip);
+        const char *alphabet =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (uint8_t index = 0; index < 64; ++index) {
+            values[static_cast<uint8_t>(alphabet[index])] = index;
+        }
+        values[static_cast<uint8_t>('=')] = kBase64Pad;
+        return values;
+    }();
+    return table;
 }
 
-std::vector<uint8_t> decodeBase64(const std::string &encoded) {
-    std::vector<uint8_t> decoded;
-    decoded.reserve((encoded.size() * 3) / 4);
+// Decodes until the first '=', characters outside the alphabet (line breaks)
+// are skipped.
+std::vector<uint8_t> decodeBase64(const char *encoded, size_t length) {
+    const auto &table = base64DecodeTable();
+    std::vector<uint8_t> decoded((length / 4) * 3 + 3);
+    uint8_t *out = decoded.data();
 
-    int buffer = 0;
+    uint32_t buffer = 0;
     int bits = 0;
-    for (char ch : encoded) {
-        int value = decodeBase64Value(ch);
-        if (value == -2) {
+    size_t index = 0;
+    while (index < length) {
+        // Whole groups of four alphabet characters
+        if (bits == 0) {
+            for (; index + 4 <= length; index += 4) {
+                uint32_t a = table[static_cast<uint8_t>(encoded[index])];
+                uint32_t b = table[static_cast<uint8_t>(encoded[index + 1])];
+                uint32_t c = table[static_cast<uint8_t>(encoded[index + 2])];
+                uint32_t d = table[static_cast<uint8_t>(encoded[index + 3])];
+                if ((a | b | c | d) & (kBase64Pad | kBase64Skip)) {
+                    break;
+                }
+                uint32_t group = (a << 18) | (b << 12) | (c << 6) | d;
+                out[0] = static_cast<uint8_t>(group >> 16);
+                out[1] = static_cast<uint8_t>(group >> 8);
+                out[2] = static_cast<uint8_t>(group);
+                out += 3;
+            }
+            if (index >= length) {
+                break;
+            }
+        }
+
+        uint8_t value = table[static_cast<uint8_t>(encoded[index++])];
+        if (value == kBase64Skip) {
             continue;
         }
-        if (value == -1) {
+        if (value == kBase64Pad) {
             break;
         }
-
         buffer = (buffer << 6) | value;
         bits += 6;
         if (bits >= 8) {
             bits -= 8;
-            decoded.push_back(static_cast<uint8_t>((buffer >> bits) & 0xff));
+            *out++ = static_cast<uint8_t>((buffer >> bits) & 0xff);
+        }
+        if (bits == 0) {
+            buffer = 0;
         }
     }
 
+    decoded.resize(static_cast<size_t>(out - decoded.data()));
     return decoded;
 }
 
-std::string extractBase64Payload(const std::string &value) {
-    static const std::string prefix = "data:audio/wav;base64,";
-    if (value.rfind(prefix, 0) == 0) {
-        return value.substr(prefix.size());
-    }
-    return value;
-}
+const std::string kWaveBase64Prefix = "data:audio/wav;base64,";
 
 bool isWaveBase64(const std::string &value) {
-    static const std::string prefix = "data:audio/wav;base64,";
-    return value.rfind(prefix, 0) == 0;
+    return value.rfind(kWaveBase64Prefix, 0) == 0;
 }
 
 std::vector<float> readWaveAudio(const std::string &pathOrBase64) {
     if (isWaveBase64(pathOrBase64)) {
-        return decodeWaveBytes(decodeBase64(extractBase64Payload(pathOrBase64)));
+        return decodeWaveBytes(decodeBase64(
+            pathOrBase64.data() + kWaveBase64Prefix.size(),
+            pathOrBase64.size() - kWaveBase64Prefix.size()));
+    }
+    // Plain files are mapped and decoded in place, bundled assets are read
+    std::string localPath = rnwhisper_jsi::hostResolveLocalFilePath(pathOrBase64);
+    if (!localPath.empty()) {
+        MappedFile file(localPath);
+        if (file.data() != nullptr) {
+            return decodeWaveBytes(ByteSpan(file.data(), file.size()));
+        }
     }
     return decodeWaveBytes(rnwhisper_jsi::hostLoadFileBytes(pathOrBase64));
 }
 
 std::vector<SegmentData> readSegments(
     whisper_context *context,
+    whisper_state *state,
     int start,
     bool tdrzEnable,
     std::string *resultText = nullptr) {
-    int count = whisper_full_n_segments(context);
+    int count = state
+        ? whisper_full_n_segments_from_state(state)
+        : whisper_full_n_segments(context);
     std::vector<SegmentData> segments;
     if (count <= start) {
         return segments;
@@ -1344,43 +2131,316 @@ std::vector<SegmentData> readSegments(
 
     segments.reserve(static_cast<size_t>(count - start));
     for (int index = start; index < count; ++index) {
-        std::string text = whisper_full_get_segment_text(context, index);
-        if (tdrzEnable && whisper_full_get_segment_speaker_turn_next(context, index)) {
+        std::string text = state
+            ? whisper_full_get_segment_text_from_state(state, index)
+            : whisper_full_get_segment_text(context, index);
+        bool speakerTurnNext = state
+            ? whisper_full_get_segment_speaker_turn_next_from_state(state, index)
+            : whisper_full_get_segment_speaker_turn_next(context, index);
+        if (tdrzEnable && speakerTurnNext) {
             text += " [SPEAKER_TURN]";
         }
         if (resultText) {
             resultText->append(text);
         }
+        int64_t t0 = state
+            ? whisper_full_get_segment_t0_from_state(state, index)
+            : whisper_full_get_segment_t0(context, index);
+        int64_t t1 = state
+            ? whisper_full_get_segment_t1_from_state(state, index)
+            : whisper_full_get_segment_t1(context, index);
         segments.push_back({
             text,
-            static_cast<int>(whisper_full_get_segment_t0(context, index)),
-            static_cast<int>(whisper_full_get_segment_t1(context, index)),
+            static_cast<int>(t0),
+            static_cast<int>(t1),
         });
     }
 
     return segments;
 }
 
+// Same as readSegments() but into one packed buffer, with the text tokens of
+// every segment. Special and timestamp tokens are skipped.
+std::shared_ptr<PackedResultData> readPackedSegments(
+    whisper_context *context,
+    whisper_state *state,
+    bool tdrzEnable,
+    std::string *resultText) {
+    PackedResultBuilder builder;
+    whisper_token eot = whisper_token_eot(context);
+    int count = state
+        ? whisper_full_n_segments_from_state(state)
+        : whisper_full_n_segments(context);
+    for (int index = 0; index < count; ++index) {
+        int nTokens = state
+            ? whisper_full_n_tokens_from_state(state, index)
+            : whisper_full_n_tokens(context, index);
+        for (int token = 0; token < nTokens; ++token) {
+            whisper_token_data data = state
+                ? whisper_full_get_token_data_from_state(state, index, token)
+                : whisper_full_get_token_data(context, index, token);
+            if (data.id >= eot) {
+                continue;
+            }
+            builder.addToken(data.id, data.t0, data.t1, data.t_dtw, data.p);
+        }
+
+        std::string text = state
+            ? whisper_full_get_segment_text_from_state(state, index)
+            : whisper_full_get_segment_text(context, index);
+        bool speakerTurnNext = state
+            ? whisper_full_get_segment_speaker_turn_next_from_state(state, index)
+            : whisper_full_get_segment_speaker_turn_next(context, index);
+        if (tdrzEnable && speakerTurnNext) {
+            text += " [SPEAKER_TURN]";
+        }
+        builder.addSegment(
+            text,
+            state
+                ? whisper_full_get_segment_t0_from_state(state, index)
+                : whisper_full_get_segment_t0(context, index),
+            state
+                ? whisper_full_get_segment_t1_from_state(state, index)
+                : whisper_full_get_segment_t1(context, index));
+    }
+
+    if (resultText) {
+        *resultText = builder.text();
+    }
+    return builder.finish();
+}
+
 TranscribeResultData buildTranscribeResult(
     whisper_context *context,
+    whisper_state *state,
     bool tdrzEnable,
+    bool packedResult,
     bool isAborted) {
     TranscribeResultData result;
     result.isAborted = isAborted;
-    result.segments = readSegments(context, 0, tdrzEnable, &result.result);
-    const char *language = whisper_lang_str(whisper_full_lang_id(context));
+    if (packedResult) {
+        result.packed = readPackedSegments(context, state, tdrzEnable, &result.result);
+    } else {
+        result.segments = readSegments(context, state, 0, tdrzEnable, &result.result);
+    }
+    int langId = state
+        ? whisper_full_lang_id_from_state(state)
+        : whisper_full_lang_id(context);
+    const char *language = whisper_lang_str(langId);
     result.language = language ? language : "";
     return result;
 }
 
+// Runs a transcription on a state slot reserved by acquireState(), or on the
+// default state (slot 0) when the caller holds the exclusive operation.
+TranscribeResultData runWhisperTranscription(
+    const std::shared_ptr<WhisperContextHolder> &holder,
+    int slot,
+    TranscribeConfig config,
+    const AudioSamples &audio,
+    const std::shared_ptr<react::CallInvoker> &callInvoker,
+    const std::shared_ptr<jsi::Runtime> &runtimePtr) {
+    auto progressState = std::make_shared<ProgressCallbackState>();
+    progressState->callInvoker = callInvoker;
+    progressState->callback = config.onProgress;
+    progressState->runtime = runtimePtr;
+    progressState->contextId = holder->id;
+    progressState->intervalMs = config.callbackIntervalMs;
+    if (config.onProgress) {
+        config.params.progress_callback =
+            [](whisper_context *, whisper_state *, int progress, void *userData) {
+                auto *state = static_cast<std::shared_ptr<ProgressCallbackState> *>(userData);
+                if (!state || !(*state)) {
+                    return;
+                }
+                emitProgressCallback(*state, progress);
+            };
+        config.params.progress_callback_user_data = &progressState;
+    }
+
+    auto segmentsState = std::make_shared<SegmentCallbackState>();
+    segmentsState->callInvoker = callInvoker;
+    segmentsState->callback = config.onNewSegments;
+    segmentsState->runtime = runtimePtr;
+    segmentsState->contextId = holder->id;
+    segmentsState->tdrzEnable = config.tdrzEnable;
+    segmentsState->intervalMs = config.callbackIntervalMs;
+
+    if (config.onNewSegments) {
+        config.params.new_segment_callback =
+            [](whisper_context *ctx, whisper_state *whisperState, int nNew, void *userData) {
+                auto *state = static_cast<std::shared_ptr<SegmentCallbackState> *>(userData);
+                if (!state || !(*state)) {
+                    return;
+                }
+
+                (*state)->totalNNew += nNew;
+                int offset = (*state)->totalNNew - nNew;
+                std::string resultText;
+                auto segments = readSegments(
+                    ctx,
+                    whisperState,
+                    offset,
+                    (*state)->tdrzEnable,
+                    &resultText);
+
+                NewSegmentsData payload;
+                payload.nNew = nNew;
+                payload.totalNNew = (*state)->totalNNew;
+                payload.result = std::move(resultText);
+                payload.segments = std::move(segments);
+
+                emitNewSegmentsCallback(*state, std::move(payload));
+            };
+        config.params.new_segment_callback_user_data = &segmentsState;
+    }
+
+    whisper_state *state = holder->getState(slot);
+    if (slot > 0 && state == nullptr) {
+        throw JsiError("Failed to initialize transcription state");
+    }
+
+    config.params.speculative.draft_ctx = holder->draftContext;
+
+    rnwhisper::job *job = rnwhisper::job_new(config.jobId, config.params);
+    if (job == nullptr) {
+        throw JsiError("Failed to create transcription job");
+    }
+
+    int code = state
+        ? whisper_full_with_state(
+            holder->context,
+            state,
+            job->params,
+            audio.data(),
+            static_cast<int>(audio.size()))
+        : whisper_full_parallel(
+            holder->context,
+            job->params,
+            audio.data(),
+            static_cast<int>(audio.size()),
+            config.nProcessors);
+    bool isAborted = job->is_aborted();
+    rnwhisper::job_remove(config.jobId);
+    flushNewSegmentsCallback(segmentsState);
+    flushProgressCallback(progressState);
+
+    if (code != 0 && !isAborted) {
+        throw JsiError("Transcription failed", code);
+    }
+
+    return buildTranscribeResult(
+        holder->context,
+        state,
+        config.tdrzEnable,
+        config.packedResult,
+        isAborted);
+}
+
+// Transcribes many short clips on one state slot, see rnwhisper::transcribe_batch.
+std::vector<TranscribeResultData> runWhisperBatchTranscription(
+    const std::shared_ptr<WhisperContextHolder> &holder,
+    int slot,
+    TranscribeConfig config,
+    const std::vector<AudioSamples> &clips,
+    const std::shared_ptr<react::CallInvoker> &callInvoker,
+    const std::shared_ptr<jsi::Runtime> &runtimePtr) {
+    auto progressState = std::make_shared<ProgressCallbackState>();
+    progressState->callInvoker = callInvoker;
+    progressState->callback = config.onProgress;
+    progressState->runtime = runtimePtr;
+    progressState->contextId = holder->id;
+    progressState->intervalMs = config.callbackIntervalMs;
+
+    whisper_state *state = holder->getState(slot);
+    if (slot > 0 && state == nullptr) {
+        throw JsiError("Failed to initialize transcription state");
+    }
+
+    config.params.speculative.draft_ctx = holder->draftContext;
+
+    rnwhisper::job *job = rnwhisper::job_new(config.jobId, config.params);
+    if (job == nullptr) {
+        throw JsiError("Failed to create transcription job");
+    }
+
+    std::vector<rnwhisper::batch_clip> batchClips;
+    batchClips.reserve(clips.size());
+    for (const auto &clip : clips) {
+        batchClips.push_back({clip.data(), clip.size()});
+    }
+
+    void (*onProgress)(int, void *) = nullptr;
+    if (config.onProgress) {
+        onProgress = [](int progress, void *userData) {
+            auto *state = static_cast<std::shared_ptr<ProgressCallbackState> *>(userData);
+            emitProgressCallback(*state, progress);
+        };
+    }
+
+    std::vector<rnwhisper::batch_result> batchResults;
+    int code = rnwhisper::transcribe_batch(
+        holder->context,
+        state,
+        job->params,
+        batchClips,
+        batchResults,
+        onProgress,
+        &progressState);
+    bool isAborted = job->is_aborted();
+    rnwhisper::job_remove(config.jobId);
+    flushProgressCallback(progressState);
+
+    if (code != 0 && !isAborted) {
+        throw JsiError("Transcription failed", code);
+    }
+
+    std::vector<TranscribeResultData> results(batchResults.size());
+    for (size_t index = 0; index < batchResults.size(); ++index) {
+        auto &result = results[index];
+        result.isAborted = isAborted;
+        result.language = batchResults[index].language;
+        for (auto &segment : batchResults[index].segments) {
+            result.result += segment.text;
+            result.segments.push_back({
+                std::move(segment.text),
+                static_cast<int>(segment.t0),
+                static_cast<int>(segment.t1),
+            });
+        }
+    }
+    return results;
+}
+
 TranscribeResultData buildParakeetTranscribeResult(
     parakeet_context *context,
+    bool packedResult,
     bool isAborted) {
     TranscribeResultData result;
     result.isAborted = isAborted;
     result.language = "";
 
     int count = parakeet_full_n_segments(context);
+    if (packedResult) {
+        PackedResultBuilder builder;
+        for (int index = 0; index < count; ++index) {
+            int nTokens = parakeet_full_n_tokens(context, index);
+            for (int token = 0; token < nTokens; ++token) {
+                parakeet_token_data data =
+                    parakeet_full_get_token_data(context, index, token);
+                builder.addToken(data.id, data.t0, data.t1, -1, data.p);
+            }
+            const char *segmentText =
+                parakeet_full_get_segment_text(context, index);
+            builder.addSegment(
+                segmentText ? segmentText : "",
+                parakeet_full_get_segment_t0(context, index),
+                parakeet_full_get_segment_t1(context, index));
+        }
+        result.result = builder.text();
+        result.packed = builder.finish();
+        return result;
+    }
     if (count <= 0) {
         return result;
     }
@@ -1432,10 +2492,32 @@ jsi::Value createTranscribeResultValue(
         "result",
         jsi::String::createFromUtf8(runtime, data.result));
     result.setProperty(runtime, "segments", createSegmentsArray(runtime, data.segments));
+    if (data.packed) {
+        jsi::Object packed(runtime);
+        packed.setProperty(
+            runtime,
+            "buffer",
+            jsi::ArrayBuffer(
+                runtime,
+                std::make_shared<PackedResultBuffer>(data.packed)));
+        packed.setProperty(runtime, "nSegments", jsi::Value(data.packed->nSegments));
+        packed.setProperty(runtime, "nTokens", jsi::Value(data.packed->nTokens));
+        result.setProperty(runtime, "packed", packed);
+    }
     result.setProperty(runtime, "isAborted", jsi::Value(data.isAborted));
     return result;
 }
 
+jsi::Value createTranscribeResultsValue(
+    jsi::Runtime &runtime,
+    const std::vector<TranscribeResultData> &results) {
+    jsi::Array array(runtime, results.size());
+    for (size_t index = 0; index < results.size(); ++index) {
+        array.setValueAtIndex(runtime, index, createTranscribeResultValue(runtime, results[index]));
+    }
+    return array;
+}
+
 jsi::Value createNewSegmentsValue(
     jsi::Runtime &runtime,
     const NewSegmentsData &data) {
@@ -1450,6 +2532,15 @@ jsi::Value createNewSegmentsValue(
     return result;
 }
 
+jsi::Value createStreamSegmentsValue(
+    jsi::Runtime &runtime,
+    const StreamSegmentsData &data) {
+    jsi::Object result(runtime);
+    result.setProperty(runtime, "committed", createSegmentsArray(runtime, data.committed));
+    result.setProperty(runtime, "partial", createSegmentsArray(runtime, data.partial));
+    return result;
+}
+
 jsi::Value createVadResultValue(
     jsi::Runtime &runtime,
     const VadResultData &data) {
@@ -1466,6 +2557,25 @@ jsi::Value createVadResultValue(
     return result;
 }
 
+jsi::Value createVadStreamEventsValue(
+    jsi::Runtime &runtime,
+    const std::vector<VadStreamEventData> &events) {
+    jsi::Array result(runtime, events.size());
+    for (size_t index = 0; index < events.size(); ++index) {
+        jsi::Object item(runtime);
+        item.setProperty(
+            runtime,
+            "type",
+            jsi::String::createFromAscii(runtime, events[index].speech ? "start" : "end"));
+        item.setProperty(runtime, "t0", jsi::Value(events[index].t0));
+        if (!events[index].speech) {
+            item.setProperty(runtime, "t1", jsi::Value(events[index].t1));
+        }
+        result.setValueAtIndex(runtime, index, item);
+    }
+    return result;
+}
+
 jsi::Value createContextValue(
     jsi::Runtime &runtime,
     const std::shared_ptr<WhisperContextHolder> &holder) {
@@ -1588,10 +2698,19 @@ bool releaseWhisperHolder(
             holder->id);
         return false;
     }
+    {
+        std::lock_guard<std::mutex> lock(holder->operationMutex);
+        holder->streamSession.reset();
+    }
     if (holder->context != nullptr) {
+        holder->freeStates();
         whisper_free(holder->context);
         holder->context = nullptr;
     }
+    if (holder->draftContext != nullptr) {
+        whisper_free(holder->draftContext);
+        holder->draftContext = nullptr;
+    }
     return true;
 }
 
@@ -1609,6 +2728,10 @@ bool releaseVadHolder(
             holder->id);
         return false;
     }
+    {
+        std::lock_guard<std::mutex> lock(holder->streamMutex);
+        holder->streamSession.reset();
+    }
     if (holder->context != nullptr) {
         whisper_vad_free(holder->context);
         holder->context = nullptr;
@@ -1673,26 +2796,119 @@ std::string requireStringArgument(
     return arguments[index].asString(runtime).utf8(runtime);
 }
 
-std::vector<float> requireAudioBufferArgument(
+std::string getTypedArrayName(jsi::Runtime &runtime, const jsi::Object &object) {
+    auto constructor = object.getProperty(runtime, "constructor");
+    if (!constructor.isObject()) {
+        return "";
+    }
+    auto name = constructor.asObject(runtime).getProperty(runtime, "name");
+    return name.isString() ? name.asString(runtime).utf8(runtime) : "";
+}
+
+// Accepts an ArrayBuffer of 16-bit PCM, an Int16Array or a Float32Array. A
+// Float32Array is not copied: its buffer is pinned until the task releases the
+// samples, so JS must not modify it before the call settles.
+AudioSamples readAudioSamples(
+    jsi::Runtime &runtime,
+    const jsi::Value &value,
+    const std::shared_ptr<react::CallInvoker> &callInvoker) {
+    const char *message = "Audio argument must be an ArrayBuffer, Int16Array or Float32Array";
+    if (!value.isObject()) {
+        throw jsi::JSError(runtime, message);
+    }
+    auto object = value.asObject(runtime);
+    if (object.isArrayBuffer(runtime)) {
+        auto arrayBuffer = object.getArrayBuffer(runtime);
+        return makeAudioSamples(decodePcm16(arrayBuffer.data(runtime), arrayBuffer.size(runtime)));
+    }
+
+    auto typedArrayName = getTypedArrayName(runtime, object);
+    auto bufferValue = object.getProperty(runtime, "buffer");
+    if ((typedArrayName != "Float32Array" && typedArrayName != "Int16Array") ||
+        !bufferValue.isObject() ||
+        !bufferValue.asObject(runtime).isArrayBuffer(runtime)) {
+        throw jsi::JSError(runtime, message);
+    }
+    auto arrayBuffer = bufferValue.asObject(runtime).getArrayBuffer(runtime);
+    size_t byteOffset = static_cast<size_t>(object.getProperty(runtime, "byteOffset").asNumber());
+    size_t byteLength = static_cast<size_t>(object.getProperty(runtime, "byteLength").asNumber());
+    if (byteOffset + byteLength > arrayBuffer.size(runtime)) {
+        throw jsi::JSError(runtime, message);
+    }
+    uint8_t *bytes = arrayBuffer.data(runtime) + byteOffset;
+
+    if (typedArrayName == "Int16Array") {
+        return makeAudioSamples(decodePcm16(bytes, byteLength));
+    }
+    if (byteLength < sizeof(float)) {
+        throw JsiError("Invalid audio data", -1);
+    }
+
+    // Deleted on the JS thread like the callbacks in makeJsiFunction
+    auto *pinned = new jsi::ArrayBuffer(std::move(arrayBuffer));
+    std::weak_ptr<react::CallInvoker> weakInvoker = callInvoker;
+    std::shared_ptr<const void> owner(pinned, [weakInvoker](jsi::ArrayBuffer *ptr) {
+        if (!ptr || g_isShuttingDown.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        auto invoker = weakInvoker.lock();
+        if (!invoker) {
+            return;
+        }
+
+        try {
+            invoker->invokeAsync([ptr]() {
+                delete ptr;
+            });
+        } catch (...) {
+            // Runtime is shutting down; leak rather than delete on a non-JS thread.
+        }
+    });
+
+    AudioSamples result;
+    result.samples = reinterpret_cast<const float *>(bytes);
+    result.count = byteLength / sizeof(float);
+    result.owner = std::move(owner);
+    return result;
+}
+
+AudioSamples requireAudioBufferArgument(
     jsi::Runtime &runtime,
     const jsi::Value *arguments,
     size_t count,
-    size_t index) {
-    if (count <= index || !arguments[index].isObject()) {
-        throw jsi::JSError(runtime, "Audio argument must be an ArrayBuffer");
+    size_t index,
+    const std::shared_ptr<react::CallInvoker> &callInvoker) {
+    if (count <= index) {
+        throw jsi::JSError(runtime, "Audio argument must be an ArrayBuffer, Int16Array or Float32Array");
+    }
+    return readAudioSamples(runtime, arguments[index], callInvoker);
+}
+
+std::vector<AudioSamples> requireAudioClipsArgument(
+    jsi::Runtime &runtime,
+    const jsi::Value *arguments,
+    size_t count,
+    size_t index,
+    const std::shared_ptr<react::CallInvoker> &callInvoker) {
+    if (count <= index || !arguments[index].isObject() ||
+        !arguments[index].asObject(runtime).isArray(runtime)) {
+        throw jsi::JSError(runtime, "Audio clips must be an array");
     }
-    auto object = arguments[index].asObject(runtime);
-    if (!object.isArrayBuffer(runtime)) {
-        throw jsi::JSError(runtime, "Audio argument must be an ArrayBuffer");
+    auto clipsArray = arguments[index].asObject(runtime).asArray(runtime);
+    size_t length = clipsArray.size(runtime);
+    std::vector<AudioSamples> clips;
+    clips.reserve(length);
+    for (size_t clip = 0; clip < length; ++clip) {
+        clips.push_back(readAudioSamples(runtime, clipsArray.getValueAtIndex(runtime, clip), callInvoker));
     }
-    auto arrayBuffer = object.getArrayBuffer(runtime);
-    return decodePcm16(arrayBuffer.data(runtime), arrayBuffer.size(runtime));
+    return clips;
 }
 
 TranscribeResultData runParakeetTranscription(
     const std::shared_ptr<ParakeetContextHolder> &holder,
     ParakeetTranscribeConfig config,
-    const std::vector<float> &audio) {
+    const AudioSamples &audio) {
     config.params.abort_callback = [](void *userData) {
         auto *abortRequested = static_cast<std::atomic<bool> *>(userData);
         return abortRequested &&
@@ -1711,7 +2927,71 @@ TranscribeResultData runParakeetTranscription(
         throw JsiError("Parakeet transcription failed", code);
     }
 
-    return buildParakeetTranscribeResult(holder->context, isAborted);
+    return buildParakeetTranscribeResult(
+        holder->context,
+        config.packedResult,
+        isAborted);
+}
+
+std::vector<TranscribeResultData> runParakeetBatchTranscription(
+    const std::shared_ptr<ParakeetContextHolder> &holder,
+    ParakeetTranscribeConfig config,
+    const std::vector<AudioSamples> &clips) {
+    config.params.abort_callback = [](void *userData) {
+        auto *abortRequested = static_cast<std::atomic<bool> *>(userData);
+        return abortRequested &&
+            abortRequested->load(std::memory_order_relaxed);
+    };
+    config.params.abort_callback_user_data = &holder->abortRequested;
+
+    std::vector<const float *> samples;
+    std::vector<int> nSamples;
+    samples.reserve(clips.size());
+    nSamples.reserve(clips.size());
+    for (const auto &clip : clips) {
+        samples.push_back(clip.data());
+        nSamples.push_back(static_cast<int>(clip.size()));
+    }
+
+    int code = parakeet_full_batch(
+        holder->context,
+        config.params,
+        samples.data(),
+        nSamples.data(),
+        static_cast<int>(clips.size()));
+    bool isAborted = holder->isAborted();
+
+    if (code != 0 && !isAborted) {
+        throw JsiError("Parakeet transcription failed", code);
+    }
+
+    std::vector<TranscribeResultData> results(clips.size());
+    for (auto &result : results) {
+        result.isAborted = isAborted;
+    }
+    if (isAborted) {
+        return results;
+    }
+
+    int segments = parakeet_full_n_segments(holder->context);
+    for (int index = 0; index < segments; ++index) {
+        int clip = parakeet_full_get_segment_utterance(holder->context, index);
+        if (clip < 0 || clip >= static_cast<int>(results.size())) {
+            continue;
+        }
+        const char *segmentText =
+            parakeet_full_get_segment_text(holder->context, index);
+        std::string text = segmentText ? segmentText : "";
+        auto &result = results[static_cast<size_t>(clip)];
+        result.result.append(text);
+        result.segments.push_back({
+            std::move(text),
+            static_cast<int>(parakeet_full_get_segment_t0(holder->context, index)),
+            static_cast<int>(parakeet_full_get_segment_t1(holder->context, index)),
+        });
+    }
+
+    return results;
 }
 
 } // namespace
@@ -1776,20 +3056,50 @@ void installJSIBindings(
             hostOptions.useFlashAttn =
                 getBoolProperty(runtime, options, "useFlashAttn", false);
             hostOptions.useGpu = getBoolProperty(runtime, options, "useGpu", true);
+            hostOptions.useMmap = getBoolProperty(runtime, options, "useMmap", true);
+            hostOptions.cacheTypeK = getCacheTypeProperty(runtime, options, "cacheTypeK");
+            hostOptions.cacheTypeV = getCacheTypeProperty(runtime, options, "cacheTypeV");
+            hostOptions.encoderCacheSize = std::max(
+                0,
+                getIntProperty(runtime, options, "encoderCacheSize", 0));
             hostOptions.useCoreMLIos =
                 getBoolProperty(runtime, options, "useCoreMLIos", true);
             hostOptions.downloadCoreMLAssets =
                 getBoolProperty(runtime, options, "downloadCoreMLAssets", false);
             hostOptions.coreMLAssets = parseCoreMLAssets(runtime, options);
+            int maxConcurrentTranscriptions = std::max(
+                1,
+                getIntProperty(runtime, options, "maxConcurrentTranscriptions", 1));
 
-            return createPromiseTask(runtime, callInvoker, [contextId, hostOptions]() -> PromiseResultGenerator {
+            // The draft model is loaded like the main one, without Core ML
+            WhisperContextInitOptions draftOptions = hostOptions;
+            draftOptions.filePath = getStringProperty(runtime, options, "draftFilePath");
+            draftOptions.useCoreMLIos = false;
+            draftOptions.downloadCoreMLAssets = false;
+            draftOptions.coreMLAssets.clear();
+
+            return createPromiseTask(runtime, callInvoker, [contextId, hostOptions, draftOptions, maxConcurrentTranscriptions]() -> PromiseResultGenerator {
                 auto result = hostInitWhisperContext(hostOptions);
                 if (result.context == nullptr) {
                     LOG_ERROR("whisperInitContext failed to load model contextId=%d", contextId);
                     throw JsiError("Failed to load the model");
                 }
+
+                whisper_context *draftContext = nullptr;
+                if (!draftOptions.filePath.empty()) {
+                    draftContext = hostInitWhisperContext(draftOptions).context;
+                    if (draftContext == nullptr) {
+                        LOG_ERROR("whisperInitContext failed to load draft model contextId=%d", contextId);
+                        whisper_free(result.context);
+                        throw JsiError("Failed to load the draft model");
+                    }
+                }
+
                 if (g_isShuttingDown.load(std::memory_order_relaxed)) {
                     whisper_free(result.context);
+                    if (draftContext != nullptr) {
+                        whisper_free(draftContext);
+                    }
                     return [](jsi::Runtime &) {
                         return jsi::Value::undefined();
                     };
@@ -1797,6 +3107,8 @@ void installJSIBindings(
 
                 auto holder = std::make_shared<WhisperContextHolder>(contextId);
                 holder->context = result.context;
+                holder->draftContext = draftContext;
+                holder->setMaxStates(maxConcurrentTranscriptions);
                 holder->ptr = reinterpret_cast<long>(result.context);
                 holder->gpu = result.gpu;
                 holder->reasonNoGPU = result.reasonNoGPU;
@@ -1903,97 +3215,37 @@ void installJSIBindings(
             auto runtimePtr = std::shared_ptr<jsi::Runtime>(&runtime, [](jsi::Runtime *) {});
 
             auto config = createTranscribeConfig(runtime, options, callInvoker);
-            if (!holder->beginExclusiveOperation(config.jobId)) {
+            int slot = holder->beginTranscription(config.jobId, config.nProcessors);
+            if (slot < 0) {
                 throw jsi::JSError(runtime, "Context is already transcribing");
             }
 
             holder->retainTask();
             try {
-                return createPromiseTask(runtime, callInvoker, [holder, config, input, callInvoker, runtimePtr]() mutable -> PromiseResultGenerator {
+                return createPromiseTask(runtime, callInvoker, [holder, slot, config, input, callInvoker, runtimePtr]() mutable -> PromiseResultGenerator {
                     PromiseScopeGuard taskGuard([holder]() { holder->releaseTask(); });
-                    PromiseScopeGuard exclusiveGuard([holder]() { holder->endExclusiveOperation(); });
+                    PromiseScopeGuard transcriptionGuard([holder, slot, config]() {
+                        holder->endTranscription(slot, config.nProcessors);
+                    });
 
-                    auto audio = readWaveAudio(input);
+                    auto audio = makeAudioSamples(readWaveAudio(input));
                     if (audio.empty()) {
                         throw JsiError("Invalid file");
                     }
 
-                    auto progressState = std::make_shared<JsiCallbackState>();
-                    progressState->callInvoker = callInvoker;
-                    progressState->callback = config.onProgress;
-                    progressState->runtime = runtimePtr;
-                    progressState->contextId = holder->id;
-                    if (config.onProgress) {
-                        config.params.progress_callback =
-                            [](whisper_context *, whisper_state *, int progress, void *userData) {
-                                auto *state = static_cast<std::shared_ptr<JsiCallbackState> *>(userData);
-                                if (!state || !(*state)) {
-                                    return;
-                                }
-                                emitProgressCallback(*state, progress);
-                            };
-                        config.params.progress_callback_user_data = &progressState;
-                    }
-
-                    auto segmentsState = std::make_shared<SegmentCallbackState>();
-                    segmentsState->callInvoker = callInvoker;
-                    segmentsState->callback = config.onNewSegments;
-                    segmentsState->runtime = runtimePtr;
-                    segmentsState->contextId = holder->id;
-                    segmentsState->tdrzEnable = config.tdrzEnable;
-
-                    if (config.onNewSegments) {
-                        config.params.new_segment_callback =
-                            [](whisper_context *ctx, whisper_state *, int nNew, void *userData) {
-                                auto *state = static_cast<std::shared_ptr<SegmentCallbackState> *>(userData);
-                                if (!state || !(*state)) {
-                                    return;
-                                }
-
-                                (*state)->totalNNew += nNew;
-                                int offset = (*state)->totalNNew - nNew;
-                                std::string resultText;
-                                auto segments = readSegments(ctx, offset, (*state)->tdrzEnable, &resultText);
-
-                                NewSegmentsData payload;
-                                payload.nNew = nNew;
-                                payload.totalNNew = (*state)->totalNNew;
-                                payload.result = std::move(resultText);
-                                payload.segments = std::move(segments);
-
-                                emitNewSegmentsCallback(*state, std::move(payload));
-                            };
-                        config.params.new_segment_callback_user_data = &segmentsState;
-                    }
-
-                    rnwhisper::job *job = rnwhisper::job_new(config.jobId, config.params);
-                    if (job == nullptr) {
-                        throw JsiError("Failed to create transcription job");
-                    }
-
-                    int code = whisper_full_parallel(
-                        holder->context,
-                        job->params,
-                        audio.data(),
-                        static_cast<int>(audio.size()),
-                        config.nProcessors);
-                    bool isAborted = job->is_aborted();
-                    rnwhisper::job_remove(config.jobId);
-
-                    if (code != 0 && !isAborted) {
-                        throw JsiError("Transcription failed", code);
-                    }
-
-                    auto result = buildTranscribeResult(
-                        holder->context,
-                        config.tdrzEnable,
-                        isAborted);
+                    auto result = runWhisperTranscription(
+                        holder,
+                        slot,
+                        config,
+                        audio,
+                        callInvoker,
+                        runtimePtr);
                     return [result](jsi::Runtime &rt) {
                         return createTranscribeResultValue(rt, result);
                     };
-                }, contextId);
+                }, contextId, true, {}, TaskPriority::Batch);
             } catch (...) {
-                holder->endExclusiveOperation();
+                holder->endTranscription(slot, config.nProcessors);
                 holder->releaseTask();
                 throw;
             }
@@ -2015,7 +3267,7 @@ void installJSIBindings(
                 count,
                 1,
                 "Transcription options must be an object");
-            auto audio = requireAudioBufferArgument(runtime, arguments, count, 2);
+            auto audio = requireAudioBufferArgument(runtime, arguments, count, 2, callInvoker);
 
             auto holder = g_whisperContexts.get(contextId);
             if (!holder) {
@@ -2024,92 +3276,92 @@ void installJSIBindings(
             auto runtimePtr = std::shared_ptr<jsi::Runtime>(&runtime, [](jsi::Runtime *) {});
 
             auto config = createTranscribeConfig(runtime, options, callInvoker);
-            if (!holder->beginExclusiveOperation(config.jobId)) {
+            int slot = holder->beginTranscription(config.jobId, config.nProcessors);
+            if (slot < 0) {
                 throw jsi::JSError(runtime, "Context is already transcribing");
             }
 
             holder->retainTask();
             try {
-                return createPromiseTask(runtime, callInvoker, [holder, config, audio, callInvoker, runtimePtr]() mutable -> PromiseResultGenerator {
+                return createPromiseTask(runtime, callInvoker, [holder, slot, config, audio = std::move(audio), callInvoker, runtimePtr]() mutable -> PromiseResultGenerator {
                     PromiseScopeGuard taskGuard([holder]() { holder->releaseTask(); });
-                    PromiseScopeGuard exclusiveGuard([holder]() { holder->endExclusiveOperation(); });
-
-                    auto progressState = std::make_shared<JsiCallbackState>();
-                    progressState->callInvoker = callInvoker;
-                    progressState->callback = config.onProgress;
-                    progressState->runtime = runtimePtr;
-                    progressState->contextId = holder->id;
-                    if (config.onProgress) {
-                        config.params.progress_callback =
-                            [](whisper_context *, whisper_state *, int progress, void *userData) {
-                                auto *state = static_cast<std::shared_ptr<JsiCallbackState> *>(userData);
-                                if (!state || !(*state)) {
-                                    return;
-                                }
-                                emitProgressCallback(*state, progress);
-                            };
-                        config.params.progress_callback_user_data = &progressState;
-                    }
-
-                    auto segmentsState = std::make_shared<SegmentCallbackState>();
-                    segmentsState->callInvoker = callInvoker;
-                    segmentsState->callback = config.onNewSegments;
-                    segmentsState->runtime = runtimePtr;
-                    segmentsState->contextId = holder->id;
-                    segmentsState->tdrzEnable = config.tdrzEnable;
-
-                    if (config.onNewSegments) {
-                        config.params.new_segment_callback =
-                            [](whisper_context *ctx, whisper_state *, int nNew, void *userData) {
-                                auto *state = static_cast<std::shared_ptr<SegmentCallbackState> *>(userData);
-                                if (!state || !(*state)) {
-                                    return;
-                                }
-
-                                (*state)->totalNNew += nNew;
-                                int offset = (*state)->totalNNew - nNew;
-                                std::string resultText;
-                                auto segments = readSegments(ctx, offset, (*state)->tdrzEnable, &resultText);
+                    PromiseScopeGuard transcriptionGuard([holder, slot, config]() {
+                        holder->endTranscription(slot, config.nProcessors);
+                    });
 
-                                NewSegmentsData payload;
-                                payload.nNew = nNew;
-                                payload.totalNNew = (*state)->totalNNew;
-                                payload.result = std::move(resultText);
-                                payload.segments = std::move(segments);
+                    auto result = runWhisperTranscription(
+                        holder,
+                        slot,
+                        config,
+                        audio,
+                        callInvoker,
+                        runtimePtr);
+                    return [result](jsi::Runtime &rt) {
+                        return createTranscribeResultValue(rt, result);
+                    };
+                }, contextId, true, {}, TaskPriority::Batch);
+            } catch (...) {
+                holder->endTranscription(slot, config.nProcessors);
+                holder->releaseTask();
+                throw;
+            }
+        });
 
-                                emitNewSegmentsCallback(*state, std::move(payload));
-                            };
-                        config.params.new_segment_callback_user_data = &segmentsState;
-                    }
+    auto transcribeBatch = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "whisperTranscribeBatch"),
+        3,
+        [callInvoker](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            int contextId = requireContextId(runtime, arguments, count);
+            auto options = requireObjectArgument(
+                runtime,
+                arguments,
+                count,
+                1,
+                "Transcription options must be an object");
+            auto clips = requireAudioClipsArgument(runtime, arguments, count, 2, callInvoker);
 
-                    rnwhisper::job *job = rnwhisper::job_new(config.jobId, config.params);
-                    if (job == nullptr) {
-                        throw JsiError("Failed to create transcription job");
-                    }
+            auto holder = g_whisperContexts.get(contextId);
+            if (!holder) {
+                throw jsi::JSError(runtime, "Context not found");
+            }
+            auto runtimePtr = std::shared_ptr<jsi::Runtime>(&runtime, [](jsi::Runtime *) {});
 
-                    int code = whisper_full_parallel(
-                        holder->context,
-                        job->params,
-                        audio.data(),
-                        static_cast<int>(audio.size()),
-                        config.nProcessors);
-                    bool isAborted = job->is_aborted();
-                    rnwhisper::job_remove(config.jobId);
+            auto config = createTranscribeConfig(runtime, options, callInvoker);
+            config.nProcessors = 1;
+            // Every clip runs its own encoder pass, size it to the clip unless disabled
+            config.params.audio_ctx_auto =
+                getBoolProperty(runtime, options, "audioCtxAuto", true);
+            int slot = holder->beginTranscription(config.jobId, config.nProcessors);
+            if (slot < 0) {
+                throw jsi::JSError(runtime, "Context is already transcribing");
+            }
 
-                    if (code != 0 && !isAborted) {
-                        throw JsiError("Transcription failed", code);
-                    }
+            holder->retainTask();
+            try {
+                return createPromiseTask(runtime, callInvoker, [holder, slot, config, clips = std::move(clips), callInvoker, runtimePtr]() mutable -> PromiseResultGenerator {
+                    PromiseScopeGuard taskGuard([holder]() { holder->releaseTask(); });
+                    PromiseScopeGuard transcriptionGuard([holder, slot, config]() {
+                        holder->endTranscription(slot, config.nProcessors);
+                    });
 
-                    auto result = buildTranscribeResult(
-                        holder->context,
-                        config.tdrzEnable,
-                        isAborted);
-                    return [result](jsi::Runtime &rt) {
-                        return createTranscribeResultValue(rt, result);
+                    auto results = runWhisperBatchTranscription(
+                        holder,
+                        slot,
+                        config,
+                        clips,
+                        callInvoker,
+                        runtimePtr);
+                    return [results](jsi::Runtime &rt) {
+                        return createTranscribeResultsValue(rt, results);
                     };
-                }, contextId);
+                }, contextId, true, {}, TaskPriority::Batch);
             } catch (...) {
-                holder->endExclusiveOperation();
+                holder->endTranscription(slot, config.nProcessors);
                 holder->releaseTask();
                 throw;
             }
@@ -2144,6 +3396,218 @@ void installJSIBindings(
             }, contextId);
         });
 
+    auto streamStart = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "whisperStreamStart"),
+        2,
+        [callInvoker](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            int contextId = requireContextId(runtime, arguments, count);
+            auto options = requireObjectArgument(
+                runtime,
+                arguments,
+                count,
+                1,
+                "Stream options must be an object");
+
+            auto holder = g_whisperContexts.get(contextId);
+            if (!holder) {
+                throw jsi::JSError(runtime, "Context not found");
+            }
+            auto runtimePtr = std::shared_ptr<jsi::Runtime>(&runtime, [](jsi::Runtime *) {});
+
+            auto session = std::make_shared<WhisperStreamSession>();
+            session->config = createTranscribeConfig(runtime, options, callInvoker);
+            // Strings referenced by params must point into the session's own copy
+            auto &config = session->config;
+            config.params.initial_prompt = config.prompt.empty() ? nullptr : config.prompt.c_str();
+            config.params.language = config.language.empty() ? "en" : config.language.c_str();
+
+            whisper_stream_params streamParams = whisper_stream_default_params();
+            streamParams.step_ms = getIntProperty(runtime, options, "stepMs", streamParams.step_ms);
+            streamParams.length_ms = getIntProperty(runtime, options, "lengthMs", streamParams.length_ms);
+
+            session->segmentsState = std::make_shared<JsiCallbackState>();
+            session->segmentsState->callInvoker = callInvoker;
+            session->segmentsState->runtime = runtimePtr;
+            session->segmentsState->contextId = contextId;
+            if (options.hasProperty(runtime, "onSegments")) {
+                session->segmentsState->callback = makeJsiFunction(
+                    runtime,
+                    options.getProperty(runtime, "onSegments"),
+                    callInvoker);
+            }
+            if (session->segmentsState->callback) {
+                streamParams.segments_callback =
+                    [](whisper_stream *, const whisper_stream_segment *segments, int nSegments, void *userData) {
+                        auto *state = static_cast<std::shared_ptr<JsiCallbackState> *>(userData);
+                        if (!state || !(*state)) {
+                            return;
+                        }
+                        StreamSegmentsData payload;
+                        for (int index = 0; index < nSegments; ++index) {
+                            auto &target = segments[index].committed ? payload.committed : payload.partial;
+                            target.push_back({
+                                segments[index].text,
+                                static_cast<int>(segments[index].t0),
+                                static_cast<int>(segments[index].t1),
+                            });
+                        }
+                        emitStreamSegmentsCallback(*state, std::move(payload));
+                    };
+                streamParams.segments_callback_user_data = &session->segmentsState;
+            }
+
+            if (!holder->beginExclusiveOperation(config.jobId)) {
+                throw jsi::JSError(runtime, "Context is already transcribing");
+            }
+
+            session->job = rnwhisper::job_new(config.jobId, config.params);
+            if (session->job != nullptr) {
+                session->stream = whisper_stream_init(holder->context, session->job->params, streamParams);
+            }
+            if (session->stream == nullptr) {
+                session->release();
+                holder->endExclusiveOperation();
+                throw jsi::JSError(runtime, "Failed to start stream");
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(holder->operationMutex);
+                holder->streamSession = session;
+            }
+            return createResolvedPromise(runtime);
+        });
+
+    auto streamPush = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "whisperStreamPush"),
+        2,
+        [callInvoker](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            int contextId = requireContextId(runtime, arguments, count);
+            auto audio = requireAudioBufferArgument(runtime, arguments, count, 1, callInvoker);
+
+            auto holder = g_whisperContexts.get(contextId);
+            if (!holder) {
+                throw jsi::JSError(runtime, "Context not found");
+            }
+            std::shared_ptr<WhisperStreamSession> session;
+            {
+                std::lock_guard<std::mutex> lock(holder->operationMutex);
+                session = holder->streamSession;
+            }
+            if (!session) {
+                throw jsi::JSError(runtime, "Stream not started");
+            }
+            // The task already draining the stream also processes this audio
+            if (!session->enqueue(audio)) {
+                return createResolvedPromise(runtime);
+            }
+
+            holder->retainTask();
+            try {
+                return createPromiseTask(runtime, callInvoker, [holder, session]() -> PromiseResultGenerator {
+                    PromiseScopeGuard taskGuard([holder]() { holder->releaseTask(); });
+
+                    int code = session->drainScheduledAudio();
+                    if (code != 0 && !session->job->is_aborted()) {
+                        throw JsiError("Transcription failed", code);
+                    }
+                    return [](jsi::Runtime &) {
+                        return jsi::Value::undefined();
+                    };
+                }, contextId, true, [session]() {
+                    session->cancelScheduledDrain();
+                }, TaskPriority::Realtime);
+            } catch (...) {
+                session->cancelScheduledDrain();
+                holder->releaseTask();
+                throw;
+            }
+        });
+
+    auto streamFlush = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "whisperStreamFlush"),
+        1,
+        [callInvoker](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            int contextId = requireContextId(runtime, arguments, count);
+
+            auto holder = g_whisperContexts.get(contextId);
+            if (!holder) {
+                throw jsi::JSError(runtime, "Context not found");
+            }
+            std::shared_ptr<WhisperStreamSession> session;
+            {
+                std::lock_guard<std::mutex> lock(holder->operationMutex);
+                session = std::move(holder->streamSession);
+            }
+            if (!session) {
+                throw jsi::JSError(runtime, "Stream not started");
+            }
+
+            holder->retainTask();
+            try {
+                return createPromiseTask(runtime, callInvoker, [holder, session]() -> PromiseResultGenerator {
+                    PromiseScopeGuard taskGuard([holder]() { holder->releaseTask(); });
+                    PromiseScopeGuard exclusiveGuard([holder, session]() {
+                        session->release();
+                        holder->endExclusiveOperation();
+                    });
+
+                    TranscribeResultData result;
+                    {
+                        std::lock_guard<std::mutex> lock(session->processMutex);
+                        int code = session->drain();
+                        if (code == 0 && !session->job->is_aborted()) {
+                            code = whisper_stream_flush(session->stream);
+                        }
+                        result.isAborted = session->job->is_aborted();
+                        if (code != 0 && !result.isAborted) {
+                            throw JsiError("Transcription failed", code);
+                        }
+
+                        int nSegments = whisper_stream_n_segments(session->stream);
+                        result.segments.reserve(static_cast<size_t>(nSegments));
+                        for (int index = 0; index < nSegments; ++index) {
+                            std::string text = whisper_stream_get_segment_text(session->stream, index);
+                            result.result.append(text);
+                            result.segments.push_back({
+                                std::move(text),
+                                static_cast<int>(whisper_stream_get_segment_t0(session->stream, index)),
+                                static_cast<int>(whisper_stream_get_segment_t1(session->stream, index)),
+                            });
+                        }
+                        const char *language = whisper_lang_str(whisper_full_lang_id(holder->context));
+                        result.language = language ? language : "";
+                    }
+
+                    return [result](jsi::Runtime &rt) {
+                        return createTranscribeResultValue(rt, result);
+                    };
+                }, contextId, true, [holder, session]() {
+                    session->release();
+                    holder->endExclusiveOperation();
+                }, TaskPriority::Realtime);
+            } catch (...) {
+                session->release();
+                holder->endExclusiveOperation();
+                holder->releaseTask();
+                throw;
+            }
+        });
+
     auto bench = jsi::Function::createFromHostFunction(
         runtime,
         jsi::PropNameID::forAscii(runtime, "whisperBench"),
@@ -2178,7 +3642,7 @@ void installJSIBindings(
                     return [result](jsi::Runtime &rt) {
                         return jsi::String::createFromUtf8(rt, result);
                     };
-                }, contextId);
+                }, contextId, true, {}, TaskPriority::Batch);
             } catch (...) {
                 holder->endExclusiveOperation();
                 holder->releaseTask();
@@ -2208,6 +3672,7 @@ void installJSIBindings(
             hostOptions.isBundleAsset =
                 getBoolProperty(runtime, options, "isBundleAsset", false);
             hostOptions.useGpu = getBoolProperty(runtime, options, "useGpu", true);
+            hostOptions.useMmap = getBoolProperty(runtime, options, "useMmap", true);
 
             auto initFinished = std::make_shared<std::atomic<bool>>(false);
             g_parakeetPendingInitTasks.fetch_add(1);
@@ -2356,7 +3821,7 @@ void installJSIBindings(
                 return createPromiseTask(runtime, callInvoker, [holder, config, input, finishOperation]() mutable -> PromiseResultGenerator {
                     PromiseScopeGuard exclusiveGuard(finishOperation);
 
-                    auto audio = readWaveAudio(input);
+                    auto audio = makeAudioSamples(readWaveAudio(input));
                     if (audio.empty()) {
                         throw JsiError("Invalid file");
                     }
@@ -2364,7 +3829,7 @@ void installJSIBindings(
                     return [result](jsi::Runtime &rt) {
                         return createTranscribeResultValue(rt, result);
                     };
-                }, contextId, true, finishOperation);
+                }, contextId, true, finishOperation, TaskPriority::Batch);
             } catch (...) {
                 finishOperation();
                 throw;
@@ -2387,7 +3852,7 @@ void installJSIBindings(
                 count,
                 1,
                 "Parakeet transcription options must be an object");
-            auto audio = requireAudioBufferArgument(runtime, arguments, count, 2);
+            auto audio = requireAudioBufferArgument(runtime, arguments, count, 2, callInvoker);
 
             auto holder = g_parakeetContexts.get(contextId);
             if (!holder) {
@@ -2409,7 +3874,7 @@ void installJSIBindings(
             }
 
             try {
-                return createPromiseTask(runtime, callInvoker, [holder, config, audio, finishOperation]() mutable -> PromiseResultGenerator {
+                return createPromiseTask(runtime, callInvoker, [holder, config, audio = std::move(audio), finishOperation]() mutable -> PromiseResultGenerator {
                     PromiseScopeGuard exclusiveGuard(finishOperation);
 
                     auto result = runParakeetTranscription(holder, config, audio);
@@ -2423,6 +3888,58 @@ void installJSIBindings(
             }
         });
 
+    auto parakeetTranscribeBatch = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "parakeetTranscribeBatch"),
+        3,
+        [callInvoker](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            int contextId = requireContextId(runtime, arguments, count);
+            auto options = requireObjectArgument(
+                runtime,
+                arguments,
+                count,
+                1,
+                "Parakeet transcription options must be an object");
+            auto clips = requireAudioClipsArgument(runtime, arguments, count, 2, callInvoker);
+
+            auto holder = g_parakeetContexts.get(contextId);
+            if (!holder) {
+                throw jsi::JSError(runtime, "Parakeet context not found");
+            }
+            auto config = createParakeetTranscribeConfig(runtime, options);
+            auto operationFinished = std::make_shared<std::atomic<bool>>(false);
+            auto finishOperation = [holder, operationFinished]() {
+                bool expected = false;
+                if (operationFinished->compare_exchange_strong(
+                        expected,
+                        true,
+                        std::memory_order_relaxed)) {
+                    holder->endExclusiveOperation();
+                }
+            };
+            if (!holder->beginExclusiveOperation(config.jobId)) {
+                throw jsi::JSError(runtime, "Parakeet context is already transcribing");
+            }
+
+            try {
+                return createPromiseTask(runtime, callInvoker, [holder, config, clips = std::move(clips), finishOperation]() mutable -> PromiseResultGenerator {
+                    PromiseScopeGuard exclusiveGuard(finishOperation);
+
+                    auto results = runParakeetBatchTranscription(holder, config, clips);
+                    return [results](jsi::Runtime &rt) {
+                        return createTranscribeResultsValue(rt, results);
+                    };
+                }, contextId, true, finishOperation, TaskPriority::Batch);
+            } catch (...) {
+                finishOperation();
+                throw;
+            }
+        });
+
     auto abortParakeetTranscribe = jsi::Function::createFromHostFunction(
         runtime,
         jsi::PropNameID::forAscii(runtime, "parakeetAbortTranscribe"),
@@ -2562,17 +4079,20 @@ void installJSIBindings(
                 count,
                 1,
                 "VAD options must be an object");
-            auto audio = requireAudioBufferArgument(runtime, arguments, count, 2);
+            auto audio = requireAudioBufferArgument(runtime, arguments, count, 2, callInvoker);
 
             auto holder = g_vadContexts.get(contextId);
             if (!holder) {
                 throw jsi::JSError(runtime, "VAD context not found");
             }
+            if (holder->getStreamSession()) {
+                throw jsi::JSError(runtime, "VAD stream is active");
+            }
 
             auto vadOptions = createVadParams(runtime, options);
             holder->retainTask();
             try {
-                return createPromiseTask(runtime, callInvoker, [holder, audio, vadOptions]() -> PromiseResultGenerator {
+                return createPromiseTask(runtime, callInvoker, [holder, audio = std::move(audio), vadOptions]() -> PromiseResultGenerator {
                     PromiseScopeGuard taskGuard([holder]() { holder->releaseTask(); });
 
                     bool detected = whisper_vad_detect_speech(
@@ -2603,7 +4123,7 @@ void installJSIBindings(
                     return [result](jsi::Runtime &rt) {
                         return createVadResultValue(rt, result);
                     };
-                }, contextId);
+                }, contextId, true, {}, TaskPriority::Realtime);
             } catch (...) {
                 holder->releaseTask();
                 throw;
@@ -2637,6 +4157,9 @@ void installJSIBindings(
             if (!holder) {
                 throw jsi::JSError(runtime, "VAD context not found");
             }
+            if (holder->getStreamSession()) {
+                throw jsi::JSError(runtime, "VAD stream is active");
+            }
 
             auto vadOptions = createVadParams(runtime, options);
             holder->retainTask();
@@ -2673,13 +4196,170 @@ void installJSIBindings(
                     return [result](jsi::Runtime &rt) {
                         return createVadResultValue(rt, result);
                     };
-                }, contextId);
+                }, contextId, true, {}, TaskPriority::Batch);
             } catch (...) {
                 holder->releaseTask();
                 throw;
             }
         });
 
+    auto vadStreamStart = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "whisperVadStreamStart"),
+        2,
+        [](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            int contextId = requireContextId(runtime, arguments, count);
+            auto options = requireObjectArgument(
+                runtime,
+                arguments,
+                count,
+                1,
+                "VAD options must be an object");
+
+            auto holder = g_vadContexts.get(contextId);
+            if (!holder) {
+                throw jsi::JSError(runtime, "VAD context not found");
+            }
+
+            auto vadOptions = createVadParams(runtime, options);
+            std::lock_guard<std::mutex> lock(holder->streamMutex);
+            if (holder->streamSession) {
+                throw jsi::JSError(runtime, "VAD stream is already active");
+            }
+
+            auto session = std::make_shared<WhisperVadStreamSession>();
+            session->stream = whisper_vad_stream_init(holder->context, vadOptions);
+            if (session->stream == nullptr) {
+                throw jsi::JSError(runtime, "Failed to start VAD stream");
+            }
+            holder->streamSession = session;
+            return createResolvedPromise(runtime);
+        });
+
+    auto vadStreamPush = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "whisperVadStreamPush"),
+        2,
+        [callInvoker](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            int contextId = requireContextId(runtime, arguments, count);
+            auto audio = requireAudioBufferArgument(runtime, arguments, count, 1, callInvoker);
+
+            auto holder = g_vadContexts.get(contextId);
+            if (!holder) {
+                throw jsi::JSError(runtime, "VAD context not found");
+            }
+            auto session = holder->getStreamSession();
+            if (!session) {
+                throw jsi::JSError(runtime, "VAD stream not started");
+            }
+            // The task already draining the stream reports the events of this audio
+            if (!session->enqueue(audio)) {
+                return createResolvedPromise(runtime, createVadStreamEventsValue(runtime, {}));
+            }
+
+            holder->retainTask();
+            try {
+                return createPromiseTask(runtime, callInvoker, [holder, session]() -> PromiseResultGenerator {
+                    PromiseScopeGuard taskGuard([holder]() { holder->releaseTask(); });
+
+                    std::vector<VadStreamEventData> events;
+                    int code = session->drainScheduledAudio(events);
+                    if (code < 0) {
+                        throw JsiError("VAD detection failed", code);
+                    }
+
+                    return [events](jsi::Runtime &rt) {
+                        return createVadStreamEventsValue(rt, events);
+                    };
+                }, contextId, true, [session]() {
+                    session->cancelScheduledDrain();
+                }, TaskPriority::Realtime);
+            } catch (...) {
+                session->cancelScheduledDrain();
+                holder->releaseTask();
+                throw;
+            }
+        });
+
+    auto vadStreamFlush = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "whisperVadStreamFlush"),
+        1,
+        [callInvoker](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            int contextId = requireContextId(runtime, arguments, count);
+
+            auto holder = g_vadContexts.get(contextId);
+            if (!holder) {
+                throw jsi::JSError(runtime, "VAD context not found");
+            }
+            std::shared_ptr<WhisperVadStreamSession> session;
+            {
+                std::lock_guard<std::mutex> lock(holder->streamMutex);
+                session = std::move(holder->streamSession);
+            }
+            if (!session) {
+                throw jsi::JSError(runtime, "VAD stream not started");
+            }
+
+            holder->retainTask();
+            try {
+                return createPromiseTask(runtime, callInvoker, [holder, session]() -> PromiseResultGenerator {
+                    PromiseScopeGuard taskGuard([holder]() { holder->releaseTask(); });
+                    PromiseScopeGuard sessionGuard([session]() { session->release(); });
+
+                    std::vector<VadStreamEventData> events;
+                    {
+                        std::lock_guard<std::mutex> lock(session->processMutex);
+                        int code = session->drain();
+                        if (code >= 0) {
+                            events = session->events();
+                            code = whisper_vad_stream_flush(session->stream);
+                        }
+                        if (code < 0) {
+                            throw JsiError("VAD detection failed", code);
+                        }
+                        auto flushed = session->events();
+                        events.insert(events.end(), flushed.begin(), flushed.end());
+                    }
+
+                    return [events](jsi::Runtime &rt) {
+                        return createVadStreamEventsValue(rt, events);
+                    };
+                }, contextId, true, {}, TaskPriority::Realtime);
+            } catch (...) {
+                holder->releaseTask();
+                throw;
+            }
+        });
+
+    auto setWorkerCount = jsi::Function::createFromHostFunction(
+        runtime,
+        jsi::PropNameID::forAscii(runtime, "whisperSetWorkerCount"),
+        1,
+        [](
+            jsi::Runtime &runtime,
+            const jsi::Value &,
+            const jsi::Value *arguments,
+            size_t count) -> jsi::Value {
+            if (count < 1 || !arguments[0].isNumber() || arguments[0].asNumber() < 0) {
+                throw jsi::JSError(runtime, "Worker count must be a non-negative number");
+            }
+            getThreadPool().setThreadCount(static_cast<size_t>(arguments[0].asNumber()));
+            return createResolvedPromise(runtime);
+        });
+
     auto toggleNativeLog = jsi::Function::createFromHostFunction(
         runtime,
         jsi::PropNameID::forAscii(runtime, "whisperToggleNativeLog"),
@@ -2719,19 +4399,28 @@ void installJSIBindings(
     runtime.global().setProperty(runtime, "whisperReleaseAllContexts", std::move(releaseAllContexts));
     runtime.global().setProperty(runtime, "whisperTranscribeFile", std::move(transcribeFile));
     runtime.global().setProperty(runtime, "whisperTranscribeData", std::move(transcribeData));
+    runtime.global().setProperty(runtime, "whisperTranscribeBatch", std::move(transcribeBatch));
     runtime.global().setProperty(runtime, "whisperAbortTranscribe", std::move(abortTranscribe));
+    runtime.global().setProperty(runtime, "whisperStreamStart", std::move(streamStart));
+    runtime.global().setProperty(runtime, "whisperStreamPush", std::move(streamPush));
+    runtime.global().setProperty(runtime, "whisperStreamFlush", std::move(streamFlush));
     runtime.global().setProperty(runtime, "whisperBench", std::move(bench));
     runtime.global().setProperty(runtime, "parakeetInitContext", std::move(initParakeetContext));
     runtime.global().setProperty(runtime, "parakeetReleaseContext", std::move(releaseParakeetContext));
     runtime.global().setProperty(runtime, "parakeetReleaseAllContexts", std::move(releaseAllParakeetContexts));
     runtime.global().setProperty(runtime, "parakeetTranscribeFile", std::move(parakeetTranscribeFile));
     runtime.global().setProperty(runtime, "parakeetTranscribeData", std::move(parakeetTranscribeData));
+    runtime.global().setProperty(runtime, "parakeetTranscribeBatch", std::move(parakeetTranscribeBatch));
     runtime.global().setProperty(runtime, "parakeetAbortTranscribe", std::move(abortParakeetTranscribe));
     runtime.global().setProperty(runtime, "whisperInitVadContext", std::move(initVadContext));
     runtime.global().setProperty(runtime, "whisperReleaseVadContext", std::move(releaseVadContext));
     runtime.global().setProperty(runtime, "whisperReleaseAllVadContexts", std::move(releaseAllVadContexts));
     runtime.global().setProperty(runtime, "whisperVadDetectSpeech", std::move(vadDetectSpeech));
     runtime.global().setProperty(runtime, "whisperVadDetectSpeechFile", std::move(vadDetectSpeechFile));
+    runtime.global().setProperty(runtime, "whisperVadStreamStart", std::move(vadStreamStart));
+    runtime.global().setProperty(runtime, "whisperVadStreamPush", std::move(vadStreamPush));
+    runtime.global().setProperty(runtime, "whisperVadStreamFlush", std::move(vadStreamFlush));
+    runtime.global().setProperty(runtime, "whisperSetWorkerCount", std::move(setWorkerCount));
     runtime.global().setProperty(runtime, "whisperToggleNativeLog", std::move(toggleNativeLog));
 }
 
@@ -2739,6 +4428,7 @@ void cleanupJSIBindings() {
     wsp_ggml_set_abort_callback(nullptr);
     g_isShuttingDown.store(true, std::memory_order_relaxed);
     TaskManager::getInstance().beginShutdown();
+    DeliveryTimer::getInstance().shutdown();
 
     {
         std::lock_guard<std::mutex> lock(g_logMutex);
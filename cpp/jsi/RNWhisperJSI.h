@@ -36,6 +36,10 @@ struct WhisperContextInitOptions {
     bool isBundleAsset = false;
     bool useFlashAttn = false;
     bool useGpu = true;
+    bool useMmap = true;
+    wsp_ggml_type cacheTypeK = WSP_GGML_TYPE_F16;
+    wsp_ggml_type cacheTypeV = WSP_GGML_TYPE_F16;
+    int encoderCacheSize = 0;
     bool useCoreMLIos = true;
     bool downloadCoreMLAssets = false;
     std::vector<CoreMLAssetInfo> coreMLAssets;
@@ -64,6 +68,7 @@ struct ParakeetContextInitOptions {
     std::string filePath;
     bool isBundleAsset = false;
     bool useGpu = true;
+    bool useMmap = true;
 };
 
 struct ParakeetContextInitResult {
@@ -79,6 +84,8 @@ WhisperVadContextInitResult hostInitWhisperVadContext(
 ParakeetContextInitResult hostInitParakeetContext(
     const ParakeetContextInitOptions &options);
 std::vector<uint8_t> hostLoadFileBytes(const std::string &path);
+// Local file path for `path` (downloading remote URLs), empty for bundled assets
+std::string hostResolveLocalFilePath(const std::string &path);
 void hostClearCache();
 
 #if defined(__ANDROID__)
@@ -2,16 +2,30 @@
 #define THREAD_POOL_H
 
 #include <algorithm>
+#include <array>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <system_error>
 #include <thread>
 #include <utility>
 #include <vector>
 
+// Tasks of a higher priority are always started first. Batch tasks (file
+// transcriptions, bench) never occupy the last free worker, whatever the other
+// workers run, so realtime work queued behind them still gets a thread.
+enum class TaskPriority {
+    Realtime = 0,
+    Normal = 1,
+    Batch = 2,
+};
+
+// Each worker has its own queues, tasks with the same key (context id) go to the
+// same queue. The queue only sets the preferred worker: for the highest runnable
+// priority, an idle worker takes the front task of its own queue, then of the
+// other queues in index order. Tasks are FIFO per queue, not across queues.
 class ThreadPool {
 public:
     static ThreadPool &getInstance() {
@@ -22,13 +36,24 @@ public:
     void ensureRunning();
     void shutdown();
 
+    // Number of workers, 0 for the default. More workers are started right away,
+    // fewer take effect the next time the pool starts.
+    void setThreadCount(size_t threads);
+    size_t threadCount();
+
     template <class F>
-    void enqueue(F &&f);
+    void enqueue(F &&f, TaskPriority priority = TaskPriority::Normal, int key = -1);
 
     ~ThreadPool();
 
 private:
-    ThreadPool(size_t threads = defaultThreadCount());
+    static constexpr size_t kPriorityCount = 3;
+
+    struct WorkerQueue {
+        std::array<std::deque<std::function<void()>>, kPriorityCount> tasks;
+    };
+
+    ThreadPool() = default;
     ThreadPool(const ThreadPool &) = delete;
     ThreadPool &operator=(const ThreadPool &) = delete;
 
@@ -38,46 +63,114 @@ private:
     }
 
     void startWorkers(size_t threads);
+    void workerLoop(size_t index);
+
+    // Requires queue_mutex
+    bool canRun(size_t priority) const;
+    bool hasRunnableTask() const;
+    bool takeTask(size_t index, std::function<void()> &task, size_t &priority);
 
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    std::vector<WorkerQueue> queues;
+    size_t pending = 0;
+    size_t running = 0;
+    size_t nextQueue = 0;
+    size_t configuredThreads = 0;
     std::mutex queue_mutex;
     std::mutex shutdown_mutex;
     std::condition_variable condition;
-    bool stop;
+    bool stop = false;
 };
 
-inline ThreadPool::ThreadPool(size_t threads)
-    : stop(false) {
-    startWorkers(threads);
-}
-
 inline void ThreadPool::startWorkers(size_t threads) {
     if (threads == 0) {
         threads = 1;
     }
 
-    for (size_t i = 0; i < threads; ++i) {
-        workers.emplace_back([this] {
-            for (;;) {
-                std::function<void()> task;
+    const size_t first = workers.size();
+    queues.resize(first + threads);
+    for (size_t i = first; i < first + threads; ++i) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
 
-                {
-                    std::unique_lock<std::mutex> lock(this->queue_mutex);
-                    this->condition.wait(lock, [this] {
-                        return this->stop || !this->tasks.empty();
-                    });
-                    if (this->stop && this->tasks.empty()) {
-                        return;
-                    }
+inline bool ThreadPool::canRun(size_t priority) const {
+    if (priority != static_cast<size_t>(TaskPriority::Batch) || stop) {
+        return true;
+    }
+    return workers.size() < 2 || running + 1 < workers.size();
+}
 
-                    task = std::move(this->tasks.front());
-                    this->tasks.pop();
-                }
+inline bool ThreadPool::hasRunnableTask() const {
+    for (size_t priority = 0; priority < kPriorityCount; ++priority) {
+        if (!canRun(priority)) {
+            continue;
+        }
+        for (const auto &queue : queues) {
+            if (!queue.tasks[priority].empty()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+inline bool ThreadPool::takeTask(size_t index, std::function<void()> &task, size_t &priority) {
+    for (priority = 0; priority < kPriorityCount; ++priority) {
+        if (!canRun(priority)) {
+            continue;
+        }
+        // Own queue first, then steal from the others
+        for (size_t offset = 0; offset < queues.size(); ++offset) {
+            auto &tasks = queues[(index + offset) % queues.size()].tasks[priority];
+            if (tasks.empty()) {
+                continue;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            pending -= 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void ThreadPool::workerLoop(size_t index) {
+    for (;;) {
+        std::function<void()> task;
+        size_t priority = 0;
+
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            condition.wait(lock, [this] {
+                return (stop && pending == 0) || hasRunnableTask();
+            });
+            if (stop && pending == 0) {
+                return;
+            }
+            if (!takeTask(index, task, priority)) {
+                continue;
+            }
+            running += 1;
+        }
+
+        task();
 
-                task();
+        bool batchQueued = false;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            running -= 1;
+            for (const auto &queue : queues) {
+                if (!queue.tasks[static_cast<size_t>(TaskPriority::Batch)].empty()) {
+                    batchQueued = true;
+                    break;
+                }
             }
-        });
+        }
+        // A batch task may have been waiting for this slot
+        if (batchQueued) {
+            condition.notify_all();
+        }
     }
 }
 
@@ -92,7 +185,26 @@ inline void ThreadPool::ensureRunning() {
         return;
     }
 
-    startWorkers(defaultThreadCount());
+    startWorkers(configuredThreads > 0 ? configuredThreads : defaultThreadCount());
+}
+
+inline void ThreadPool::setThreadCount(size_t threads) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+
+    configuredThreads = threads;
+
+    const size_t target = threads > 0 ? threads : defaultThreadCount();
+    if (!workers.empty() && !stop && target > workers.size()) {
+        startWorkers(target - workers.size());
+    }
+}
+
+inline size_t ThreadPool::threadCount() {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    if (!workers.empty()) {
+        return workers.size();
+    }
+    return configuredThreads > 0 ? configuredThreads : defaultThreadCount();
 }
 
 inline void ThreadPool::shutdown() {
@@ -126,17 +238,17 @@ inline void ThreadPool::shutdown() {
         }
     }
 
-    workers.clear();
-
     {
         std::unique_lock<std::mutex> lock(queue_mutex);
-        std::queue<std::function<void()>> empty;
-        std::swap(tasks, empty);
+        workers.clear();
+        queues.clear();
+        pending = 0;
+        running = 0;
     }
 }
 
 template <class F>
-void ThreadPool::enqueue(F &&f) {
+void ThreadPool::enqueue(F &&f, TaskPriority priority, int key) {
     ensureRunning();
 
     {
@@ -145,7 +257,9 @@ void ThreadPool::enqueue(F &&f) {
             throw std::runtime_error("enqueue on stopped ThreadPool");
         }
 
-        tasks.emplace(std::forward<F>(f));
+        size_t index = key >= 0 ? static_cast<size_t>(key) : nextQueue++;
+        queues[index % queues.size()].tasks[static_cast<size_t>(priority)].emplace_back(std::forward<F>(f));
+        pending += 1;
     }
 
     condition.notify_one();
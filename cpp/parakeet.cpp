@@ -30,6 +30,14 @@
 #include <codecvt>
 #endif
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(PARAKEET_BIG_ENDIAN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PARAKEET_USE_MMAP
+#endif
+
 #if defined(PARAKEET_BIG_ENDIAN)
 template<typename T>
 static T byteswap(T value) {
@@ -132,6 +140,9 @@ static void parakeet_log_callback_default(wsp_ggml_log_level level, const char *
     } while (0)
 
 #define PARAKEET_MAX_NODES 8192
+// the single-token prediction and joint graphs are tiny
+#define PARAKEET_MAX_DECODE_NODES 512
+#define PARAKEET_MAX_BEAMS 16
 
 // Threshold for when local attention should be used.
 // 8192 frames x 80ms = 655 s (about 10.9 mins)
@@ -140,6 +151,21 @@ static constexpr int PARAKEET_LOCAL_ATTN_THRESHOLD = 8192;
 // 128 frames * 80ms = 10.24 s
 static constexpr int PARAKEET_LOCAL_ATTN_WINDOW    = 128;
 
+// Streaming encodes the new audio in steps of PARAKEET_STREAM_CHUNK encoder
+// frames, preceded by up to n_stream_left_ctx (at most PARAKEET_LOCAL_ATTN_WINDOW)
+// frames of left context and followed by PARAKEET_STREAM_RIGHT_CONTEXT frames of
+// lookahead that are only committed by a later step.
+// 16 frames * 80ms = 1.28 s, 8 frames * 80ms = 0.64 s
+static constexpr int PARAKEET_STREAM_CHUNK         = 16;
+static constexpr int PARAKEET_STREAM_RIGHT_CONTEXT = 8;
+
+// parakeet_full_batch() pads the mel spectrograms of a group of utterances to
+// a multiple of PARAKEET_BATCH_CTX_STEP mel frames, and only groups utterances
+// that are at most PARAKEET_BATCH_MAX_PAD percent longer than the shortest one.
+// 50 frames * 10ms = 0.5 s
+static constexpr int PARAKEET_BATCH_CTX_STEP       = 50;
+static constexpr int PARAKEET_BATCH_MAX_PAD        = 25;
+
 static std::string format(const char * fmt, ...) {
     va_list ap;
     va_list ap2;
@@ -159,26 +185,126 @@ static std::string format(const char * fmt, ...) {
 // ggml helpers
 //
 
+static void * parakeet_cpu_get_proc_address(const char * name) {
+    wsp_ggml_backend_dev_t dev = wsp_ggml_backend_dev_by_type(WSP_GGML_BACKEND_DEVICE_TYPE_CPU);
+    wsp_ggml_backend_reg_t reg = dev ? wsp_ggml_backend_dev_backend_reg(dev) : nullptr;
+
+    return reg ? wsp_ggml_backend_reg_get_proc_address(reg, name) : nullptr;
+}
+
+typedef wsp_ggml_threadpool_t (*parakeet_threadpool_new_t)(struct wsp_ggml_threadpool_params * params);
+typedef void (*parakeet_threadpool_free_t)(wsp_ggml_threadpool_t threadpool);
+typedef void (*parakeet_backend_cpu_set_threadpool_t)(wsp_ggml_backend_t backend, wsp_ggml_threadpool_t threadpool);
+
+// CPU threadpool kept across graph computations, without it the CPU backend spawns and joins its
+// worker threads for every graph - once per token for the prediction and joint networks
+struct parakeet_threadpool {
+    wsp_ggml_threadpool_t owned    = nullptr; // created on first use, grown when more threads are requested
+    wsp_ggml_threadpool_t attached = nullptr; // set by the user, not owned
+
+    wsp_ggml_threadpool_t current  = nullptr; // threadpool the CPU backends currently use
+
+    int n_threads = 0; // size of the owned threadpool
+};
+
+static void parakeet_threadpool_set(
+                   parakeet_threadpool & tp,
+    const std::vector<wsp_ggml_backend_t> & backends,
+                 wsp_ggml_threadpool_t   threadpool) {
+    if (tp.current == threadpool) {
+        return;
+    }
+
+    auto * fn_set_threadpool = (parakeet_backend_cpu_set_threadpool_t) parakeet_cpu_get_proc_address("wsp_ggml_backend_cpu_set_threadpool");
+    if (fn_set_threadpool == nullptr) {
+        return;
+    }
+
+    for (auto * backend : backends) {
+        wsp_ggml_backend_dev_t dev = wsp_ggml_backend_get_device(backend);
+        if (dev && wsp_ggml_backend_dev_type(dev) == WSP_GGML_BACKEND_DEVICE_TYPE_CPU) {
+            fn_set_threadpool(backend, threadpool);
+        }
+    }
+
+    tp.current = threadpool;
+}
+
+static void parakeet_threadpool_free_owned(parakeet_threadpool & tp) {
+    if (tp.owned == nullptr) {
+        return;
+    }
+
+    auto * fn_free = (parakeet_threadpool_free_t) parakeet_cpu_get_proc_address("wsp_ggml_threadpool_free");
+    if (fn_free) {
+        fn_free(tp.owned);
+    }
+
+    tp.owned     = nullptr;
+    tp.n_threads = 0;
+}
+
+// make the CPU backends use the attached threadpool, or the owned one with at least n_threads threads
+static void parakeet_threadpool_prepare(
+                   parakeet_threadpool & tp,
+    const std::vector<wsp_ggml_backend_t> & backends,
+                                   int   n_threads) {
+    if (tp.attached) {
+        parakeet_threadpool_set(tp, backends, tp.attached);
+        return;
+    }
+
+    if (tp.owned == nullptr || tp.n_threads < n_threads) {
+        auto * fn_new = (parakeet_threadpool_new_t) parakeet_cpu_get_proc_address("wsp_ggml_threadpool_new");
+        if (fn_new == nullptr) {
+            return;
+        }
+
+        // the backends must not point to the threadpool that is replaced
+        parakeet_threadpool_set(tp, backends, nullptr);
+        parakeet_threadpool_free_owned(tp);
+
+        struct wsp_ggml_threadpool_params params = wsp_ggml_threadpool_params_default(n_threads);
+        tp.owned     = fn_new(&params);
+        tp.n_threads = tp.owned ? n_threads : 0;
+    }
+
+    parakeet_threadpool_set(tp, backends, tp.owned);
+}
+
+static void parakeet_threadpool_attach(
+                   parakeet_threadpool & tp,
+    const std::vector<wsp_ggml_backend_t> & backends,
+                 wsp_ggml_threadpool_t   threadpool) {
+    tp.attached = threadpool;
+
+    // switch right away, so that a detached threadpool can be freed
+    if (threadpool) {
+        parakeet_threadpool_set(tp, backends, threadpool);
+    } else if (tp.current != tp.owned) {
+        parakeet_threadpool_set(tp, backends, nullptr);
+    }
+}
+
 static bool wsp_ggml_graph_compute_helper(
+              wsp_ggml_backend_t   backend,
           struct wsp_ggml_cgraph * graph,
                          int   n_threads,
          wsp_ggml_abort_callback   abort_callback,
                         void * abort_callback_data) {
-    wsp_ggml_backend_ptr backend { wsp_ggml_backend_init_by_type(WSP_GGML_BACKEND_DEVICE_TYPE_CPU, nullptr) };
-
-    auto * reg = wsp_ggml_backend_dev_backend_reg(wsp_ggml_backend_get_device(backend.get()));
+    auto * reg = wsp_ggml_backend_dev_backend_reg(wsp_ggml_backend_get_device(backend));
 
     auto * set_abort_callback_fn = (wsp_ggml_backend_set_abort_callback_t) wsp_ggml_backend_reg_get_proc_address(reg, "wsp_ggml_backend_set_abort_callback");
     if (set_abort_callback_fn) {
-        set_abort_callback_fn(backend.get(), abort_callback, abort_callback_data);
+        set_abort_callback_fn(backend, abort_callback, abort_callback_data);
     }
 
     auto wsp_ggml_backend_set_n_threads_fn = (wsp_ggml_backend_set_n_threads_t) wsp_ggml_backend_reg_get_proc_address(reg, "wsp_ggml_backend_set_n_threads");
     if (wsp_ggml_backend_set_n_threads_fn) {
-        wsp_ggml_backend_set_n_threads_fn(backend.get(), n_threads);
+        wsp_ggml_backend_set_n_threads_fn(backend, n_threads);
     }
 
-    return wsp_ggml_backend_graph_compute(backend.get(), graph) == WSP_GGML_STATUS_SUCCESS;
+    return wsp_ggml_backend_graph_compute(backend, graph) == WSP_GGML_STATUS_SUCCESS;
 }
 
 static bool wsp_ggml_graph_compute_helper(
@@ -244,6 +370,8 @@ struct parakeet_segment {
     int64_t t0;
     int64_t t1;
 
+    int32_t i_utterance = 0; // input of parakeet_full_batch() the segment belongs to
+
     std::string text;
 
     std::vector<parakeet_token_data> tokens;
@@ -356,6 +484,50 @@ struct parakeet_joint_network {
     struct wsp_ggml_tensor * net_b  = nullptr;
 };
 
+// read-only mapping of a model file, see parakeet_context_params.use_mmap
+struct parakeet_mmap {
+    uint8_t * addr = nullptr;
+    size_t    size = 0;
+    size_t    pos  = 0; // read position of the loader
+
+    parakeet_mmap() = default;
+    parakeet_mmap(const parakeet_mmap &) = delete;
+    parakeet_mmap & operator=(const parakeet_mmap &) = delete;
+
+    ~parakeet_mmap() {
+#ifdef PARAKEET_USE_MMAP
+        if (addr) {
+            munmap(addr, size);
+        }
+#endif
+    }
+
+    static std::shared_ptr<parakeet_mmap> open(const char * path) {
+#ifdef PARAKEET_USE_MMAP
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        void * addr = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            return nullptr;
+        }
+        auto mapping = std::make_shared<parakeet_mmap>();
+        mapping->addr = (uint8_t *) addr;
+        mapping->size = st.st_size;
+        return mapping;
+#else
+        WSP_GGML_UNUSED(path);
+        return nullptr;
+#endif
+    }
+};
+
 struct parakeet_model {
     parakeet_filters filters;
     parakeet_hparams hparams;
@@ -385,6 +557,10 @@ struct parakeet_model {
 
     std::vector<wsp_ggml_backend_buffer_t> buffers;
 
+    // weights of CPU buffers that point into the model file, kept mapped until the model is freed
+    std::shared_ptr<parakeet_mmap> mapping;
+    wsp_ggml_backend_buffer_t      buffer_mapped = nullptr;
+
     int n_loaded = 0;
     std::map<std::string, struct wsp_ggml_tensor *> tensors;
 };
@@ -402,6 +578,65 @@ struct parakeet_lstm_state {
     wsp_ggml_backend_buffer_t buffer = nullptr;
 };
 
+// Batched prediction/joint network state used by beam search, with one
+// column per hypothesis. The per-hypothesis LSTM states are kept on the host
+// and uploaded to lstm_state before each batched prediction network call.
+struct parakeet_beam_state {
+    int32_t n_beam = 0;
+
+    parakeet_lstm_state lstm_state;
+
+    struct wsp_ggml_tensor * pred_out = nullptr;
+
+    std::vector<uint8_t> pred_out_buf;
+    wsp_ggml_backend_buffer_t pred_out_buffer = nullptr;
+
+    parakeet_sched sched_predict;
+    parakeet_sched sched_joint;
+
+    struct wsp_ggml_cgraph * gf_predict = nullptr;
+    struct wsp_ggml_cgraph * gf_joint   = nullptr;
+
+    // host staging for the batched inputs/outputs
+    std::vector<float>   inp_state;
+    std::vector<int32_t> inp_token;
+    std::vector<int32_t> inp_time;
+};
+
+// Incremental front end and decoder position of a streaming session.
+// Mel frames and encoder frames are indexed from the start of the stream.
+struct parakeet_stream {
+    bool active = false;
+
+    parakeet_full_params params;
+
+    // preemphasized samples starting at absolute (center padded) sample
+    // pcm_offset, kept until no pending mel frame needs them
+    std::vector<float> pcm;
+    int64_t pcm_offset = 0;
+    int64_t n_samples  = 0;    // number of samples pushed so far
+    float   pcm_last   = 0.0f; // last pushed sample, for the preemphasis filter
+
+    // unnormalized log mel frames starting at frame mel_offset, kept as
+    // long as they can be part of the left context of an encoder window
+    std::vector<float> mel;
+    int64_t mel_offset = 0;
+    int64_t n_mel      = 0;    // number of mel frames computed so far
+
+    // running per-feature statistics used for the mel normalization
+    std::vector<double> mel_sum;
+    std::vector<double> mel_sum_sq;
+
+    int64_t n_mel_stat = 0;    // number of mel frames included in the statistics
+
+    int     n_left_ctx = 0;    // encoder frames of left context in each window
+    int64_t n_enc_done = 0;    // encoder frames handed over to the decoder
+    int64_t t          = 0;    // absolute encoder frame the decoder continues from
+
+    int32_t tokens_emitted = 0;
+    bool    primed         = false;
+};
+
 struct parakeet_state {
     int64_t t_sample_us = 0;
     int64_t t_encode_us = 0;
@@ -410,8 +645,12 @@ struct parakeet_state {
     int64_t t_predict_build_us   = 0; // time spent building the prediction graph
     int64_t t_predict_alloc_us   = 0; // time spent in wsp_ggml_backend_sched_alloc_graph
     int64_t t_predict_compute_us = 0; // time spent in wsp_ggml_graph_compute_helper
+    int64_t t_beam_predict_us = 0; // beam search prediction network time
+    int64_t t_beam_joint_us   = 0; // beam search joint network time
     int64_t t_mel_us = 0;
 
+    int32_t n_beam_predict = 0; // number of hypotheses advanced by the beam search prediction network
+    int32_t n_beam_joint   = 0; // number of hypotheses evaluated by the beam search joint network
     int32_t n_sample = 0; // number of tokens sampled
     int32_t n_encode = 0; // number of encoder calls
     int32_t n_decode = 0; // number of decoder calls with n_tokens == 1  (text-generation)
@@ -427,8 +666,22 @@ struct parakeet_state {
 
     std::vector<wsp_ggml_backend_t> backends;
 
+    parakeet_threadpool threadpool;
+
     parakeet_sched sched_encode;
-    parakeet_sched sched_decode;
+
+    // the prediction and joint graphs are built and allocated once and then
+    // replayed for every decoding step with only the inputs updated
+    parakeet_sched sched_predict;
+    parakeet_sched sched_joint;
+    parakeet_sched sched_joint_block;
+
+    struct wsp_ggml_cgraph * gf_predict     = nullptr;
+    struct wsp_ggml_cgraph * gf_joint       = nullptr;
+    struct wsp_ggml_cgraph * gf_joint_block = nullptr;
+
+    // number of encoder frames evaluated by gf_joint_block
+    int32_t n_joint_block = 0;
 
     // outputs from encoder stages
     struct wsp_ggml_tensor * enc_out     = nullptr;
@@ -444,6 +697,7 @@ struct parakeet_state {
 
     std::vector<float> inp_mel;
     std::vector<float> inp_mask;
+    std::vector<int32_t> inp_time;
 
     std::vector<float> logits;
 
@@ -457,7 +711,17 @@ struct parakeet_state {
     int32_t n_audio_ctx = 0;
     int32_t sched_encode_n_audio_ctx = 0;
 
+    // number of utterances encoded by one encoder graph, the mel spectrograms
+    // of a batch are kept in mel_batch (see parakeet_full_batch_with_state)
+    int32_t n_audio_batch = 1;
+
+    std::vector<parakeet_mel> mel_batch;
+
     parakeet_lstm_state lstm_state;
+
+    parakeet_beam_state beam;
+
+    parakeet_stream stream;
 };
 
 // FFT cache for mel spectrogram computation
@@ -669,6 +933,42 @@ static bool parakeet_sched_graph_init(struct parakeet_sched & allocr, std::vecto
     return true;
 }
 
+// Build a graph once and keep it allocated in its own scheduler so that it can
+// be computed repeatedly without being rebuilt or reallocated. Inputs must be
+// set and the graph computed with sched_reset = false.
+static bool parakeet_sched_graph_init_cached(
+        struct parakeet_sched & allocr,
+       struct wsp_ggml_cgraph *& gf,
+        std::vector<wsp_ggml_backend_t> backends,
+        std::function<struct wsp_ggml_cgraph *()> && get_graph) {
+    auto & sched = allocr.sched;
+    auto & meta  = allocr.meta;
+
+    gf = nullptr;
+
+    sched = wsp_ggml_backend_sched_new(backends.data(), nullptr, backends.size(), PARAKEET_MAX_DECODE_NODES, false, true);
+
+    if (!sched) {
+        PARAKEET_LOG_ERROR("%s: failed to create scheduler\n", __func__);
+        return false;
+    }
+
+    meta.resize(wsp_ggml_tensor_overhead()*PARAKEET_MAX_DECODE_NODES + wsp_ggml_graph_overhead_custom(PARAKEET_MAX_DECODE_NODES, false));
+
+    struct wsp_ggml_cgraph * graph = get_graph();
+
+    if (!wsp_ggml_backend_sched_alloc_graph(sched, graph)) {
+        PARAKEET_LOG_ERROR("%s: failed to allocate the compute buffer\n", __func__);
+        wsp_ggml_backend_sched_free(sched);
+        sched = nullptr;
+        return false;
+    }
+
+    gf = graph;
+
+    return true;
+}
+
 static void parakeet_sched_free(struct parakeet_sched & sched) {
     if (sched.sched) {
         wsp_ggml_backend_sched_free(sched.sched);
@@ -685,13 +985,100 @@ static void read_safe(parakeet_model_loader * loader, T & dest) {
     BYTESWAP_VALUE(dest);
 }
 
+static size_t parakeet_mmap_read(void * ctx, void * output, size_t read_size) {
+    parakeet_mmap * mapping = (parakeet_mmap *) ctx;
+
+    size_t n = std::min(read_size, mapping->size - mapping->pos);
+    memcpy(output, mapping->addr + mapping->pos, n);
+    mapping->pos += n;
+
+    return n;
+}
+
+// the CPU kernels access weights with at least the natural alignment of their type
+static size_t parakeet_mmap_align(wsp_ggml_type type) {
+    switch (type) {
+        case WSP_GGML_TYPE_I8:
+            return 1;
+        case WSP_GGML_TYPE_F16:
+        case WSP_GGML_TYPE_BF16:
+        case WSP_GGML_TYPE_I16:
+        case WSP_GGML_TYPE_Q4_0:
+        case WSP_GGML_TYPE_Q4_1:
+        case WSP_GGML_TYPE_Q5_0:
+        case WSP_GGML_TYPE_Q5_1:
+        case WSP_GGML_TYPE_Q8_0:
+            return 2;
+        case WSP_GGML_TYPE_F64:
+        case WSP_GGML_TYPE_I64:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+// Points the CPU tensors straight at their data in the mapped file instead of
+// allocating and reading them. Tensor data is not aligned in the file, so
+// tensors at an offset below the alignment of their type are left for the
+// regular allocation. Returns the number of mapped bytes.
+static size_t parakeet_mmap_tensors(
+        parakeet_mmap & mapping,
+        parakeet_model & model,
+        const std::set<const wsp_ggml_tensor *> & cpu_tensors) {
+    size_t pos = mapping.pos;
+    size_t n_bytes = 0;
+
+    while (pos + 3*sizeof(int32_t) <= mapping.size) {
+        int32_t n_dims;
+        int32_t length;
+        memcpy(&n_dims, mapping.addr + pos, sizeof(n_dims));
+        memcpy(&length, mapping.addr + pos + sizeof(int32_t), sizeof(length));
+        pos += 3*sizeof(int32_t);
+
+        if (n_dims < 0 || n_dims > 4 || length < 0 || pos + n_dims*sizeof(int32_t) + length > mapping.size) {
+            break;
+        }
+        pos += n_dims*sizeof(int32_t);
+
+        const std::string name((const char *) mapping.addr + pos, length);
+        pos += length;
+
+        // unknown tensors and size mismatches are reported by the regular load
+        auto it = model.tensors.find(name);
+        if (it == model.tensors.end()) {
+            break;
+        }
+
+        wsp_ggml_tensor * tensor = it->second;
+        const size_t nbytes = wsp_ggml_nbytes(tensor);
+        if (pos + nbytes > mapping.size) {
+            break;
+        }
+
+        if (tensor->data == nullptr && cpu_tensors.count(tensor) && pos % parakeet_mmap_align(tensor->type) == 0) {
+            if (!model.buffer_mapped) {
+                model.buffer_mapped = wsp_ggml_backend_cpu_buffer_from_ptr(mapping.addr, mapping.size);
+                if (!model.buffer_mapped) {
+                    return 0;
+                }
+            }
+            wsp_ggml_backend_tensor_alloc(model.buffer_mapped, tensor, mapping.addr + pos);
+            n_bytes += nbytes;
+        }
+
+        pos += nbytes;
+    }
+
+    return n_bytes;
+}
+
+// n_seq > 1 allocates one state column per sequence (used by beam search)
 static bool parakeet_lstm_state_init(
-               struct parakeet_state & pstate,
+         struct parakeet_lstm_state & lstm_state,
                       wsp_ggml_backend_t   backend,
                                  int   n_layer,
-                                 int   n_pred_dim) {
-    parakeet_lstm_state & lstm_state = pstate.lstm_state;
-
+                                 int   n_pred_dim,
+                                 int   n_seq = 1) {
     lstm_state.ctx_buf.resize(wsp_ggml_tensor_overhead() * n_layer * 2);
     lstm_state.layer.resize(n_layer);
 
@@ -710,8 +1097,8 @@ static bool parakeet_lstm_state_init(
 
 
     for (int il = 0; il < n_layer; ++il) {
-        lstm_state.layer[il].h_state = wsp_ggml_new_tensor_1d(ctx, WSP_GGML_TYPE_F32, n_pred_dim);
-        lstm_state.layer[il].c_state = wsp_ggml_new_tensor_1d(ctx, WSP_GGML_TYPE_F32, n_pred_dim);
+        lstm_state.layer[il].h_state = wsp_ggml_new_tensor_2d(ctx, WSP_GGML_TYPE_F32, n_pred_dim, n_seq);
+        lstm_state.layer[il].c_state = wsp_ggml_new_tensor_2d(ctx, WSP_GGML_TYPE_F32, n_pred_dim, n_seq);
     }
 
     lstm_state.buffer = wsp_ggml_backend_alloc_ctx_tensors(ctx, backend);
@@ -790,6 +1177,65 @@ static bool parakeet_enc_state_init(
     return true;
 }
 
+static void parakeet_beam_state_free(struct parakeet_beam_state & beam) {
+    parakeet_sched_free(beam.sched_predict);
+    parakeet_sched_free(beam.sched_joint);
+    beam.gf_predict = nullptr;
+    beam.gf_joint   = nullptr;
+
+    wsp_ggml_backend_buffer_free(beam.lstm_state.buffer);
+    beam.lstm_state.buffer = nullptr;
+    beam.lstm_state.layer.clear();
+
+    wsp_ggml_backend_buffer_free(beam.pred_out_buffer);
+    beam.pred_out_buffer = nullptr;
+    beam.pred_out = nullptr;
+
+    beam.n_beam = 0;
+}
+
+static bool parakeet_beam_state_init(
+          struct parakeet_beam_state & beam,
+                      wsp_ggml_backend_t   backend,
+                                 int   n_layer,
+                                 int   n_pred_dim,
+                                 int   n_beam) {
+    parakeet_beam_state_free(beam);
+
+    if (!parakeet_lstm_state_init(beam.lstm_state, backend, n_layer, n_pred_dim, n_beam)) {
+        PARAKEET_LOG_ERROR("%s: failed to allocate the beam lstm states\n", __func__);
+        return false;
+    }
+
+    beam.pred_out_buf.resize(wsp_ggml_tensor_overhead());
+
+    struct wsp_ggml_init_params params = {
+        /*.mem_size   =*/ beam.pred_out_buf.size(),
+        /*.mem_buffer =*/ beam.pred_out_buf.data(),
+        /*.no_alloc   =*/ true,
+    };
+
+    struct wsp_ggml_context * ctx = wsp_ggml_init(params);
+    if (!ctx) {
+        PARAKEET_LOG_ERROR("%s: failed to allocate memory for beam pred tensor context\n", __func__);
+        return false;
+    }
+
+    beam.pred_out = wsp_ggml_new_tensor_2d(ctx, WSP_GGML_TYPE_F32, n_pred_dim, n_beam);
+    beam.pred_out_buffer = wsp_ggml_backend_alloc_ctx_tensors(ctx, backend);
+    if (!beam.pred_out_buffer) {
+        PARAKEET_LOG_ERROR("%s: failed to allocate memory for beam pred tensor\n", __func__);
+        wsp_ggml_free(ctx);
+        return false;
+    }
+
+    wsp_ggml_free(ctx);
+
+    beam.n_beam = n_beam;
+
+    return true;
+}
+
 static wsp_ggml_backend_t parakeet_backend_init_gpu(const parakeet_context_params & params) {
     wsp_ggml_log_set(g_state.log_callback, g_state.log_callback_user_data);
 
@@ -1362,6 +1808,24 @@ static bool parakeet_model_load(struct parakeet_model_loader * loader, parakeet_
 
     wsp_ggml_free(ctx);
 
+    // map the weights of the CPU buffer from the model file
+    parakeet_mmap * mapping = loader->read == parakeet_mmap_read ? (parakeet_mmap *) loader->context : nullptr;
+    if (mapping) {
+        std::set<const wsp_ggml_tensor *> cpu_tensors;
+        auto it = ctx_map.find(wsp_ggml_backend_cpu_buffer_type());
+        if (it != ctx_map.end()) {
+            for (auto * t = wsp_ggml_get_first_tensor(it->second); t != nullptr; t = wsp_ggml_get_next_tensor(it->second, t)) {
+                cpu_tensors.insert(t);
+            }
+        }
+
+        const size_t size_mapped = parakeet_mmap_tensors(*mapping, wctx.model, cpu_tensors);
+        if (wctx.model.buffer_mapped) {
+            wctx.model.buffers.emplace_back(wctx.model.buffer_mapped);
+            PARAKEET_LOG_INFO("%s: %12s total size = %8.2f MB\n", __func__, wsp_ggml_backend_buffer_name(wctx.model.buffer_mapped), size_mapped / 1e6);
+        }
+    }
+
     // allocate tensors in the backend buffers
     for (auto & p : ctx_map) {
         wsp_ggml_backend_buffer_type_t buft = p.first;
@@ -1439,7 +1903,10 @@ static bool parakeet_model_load(struct parakeet_model_loader * loader, parakeet_
                 return false;
             }
 
-            if (wsp_ggml_backend_buffer_is_host(tensor->buffer)) {
+            if (mapping && tensor->buffer == wctx.model.buffer_mapped) {
+                // already in place, see parakeet_mmap_tensors
+                mapping->pos += wsp_ggml_nbytes(tensor);
+            } else if (wsp_ggml_backend_buffer_is_host(tensor->buffer)) {
                 // for the CPU and Metal backend, we can read directly into the tensor
                 loader->read(loader->context, tensor->data, wsp_ggml_nbytes(tensor));
                 BYTESWAP_TENSOR(tensor);
@@ -1481,6 +1948,7 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
     const auto & model    = pctx.model;
     const auto & hparams  = model.hparams;
     const int n_mel_time  = pstate.n_audio_ctx > 0 ? pstate.n_audio_ctx : hparams.n_audio_ctx;
+    const int n_batch     = pstate.n_audio_batch;
     const int n_mels      = hparams.n_mels;
     const int n_layer     = hparams.n_audio_layer;
     const int n_state     = hparams.n_audio_state;
@@ -1498,7 +1966,7 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
     // Conv subsampling
 
     // [freq, time]
-    struct wsp_ggml_tensor * mel = wsp_ggml_new_tensor_4d(ctx0, WSP_GGML_TYPE_F32, n_mels, n_mel_time, 1, 1);
+    struct wsp_ggml_tensor * mel = wsp_ggml_new_tensor_4d(ctx0, WSP_GGML_TYPE_F32, n_mels, n_mel_time, 1, n_batch);
     wsp_ggml_set_name(mel, "mel");
     wsp_ggml_set_input(mel);
 
@@ -1510,6 +1978,17 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
     cur = wsp_ggml_relu(ctx0, cur);
     wsp_ggml_set_name(cur, "pre_conv_0_relu");
 
+    // Utterances shorter than the batch are padded. The padded frames are
+    // zeroed before every convolution over time so that they act like the
+    // zero padding of an utterance that is encoded on its own.
+    if (n_batch > 1) {
+        struct wsp_ggml_tensor * sub_mask = wsp_ggml_new_tensor_4d(ctx0, WSP_GGML_TYPE_F32, 1, cur->ne[1], 1, n_batch);
+        wsp_ggml_set_name(sub_mask, "sub_mask_0");
+        wsp_ggml_set_input(sub_mask);
+
+        cur = wsp_ggml_mul(ctx0, cur, sub_mask);
+    }
+
     // [freq, time, channels, batch]
     cur = wsp_ggml_conv_2d_dw_direct(ctx0, model.enc_pre_conv_2_w, cur, 2, 2, 1, 1, 1, 1);
     cur = wsp_ggml_add(ctx0, cur, model.enc_pre_conv_2_b);
@@ -1523,6 +2002,14 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
     cur = wsp_ggml_relu(ctx0, cur);
     wsp_ggml_set_name(cur, "pre_conv_3_relu");
 
+    if (n_batch > 1) {
+        struct wsp_ggml_tensor * sub_mask = wsp_ggml_new_tensor_4d(ctx0, WSP_GGML_TYPE_F32, 1, cur->ne[1], 1, n_batch);
+        wsp_ggml_set_name(sub_mask, "sub_mask_1");
+        wsp_ggml_set_input(sub_mask);
+
+        cur = wsp_ggml_mul(ctx0, cur, sub_mask);
+    }
+
     // [freq, time, channels, batch]
     cur = wsp_ggml_conv_2d_dw_direct(ctx0, model.enc_pre_conv_5_w, cur, 2, 2, 1, 1, 1, 1);
     wsp_ggml_set_name(cur, "pre_conv_5_direct");
@@ -1546,8 +2033,8 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
     const int n_chan   = cur->ne[1]; // 256
     const int n_frames = cur->ne[2]; // time
 
-    // [freq, time, chan, batch] -> [(freq * chan), time]
-    cur = wsp_ggml_reshape_2d(ctx0, cur, n_freq * n_chan, n_frames);
+    // [freq, chan, time, batch] -> [(freq * chan), time, batch]
+    cur = wsp_ggml_reshape_3d(ctx0, cur, n_freq * n_chan, n_frames, n_batch);
 
     cur = wsp_ggml_mul_mat(ctx0, model.enc_pre_out_w, cur);
     cur = wsp_ggml_add(ctx0, cur, model.enc_pre_out_b);
@@ -1555,7 +2042,7 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
     wsp_ggml_set_name(cur, "pre_enc_out");
 
     // Encoder
-    // cur: [n_state, n_enc_time]
+    // cur: [n_state, n_enc_time, n_batch]
 
     const int  n_time      = cur->ne[1];
     const bool local_attn  = n_time > PARAKEET_LOCAL_ATTN_THRESHOLD;
@@ -1565,11 +2052,22 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
     const int  d_half      = n_state / 2;
     const int  mask_dim    = local_attn ? window_size : n_time;
 
-    // mask [key, n_time]
-    struct wsp_ggml_tensor * attn_mask = wsp_ggml_new_tensor_2d(ctx0, WSP_GGML_TYPE_F32, mask_dim, n_time);
+    // batched utterances are only encoded with full attention
+    PARAKEET_ASSERT(n_batch == 1 || !local_attn);
+
+    // mask [key, n_time, 1, n_batch]
+    struct wsp_ggml_tensor * attn_mask = wsp_ggml_new_tensor_4d(ctx0, WSP_GGML_TYPE_F32, mask_dim, n_time, 1, n_batch);
     wsp_ggml_set_name(attn_mask, "attn_mask");
     wsp_ggml_set_input(attn_mask);
 
+    // padding mask of the encoder frames, applied before the depthwise convolutions
+    struct wsp_ggml_tensor * time_mask = nullptr;
+    if (n_batch > 1) {
+        time_mask = wsp_ggml_new_tensor_3d(ctx0, WSP_GGML_TYPE_F32, 1, n_time, n_batch);
+        wsp_ggml_set_name(time_mask, "time_mask");
+        wsp_ggml_set_input(time_mask);
+    }
+
     struct wsp_ggml_tensor * local_mask = nullptr;
     if (local_attn) {
         const int chunk = att_left + att_right;
@@ -1637,9 +2135,9 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
             struct wsp_ggml_tensor * K_cur = wsp_ggml_mul_mat(ctx0, layer.attn_k_w, cur);
             struct wsp_ggml_tensor * V_cur = wsp_ggml_mul_mat(ctx0, layer.attn_v_w, cur);
 
-            Q_cur = wsp_ggml_reshape_3d(ctx0, Q_cur, d_head, n_head, n_time);
-            K_cur = wsp_ggml_reshape_3d(ctx0, K_cur, d_head, n_head, n_time);
-            V_cur = wsp_ggml_reshape_3d(ctx0, V_cur, d_head, n_head, n_time);
+            Q_cur = wsp_ggml_reshape_4d(ctx0, Q_cur, d_head, n_head, n_time, n_batch);
+            K_cur = wsp_ggml_reshape_4d(ctx0, K_cur, d_head, n_head, n_time, n_batch);
+            V_cur = wsp_ggml_reshape_4d(ctx0, V_cur, d_head, n_head, n_time, n_batch);
 
             struct wsp_ggml_tensor * pos = wsp_ggml_mul_mat(ctx0, layer.attn_pos_w, pos_emb);
             pos = wsp_ggml_reshape_3d(ctx0, pos, d_head, n_head, window_size);
@@ -1798,26 +2296,29 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
                     rel_pos_scores = wsp_ggml_pad(ctx0, rel_pos_scores, 1, 0, 0, 0);
                     rel_pos_scores = wsp_ggml_roll(ctx0, rel_pos_scores, 1, 0, 0, 0);
 
-                    rel_pos_scores = wsp_ggml_reshape_3d(ctx0, rel_pos_scores, n_frame, pos_window + 1, n_head_cur);
+                    rel_pos_scores = wsp_ggml_reshape_4d(ctx0, rel_pos_scores, n_frame, pos_window + 1, n_head_cur, n_batch);
                     wsp_ggml_format_name(rel_pos_scores, "enc_%d_attn_rel_pos_reshaped", il);
 
                     int center = pos_window / 2;
                     size_t offset = rel_pos_scores->nb[0] * (center+1);
 
-                    rel_pos_scores = wsp_ggml_view_3d(ctx0, rel_pos_scores,
-                                                  n_frame, pos_window, n_head_cur,
+                    rel_pos_scores = wsp_ggml_view_4d(ctx0, rel_pos_scores,
+                                                  n_frame, pos_window, n_head_cur, n_batch,
                                                   (pos_window) * 4,
                                                   rel_pos_scores->nb[2],
+                                                  rel_pos_scores->nb[3],
                                                   offset);
 
                     wsp_ggml_format_name(rel_pos_scores, "enc_%d_attn_rel_pos_shifted", il);
 
-                    rel_pos_scores = wsp_ggml_view_3d(ctx0, rel_pos_scores,
+                    rel_pos_scores = wsp_ggml_view_4d(ctx0, rel_pos_scores,
                                                   content_scores->ne[0],
                                                   content_scores->ne[1],
                                                   rel_pos_scores->ne[2],
+                                                  rel_pos_scores->ne[3],
                                                   rel_pos_scores->nb[1],
                                                   rel_pos_scores->nb[2],
+                                                  rel_pos_scores->nb[3],
                                                   0);
                     rel_pos_scores = wsp_ggml_cont(ctx0, rel_pos_scores);
                     wsp_ggml_format_name(rel_pos_scores, "enc_%d_attn_rel_pos_shifted_view", il);
@@ -1838,7 +2339,7 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
                 wsp_ggml_format_name(cur, "enc_%d_attn_inp", il);
 
                 cur = wsp_ggml_permute(ctx0, cur, 2, 0, 1, 3);
-                cur = wsp_ggml_cont_2d(ctx0, cur, n_state, n_time);
+                cur = wsp_ggml_cont_3d(ctx0, cur, n_state, n_time, n_batch);
                 cur = wsp_ggml_mul_mat(ctx0, layer.attn_out_w, cur);
             }
             wsp_ggml_format_name(cur, "enc_%d_attn_out", il);
@@ -1862,13 +2363,17 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
 
             {
                 int64_t d = cur->ne[0] / 2;
-                struct wsp_ggml_tensor * signal = wsp_ggml_view_2d(ctx0, cur, d, cur->ne[1], cur->nb[1], 0);
-                struct wsp_ggml_tensor * gate   = wsp_ggml_view_2d(ctx0, cur, d, cur->ne[1], cur->nb[1], d * cur->nb[0]);
+                struct wsp_ggml_tensor * signal = wsp_ggml_view_3d(ctx0, cur, d, cur->ne[1], cur->ne[2], cur->nb[1], cur->nb[2], 0);
+                struct wsp_ggml_tensor * gate   = wsp_ggml_view_3d(ctx0, cur, d, cur->ne[1], cur->ne[2], cur->nb[1], cur->nb[2], d * cur->nb[0]);
 
                 cur = wsp_ggml_mul(ctx0, signal, wsp_ggml_sigmoid(ctx0, gate));
                 wsp_ggml_format_name(cur, "enc_%d_conv_glu", il);
             }
 
+            if (time_mask) {
+                cur = wsp_ggml_mul(ctx0, cur, time_mask);
+            }
+
             cur = wsp_ggml_cont(ctx0, wsp_ggml_transpose(ctx0, cur));
 
             // use wsp_ggml_ssm_conv for f32 precision
@@ -1918,7 +2423,8 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_encode(parakeet_context & p
     wsp_ggml_set_name(cur, "encoder_out");
     pstate.n_frames = cur->ne[1];
 
-    struct wsp_ggml_tensor * enc_out_view = wsp_ggml_view_2d(ctx0, pstate.enc_out, n_state, pstate.n_frames, pstate.enc_out->nb[1], 0);
+    // utterance b occupies the frames [b*n_frames, (b + 1)*n_frames) of enc_out
+    struct wsp_ggml_tensor * enc_out_view = wsp_ggml_view_2d(ctx0, pstate.enc_out, n_state, pstate.n_frames * n_batch, pstate.enc_out->nb[1], 0);
     wsp_ggml_build_forward_expand(gf, wsp_ggml_cpy(ctx0, cur, enc_out_view));
 
     wsp_ggml_free(ctx0);
@@ -1935,6 +2441,8 @@ static bool parakeet_encode_internal(
                    void * abort_callback_data) {
     const int64_t t_start_us = wsp_ggml_time_us();
 
+    parakeet_threadpool_prepare(pstate.threadpool, pstate.backends, n_threads);
+
     auto & sched = pstate.sched_encode.sched;
 
     wsp_ggml_cgraph * gf = parakeet_build_graph_encode(pctx, pstate);
@@ -1944,25 +2452,39 @@ static bool parakeet_encode_internal(
         return false;
     }
 
+    const int n_batch = pstate.n_audio_batch;
+
+    // the utterances of a batch are taken from mel_batch, a single one from mel
+    auto get_mel = [&](int b) -> const parakeet_mel & {
+        return n_batch > 1 ? pstate.mel_batch[b] : pstate.mel;
+    };
+
+    const int32_t subsampl_factor = pctx.model.hparams.subsampling_factor;
+
     // set mel input
     {
         struct wsp_ggml_tensor * mel = wsp_ggml_graph_get_tensor(gf, "mel");
 
-        const auto & mel_inp = pstate.mel;
-        const int n_ctx      = pstate.n_audio_ctx > 0 ? pstate.n_audio_ctx : pctx.model.hparams.n_audio_ctx;
+        const int n_ctx  = pstate.n_audio_ctx > 0 ? pstate.n_audio_ctx : pctx.model.hparams.n_audio_ctx;
+        const int n_mels = pctx.model.hparams.n_mels;
 
         assert(mel->type == WSP_GGML_TYPE_F32);
-        assert(mel_inp.n_mel == pctx.model.hparams.n_mels);
 
         pstate.inp_mel.resize(wsp_ggml_nelements(mel));
 
         float * dst = pstate.inp_mel.data();
         memset(dst, 0, wsp_ggml_nbytes(mel));
 
-        const int i0 = std::min(mel_offset,         mel_inp.n_len);
-        const int i1 = std::min(mel_offset + n_ctx, mel_inp.n_len);
+        for (int b = 0; b < n_batch; ++b) {
+            const auto & mel_inp = get_mel(b);
+
+            assert(mel_inp.n_mel == n_mels);
 
-        memcpy(dst, mel_inp.data.data() + i0 * mel_inp.n_mel, (i1 - i0) * mel_inp.n_mel * sizeof(float));
+            const int i0 = std::min(mel_offset,         mel_inp.n_len);
+            const int i1 = std::min(mel_offset + n_ctx, mel_inp.n_len);
+
+            memcpy(dst + (size_t) b * n_ctx * n_mels, mel_inp.data.data() + i0 * mel_inp.n_mel, (i1 - i0) * mel_inp.n_mel * sizeof(float));
+        }
 
         wsp_ggml_backend_tensor_set(mel, pstate.inp_mel.data(), 0, wsp_ggml_nelements(mel)*sizeof(float));
     }
@@ -1973,30 +2495,56 @@ static bool parakeet_encode_internal(
         const int n_q = attn_mask->ne[1];
         const int n_k = attn_mask->ne[0];
 
-        const int32_t subsampl_factor = pctx.model.hparams.subsampling_factor;
-        const int n_tokens_real = (pstate.mel.n_len_org + subsampl_factor - 1) / subsampl_factor;
-
-        std::vector<float> mask_data(n_q * n_k);
+        std::vector<float> mask_data((size_t) n_q * n_k * n_batch);
         const float mask_value = -1e30f;
 
-        if (n_k == n_q) {   // full attention
-            for (int q = 0; q < n_q; ++q) {
-                for (int k = 0; k < n_k; ++k) {
-                    mask_data[q * n_k + k] = (k >= n_tokens_real) ? mask_value : 0.0f;
+        for (int b = 0; b < n_batch; ++b) {
+            const int n_tokens_real = (get_mel(b).n_len_org + subsampl_factor - 1) / subsampl_factor;
+
+            float * mask_b = mask_data.data() + (size_t) b * n_q * n_k;
+
+            if (n_k == n_q) {   // full attention
+                for (int q = 0; q < n_q; ++q) {
+                    for (int k = 0; k < n_k; ++k) {
+                        mask_b[q * n_k + k] = (k >= n_tokens_real) ? mask_value : 0.0f;
+                    }
                 }
-            }
-        } else {            // local attention
-            const int att_left = n_k / 2;
-            for (int q = 0; q < n_q; ++q) {
-                for (int k = 0; k < n_k; ++k) {
-                    const int key = q - att_left + k;
-                    mask_data[q * n_k + k] = (key >= 0 && key < n_tokens_real) ? 0.0f : mask_value;
+            } else {            // local attention
+                const int att_left = n_k / 2;
+                for (int q = 0; q < n_q; ++q) {
+                    for (int k = 0; k < n_k; ++k) {
+                        const int key = q - att_left + k;
+                        mask_b[q * n_k + k] = (key >= 0 && key < n_tokens_real) ? 0.0f : mask_value;
+                    }
                 }
             }
         }
         wsp_ggml_backend_tensor_set(attn_mask, mask_data.data(), 0, mask_data.size() * sizeof(float));
     }
 
+    // set the padding masks of batched utterances, every subsampling stage halves the frames
+    if (n_batch > 1) {
+        const std::pair<const char *, int> masks[] = {
+            { "sub_mask_0", 2 },
+            { "sub_mask_1", 4 },
+            { "time_mask",  subsampl_factor },
+        };
+
+        for (const auto & mask : masks) {
+            struct wsp_ggml_tensor * mask_t = wsp_ggml_graph_get_tensor(gf, mask.first);
+            const int n_time = mask_t->ne[1];
+
+            std::vector<float> mask_data((size_t) n_time * n_batch);
+            for (int b = 0; b < n_batch; ++b) {
+                const int n_valid = (get_mel(b).n_len_org + mask.second - 1) / mask.second;
+                for (int t = 0; t < n_time; ++t) {
+                    mask_data[(size_t) b * n_time + t] = t < n_valid ? 1.0f : 0.0f;
+                }
+            }
+            wsp_ggml_backend_tensor_set(mask_t, mask_data.data(), 0, mask_data.size() * sizeof(float));
+        }
+    }
+
     // set local attention skew mask
     if (struct wsp_ggml_tensor * local_mask = wsp_ggml_graph_get_tensor(gf, "local_mask")) {
         const int n_k = local_mask->ne[0];
@@ -2057,23 +2605,34 @@ static bool parakeet_encode_internal(
 static bool parakeet_ensure_encode_sched(
         parakeet_context & pctx,
           parakeet_state & pstate,
-                    int    n_audio_ctx) {
-    if (pstate.sched_encode.sched && pstate.sched_encode_n_audio_ctx == n_audio_ctx) {
+                    int    n_audio_ctx,
+                    int    n_batch = 1) {
+    if (pstate.sched_encode.sched && pstate.sched_encode_n_audio_ctx == n_audio_ctx && pstate.n_audio_batch == n_batch) {
         return true;
     }
 
     parakeet_sched_free(pstate.sched_encode);
 
     const int32_t prev_n_audio_ctx = pstate.n_audio_ctx;
-    pstate.n_audio_ctx = n_audio_ctx;
+    pstate.n_audio_ctx   = n_audio_ctx;
+    pstate.n_audio_batch = n_batch;
 
     const int subsampl_factor = pctx.model.hparams.subsampling_factor;
-    const int n_frames_max = (n_audio_ctx + subsampl_factor - 1) / subsampl_factor;
+    const int n_frames_max = (n_audio_ctx + subsampl_factor - 1) / subsampl_factor * n_batch;
     if (n_frames_max > pstate.enc_out->ne[1]) {
         wsp_ggml_backend_buffer_free(pstate.enc_out_buffer);
         pstate.enc_out_buffer = nullptr;
         pstate.enc_out = nullptr;
 
+        // the cached joint graphs still point at the old encoder output
+        parakeet_sched_free(pstate.sched_joint);
+        parakeet_sched_free(pstate.sched_joint_block);
+        pstate.gf_joint       = nullptr;
+        pstate.gf_joint_block = nullptr;
+
+        parakeet_sched_free(pstate.beam.sched_joint);
+        pstate.beam.gf_joint = nullptr;
+
         if (!parakeet_enc_state_init(pstate, pstate.backends[0], pctx.model.hparams.n_audio_state, n_frames_max)) {
             pstate.sched_encode_n_audio_ctx = 0;
             pstate.n_audio_ctx = prev_n_audio_ctx;
@@ -2099,7 +2658,7 @@ static bool parakeet_ensure_encode_sched(
 static struct wsp_ggml_tensor * parakeet_build_graph_lstm_layer(
         struct wsp_ggml_context * ctx0,
          struct wsp_ggml_cgraph * gf,
-         struct wsp_ggml_tensor * x_t,       // the current input token embedding
+         struct wsp_ggml_tensor * x_t,       // the current input token embedding (one column per sequence)
          struct wsp_ggml_tensor * w_ih,      // input to hidden weights (4 weight tensors packed)
          struct wsp_ggml_tensor * w_hh,      // hidden to hidden weights (4 weight tensors packed)
          struct wsp_ggml_tensor * b_h,       // folded ih+hh bias (4 bias tensors packed)
@@ -2125,28 +2684,29 @@ static struct wsp_ggml_tensor * parakeet_build_graph_lstm_layer(
     wsp_ggml_format_name(gates, "lstm_layer_%d_gates", li);
 
     const int h_dim = h_state->ne[0];
+    const int n_seq = x_t->ne[1];
     const size_t row_size = wsp_ggml_row_size(gates->type, h_dim);
 
     // The gates are packed as [i, f, o, c] (reordered at convert time, see
     // parakeet_model_load), so the three sigmoid-gated outputs (i, f, o) are
     // contiguous and can be computed with a single wsp_ggml_sigmoid call.
-    struct wsp_ggml_tensor * ifo = wsp_ggml_sigmoid(ctx0, wsp_ggml_view_1d(ctx0, gates, 3 * h_dim, 0));
+    struct wsp_ggml_tensor * ifo = wsp_ggml_sigmoid(ctx0, wsp_ggml_view_2d(ctx0, gates, 3 * h_dim, n_seq, gates->nb[1], 0));
     wsp_ggml_format_name(ifo, "lstm_layer_%d_ifo", li);
 
     // 1. Input Gate at time t.
-    struct wsp_ggml_tensor * i_t = wsp_ggml_view_1d(ctx0, ifo, h_dim, 0 * row_size);
+    struct wsp_ggml_tensor * i_t = wsp_ggml_view_2d(ctx0, ifo, h_dim, n_seq, ifo->nb[1], 0 * row_size);
     wsp_ggml_format_name(i_t, "lstm_layer_%d_i_t", li);
 
     // Forget gate.
-    struct wsp_ggml_tensor * f_t = wsp_ggml_view_1d(ctx0, ifo, h_dim, 1 * row_size);
+    struct wsp_ggml_tensor * f_t = wsp_ggml_view_2d(ctx0, ifo, h_dim, n_seq, ifo->nb[1], 1 * row_size);
     wsp_ggml_format_name(f_t, "lstm_layer_%d_f_t", li);
 
     // Output gate.
-    struct wsp_ggml_tensor * o_t = wsp_ggml_view_1d(ctx0, ifo, h_dim, 2 * row_size);
+    struct wsp_ggml_tensor * o_t = wsp_ggml_view_2d(ctx0, ifo, h_dim, n_seq, ifo->nb[1], 2 * row_size);
     wsp_ggml_format_name(o_t, "lstm_layer_%d_o_t", li);
 
     // Cell gate.
-    struct wsp_ggml_tensor * c_t = wsp_ggml_tanh(ctx0, wsp_ggml_view_1d(ctx0, gates, h_dim, 3 * row_size));
+    struct wsp_ggml_tensor * c_t = wsp_ggml_tanh(ctx0, wsp_ggml_view_2d(ctx0, gates, h_dim, n_seq, gates->nb[1], 3 * row_size));
     wsp_ggml_format_name(c_t, "lstm_layer_%d_c_t", li);
 
     // Calculate the new cell state.
@@ -2164,27 +2724,29 @@ static struct wsp_ggml_tensor * parakeet_build_graph_lstm_layer(
     return h_new;
 }
 
+// Advance the prediction network by one token for each of the n_seq sequences.
+// The LSTM states are updated in place and the projected output of every
+// sequence is written to the matching column of pred_out.
 static struct wsp_ggml_cgraph * parakeet_build_graph_prediction(
          parakeet_context & pctx,
-           parakeet_state & pstate,
-     const parakeet_batch & batch,
-                    bool   worst_case) {
-    WSP_GGML_UNUSED(worst_case);
+           parakeet_sched & allocr,
+      parakeet_lstm_state & lstm_state,
+   struct wsp_ggml_tensor * pred_out_dst,
+                      int   n_seq) {
     const auto & model   = pctx.model;
     const auto & hparams = model.hparams;
-    const int n_tokens   = batch.n_tokens;
 
     struct wsp_ggml_init_params params = {
-        /*.mem_size   =*/ pstate.sched_decode.meta.size(),
-        /*.mem_buffer =*/ pstate.sched_decode.meta.data(),
+        /*.mem_size   =*/ allocr.meta.size(),
+        /*.mem_buffer =*/ allocr.meta.data(),
         /*.no_alloc   =*/ true,
     };
 
     struct wsp_ggml_context * ctx0 = wsp_ggml_init(params);
-    wsp_ggml_cgraph * gf = wsp_ggml_new_graph_custom(ctx0, PARAKEET_MAX_NODES, false);
+    wsp_ggml_cgraph * gf = wsp_ggml_new_graph_custom(ctx0, PARAKEET_MAX_DECODE_NODES, false);
 
     // Prediction Network
-    struct wsp_ggml_tensor * token = wsp_ggml_new_tensor_1d(ctx0, WSP_GGML_TYPE_I32, n_tokens);
+    struct wsp_ggml_tensor * token = wsp_ggml_new_tensor_1d(ctx0, WSP_GGML_TYPE_I32, n_seq);
     wsp_ggml_set_name(token, "token_inp");
     wsp_ggml_set_input(token);
 
@@ -2197,8 +2759,8 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_prediction(
                 model.prediction.lstm_layer[il].ih_w,
                 model.prediction.lstm_layer[il].hh_w,
                 model.prediction.lstm_layer[il].b_h,
-                pstate.lstm_state.layer[il].h_state,
-                pstate.lstm_state.layer[il].c_state,
+                lstm_state.layer[il].h_state,
+                lstm_state.layer[il].c_state,
                 il);
     }
 
@@ -2210,38 +2772,44 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_prediction(
     pred = wsp_ggml_add(ctx0, pred, model.joint.pred_b);
     wsp_ggml_set_name(pred, "h_pred");
 
-    wsp_ggml_build_forward_expand(gf, wsp_ggml_cpy(ctx0, pred, pstate.pred_out));
+    wsp_ggml_build_forward_expand(gf, wsp_ggml_cpy(ctx0, pred, pred_out_dst));
 
     wsp_ggml_free(ctx0);
 
     return gf;
 }
 
+// Evaluate the joint network for n_frames encoder frames. pred is either a
+// single prediction network output that is shared by all frames, or one
+// column per frame. The logits for each frame are stored in a separate row
+// of the output.
 static struct wsp_ggml_cgraph * parakeet_build_graph_joint(
          parakeet_context & pctx,
            parakeet_state & pstate,
-     const parakeet_batch & batch,
-                     bool   worst_case) {
-    WSP_GGML_UNUSED(worst_case);
+           parakeet_sched & allocr,
+   struct wsp_ggml_tensor * pred,
+                      int   n_frames) {
     const auto & model   = pctx.model;
-    const auto & hparams = model.hparams;
 
     struct wsp_ggml_init_params params = {
-        /*.mem_size   =*/ pstate.sched_decode.meta.size(),
-        /*.mem_buffer =*/ pstate.sched_decode.meta.data(),
+        /*.mem_size   =*/ allocr.meta.size(),
+        /*.mem_buffer =*/ allocr.meta.data(),
         /*.no_alloc   =*/ true,
     };
 
     struct wsp_ggml_context * ctx0 = wsp_ggml_init(params);
-    wsp_ggml_cgraph * gf = wsp_ggml_new_graph_custom(ctx0, PARAKEET_MAX_NODES, false);
+    wsp_ggml_cgraph * gf = wsp_ggml_new_graph_custom(ctx0, PARAKEET_MAX_DECODE_NODES, false);
 
-    struct wsp_ggml_tensor * pred = pstate.pred_out;
     wsp_ggml_format_name(pred, "pred");
 
-    const int t_idx = batch.i_time[0];
-    struct wsp_ggml_tensor * enc_out = wsp_ggml_view_1d(ctx0, pstate.enc_out, hparams.n_audio_state,
-            (size_t) t_idx * pstate.enc_out->nb[1]);
-    wsp_ggml_format_name(enc_out, "enc_out_view");
+    // The encoder frames are selected with input indices instead of a view at
+    // a fixed offset so that the same graph can be replayed for every frame.
+    struct wsp_ggml_tensor * time = wsp_ggml_new_tensor_1d(ctx0, WSP_GGML_TYPE_I32, n_frames);
+    wsp_ggml_set_name(time, "time_inp");
+    wsp_ggml_set_input(time);
+
+    struct wsp_ggml_tensor * enc_out = wsp_ggml_get_rows(ctx0, pstate.enc_out, time);
+    wsp_ggml_format_name(enc_out, "enc_out_frames");
 
     // Project the encoder output to the joint network hidden dimension.
     struct wsp_ggml_tensor * enc  = wsp_ggml_mul_mat(ctx0, model.joint.enc_w, enc_out);
@@ -2269,6 +2837,62 @@ static struct wsp_ggml_cgraph * parakeet_build_graph_joint(
     return gf;
 }
 
+static bool parakeet_ensure_predict_graph(
+        parakeet_context & pctx,
+          parakeet_state & pstate) {
+    if (pstate.gf_predict) {
+        return true;
+    }
+
+    parakeet_sched_free(pstate.sched_predict);
+
+    return parakeet_sched_graph_init_cached(pstate.sched_predict, pstate.gf_predict, pstate.backends,
+            [&]() {
+                return parakeet_build_graph_prediction(pctx, pstate.sched_predict, pstate.lstm_state, pstate.pred_out, 1);
+            });
+}
+
+// The joint graphs reference pstate.enc_out directly, so they have to be rebuilt
+// whenever the encoder output tensor is reallocated (see parakeet_ensure_encode_sched).
+static bool parakeet_ensure_joint_graph(
+        parakeet_context & pctx,
+          parakeet_state & pstate) {
+    if (pstate.gf_joint) {
+        return true;
+    }
+
+    parakeet_sched_free(pstate.sched_joint);
+
+    return parakeet_sched_graph_init_cached(pstate.sched_joint, pstate.gf_joint, pstate.backends,
+            [&]() {
+                return parakeet_build_graph_joint(pctx, pstate, pstate.sched_joint, pstate.pred_out, 1);
+            });
+}
+
+static bool parakeet_ensure_joint_block_graph(
+        parakeet_context & pctx,
+          parakeet_state & pstate,
+                     int   n_block) {
+    if (pstate.gf_joint_block && pstate.n_joint_block == n_block) {
+        return true;
+    }
+
+    parakeet_sched_free(pstate.sched_joint_block);
+    pstate.gf_joint_block = nullptr;
+    pstate.n_joint_block  = 0;
+
+    const bool ok = parakeet_sched_graph_init_cached(pstate.sched_joint_block, pstate.gf_joint_block, pstate.backends,
+            [&]() {
+                return parakeet_build_graph_joint(pctx, pstate, pstate.sched_joint_block, pstate.pred_out, n_block);
+            });
+
+    if (ok) {
+        pstate.n_joint_block = n_block;
+    }
+
+    return ok;
+}
+
 static bool parakeet_predict(
         parakeet_context & pctx,
           parakeet_state & pstate,
@@ -2276,33 +2900,35 @@ static bool parakeet_predict(
                const int   n_threads,
      wsp_ggml_abort_callback   abort_callback,
                    void  * abort_callback_data) {
-
-    const int n_tokens   = batch.n_tokens;
+    // the cached prediction graph processes a single token per call
+    PARAKEET_ASSERT(batch.n_tokens == 1);
 
     const int64_t t_start_us = wsp_ggml_time_us();
 
-    {
-        auto & sched = pstate.sched_decode.sched;
-
-        const int64_t t_build_start_us = wsp_ggml_time_us();
-        wsp_ggml_cgraph * gf = parakeet_build_graph_prediction(pctx, pstate, batch, false);
-        pstate.t_predict_build_us += wsp_ggml_time_us() - t_build_start_us;
+    parakeet_threadpool_prepare(pstate.threadpool, pstate.backends, n_threads);
 
-        const int64_t t_alloc_start_us = wsp_ggml_time_us();
-        if (!wsp_ggml_backend_sched_alloc_graph(sched, gf)) {
-            // should never happen as we pre-allocate the memory
-            return false;
+    {
+        if (!pstate.gf_predict) {
+            const int64_t t_build_start_us = wsp_ggml_time_us();
+            if (!parakeet_ensure_predict_graph(pctx, pstate)) {
+                return false;
+            }
+            pstate.t_predict_build_us += wsp_ggml_time_us() - t_build_start_us;
         }
-        pstate.t_predict_alloc_us += wsp_ggml_time_us() - t_alloc_start_us;
+
+        auto & sched = pstate.sched_predict.sched;
+        wsp_ggml_cgraph * gf = pstate.gf_predict;
 
         // set the inputs
         {
             struct wsp_ggml_tensor * token_inp = wsp_ggml_graph_get_tensor(gf, "token_inp");
-            wsp_ggml_backend_tensor_set(token_inp, batch.token, 0, n_tokens * wsp_ggml_element_size(token_inp));
+            wsp_ggml_backend_tensor_set(token_inp, batch.token, 0, wsp_ggml_element_size(token_inp));
         }
 
         const int64_t t_compute_start_us = wsp_ggml_time_us();
-        if (!wsp_ggml_graph_compute_helper(sched, gf, n_threads)) {
+        if (!wsp_ggml_graph_compute_helper(sched, gf, n_threads, false)) {
+            // the scheduler has been reset, so the graph has to be allocated again
+            pstate.gf_predict = nullptr;
             return false;
         }
         pstate.t_predict_compute_us += wsp_ggml_time_us() - t_compute_start_us;
@@ -2314,39 +2940,70 @@ static bool parakeet_predict(
     return !(abort_callback && abort_callback(abort_callback_data));
 }
 
+// Evaluate the joint network for the encoder frames batch.i_time[0..n_tokens)
+// against the current prediction network output. A single frame uses the
+// single-frame graph, multiple frames use the block graph of n_block frames
+// (the unused tail of the block is padded with the last requested frame).
 static bool parakeet_joint(
          parakeet_context & pctx,
            parakeet_state & pstate,
      const parakeet_batch & batch,
+                      int   n_block,
                 const int   n_threads,
       wsp_ggml_abort_callback   abort_callback,
                      void * abort_callback_data) {
     const int64_t t_start_us = wsp_ggml_time_us();
 
+    parakeet_threadpool_prepare(pstate.threadpool, pstate.backends, n_threads);
+
     const auto & model   = pctx.model;
     const auto & hparams = model.hparams;
     const int n_tokens   = batch.n_tokens;
 
+    PARAKEET_ASSERT(n_tokens >= 1 && (n_tokens == 1 || n_tokens <= n_block));
+
     auto & logits_out = pstate.logits;
 
     struct wsp_ggml_tensor * logits;
 
     {
-        auto & sched = pstate.sched_decode.sched;
+        const bool use_block = n_tokens > 1;
 
-        wsp_ggml_cgraph * gf = parakeet_build_graph_joint(pctx, pstate, batch, false);
+        if (use_block) {
+            if (!parakeet_ensure_joint_block_graph(pctx, pstate, n_block)) {
+                return false;
+            }
+        } else {
+            if (!parakeet_ensure_joint_graph(pctx, pstate)) {
+                return false;
+            }
+        }
 
-        if (!wsp_ggml_backend_sched_alloc_graph(sched, gf)) {
-            // should never happen as we pre-allocate the memory
-            return false;
+        auto & sched = use_block ? pstate.sched_joint_block.sched : pstate.sched_joint.sched;
+        wsp_ggml_cgraph * gf = use_block ? pstate.gf_joint_block : pstate.gf_joint;
+
+        // set the inputs
+        {
+            struct wsp_ggml_tensor * time_inp = wsp_ggml_graph_get_tensor(gf, "time_inp");
+
+            auto & inp_time = pstate.inp_time;
+            inp_time.assign(batch.i_time, batch.i_time + n_tokens);
+            inp_time.resize(time_inp->ne[0], batch.i_time[n_tokens - 1]);
+
+            wsp_ggml_backend_tensor_set(time_inp, inp_time.data(), 0, wsp_ggml_nbytes(time_inp));
         }
 
         logits = wsp_ggml_graph_node(gf, -1);
 
-        if (!wsp_ggml_graph_compute_helper(sched, gf, n_threads)) {
+        if (!wsp_ggml_graph_compute_helper(sched, gf, n_threads, false)) {
+            // the scheduler has been reset, so the graph has to be allocated again
+            if (use_block) {
+                pstate.gf_joint_block = nullptr;
+            } else {
+                pstate.gf_joint = nullptr;
+            }
             return false;
         }
-
     }
 
     const int n_logits = hparams.n_vocab + hparams.n_tdt_durations + 1; // one for the blank token
@@ -2358,11 +3015,184 @@ static bool parakeet_joint(
         wsp_ggml_backend_tensor_get(logits, logits_out.data() + (n_logits*i), sizeof(float)*(n_logits*i), sizeof(float)*n_logits);
     }
 
-    if (batch.n_tokens == 1) {
-        pstate.t_decode_us += wsp_ggml_time_us() - t_start_us;
-        pstate.n_decode++;
+    pstate.t_decode_us += wsp_ggml_time_us() - t_start_us;
+    pstate.n_decode++;
+
+    return !(abort_callback && abort_callback(abort_callback_data));
+}
+
+// Beam search evaluates the prediction and joint networks for all hypotheses
+// in one graph each, with one column per hypothesis.
+static bool parakeet_ensure_beam_graphs(
+        parakeet_context & pctx,
+          parakeet_state & pstate,
+                     int   n_beam) {
+    auto & beam = pstate.beam;
+
+    if (beam.n_beam != n_beam) {
+        const auto & hparams = pctx.model.hparams;
+        if (!parakeet_beam_state_init(beam, pstate.backends[0], hparams.n_pred_layers, hparams.n_pred_dim, n_beam)) {
+            return false;
+        }
+    }
+
+    if (!beam.gf_predict) {
+        parakeet_sched_free(beam.sched_predict);
+
+        const bool ok = parakeet_sched_graph_init_cached(beam.sched_predict, beam.gf_predict, pstate.backends,
+                [&]() {
+                    return parakeet_build_graph_prediction(pctx, beam.sched_predict, beam.lstm_state, beam.pred_out, n_beam);
+                });
+        if (!ok) {
+            return false;
+        }
+    }
+
+    if (!beam.gf_joint) {
+        parakeet_sched_free(beam.sched_joint);
+
+        const bool ok = parakeet_sched_graph_init_cached(beam.sched_joint, beam.gf_joint, pstate.backends,
+                [&]() {
+                    return parakeet_build_graph_joint(pctx, pstate, beam.sched_joint, beam.pred_out, n_beam);
+                });
+        if (!ok) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Advance the prediction network of n hypotheses by one token each.
+// lstm holds the LSTM states of the hypotheses on the host, laid out as
+// [hypothesis][layer][h, c][n_pred_dim], and is updated in place. The projected
+// outputs are written to pred as [hypothesis][n_pred_dim].
+static bool parakeet_predict_beam(
+         parakeet_context & pctx,
+           parakeet_state & pstate,
+    const parakeet_token  * tokens,
+                      int   n,
+                    float * lstm,
+                    float * pred,
+                const int   n_threads,
+      wsp_ggml_abort_callback   abort_callback,
+                     void * abort_callback_data) {
+    const int64_t t_start_us = wsp_ggml_time_us();
+
+    parakeet_threadpool_prepare(pstate.threadpool, pstate.backends, n_threads);
+
+    const auto & hparams = pctx.model.hparams;
+    const int n_layer    = hparams.n_pred_layers;
+    const int n_dim      = hparams.n_pred_dim;
+    const int n_state    = n_layer * 2 * n_dim;
+
+    auto & beam = pstate.beam;
+    const int n_beam = beam.n_beam;
+
+    PARAKEET_ASSERT(n >= 1 && n <= n_beam);
+
+    auto & inp_state = beam.inp_state;
+    auto & inp_token = beam.inp_token;
+
+    // set the inputs
+    {
+        inp_token.assign(n_beam, pctx.vocab.token_blank);
+        std::copy(tokens, tokens + n, inp_token.begin());
+
+        struct wsp_ggml_tensor * token_inp = wsp_ggml_graph_get_tensor(beam.gf_predict, "token_inp");
+        wsp_ggml_backend_tensor_set(token_inp, inp_token.data(), 0, wsp_ggml_nbytes(token_inp));
+
+        inp_state.assign((size_t) n_dim * n_beam, 0.0f);
+        for (int il = 0; il < n_layer; ++il) {
+            for (int is = 0; is < 2; ++is) {
+                for (int j = 0; j < n; ++j) {
+                    const float * src = lstm + (size_t) j * n_state + (size_t) (2*il + is) * n_dim;
+                    std::copy(src, src + n_dim, inp_state.begin() + (size_t) j * n_dim);
+                }
+                struct wsp_ggml_tensor * dst = is == 0 ? beam.lstm_state.layer[il].h_state : beam.lstm_state.layer[il].c_state;
+                wsp_ggml_backend_tensor_set(dst, inp_state.data(), 0, wsp_ggml_nbytes(dst));
+            }
+        }
+    }
+
+    if (!wsp_ggml_graph_compute_helper(beam.sched_predict.sched, beam.gf_predict, n_threads, false)) {
+        beam.gf_predict = nullptr;
+        return false;
+    }
+
+    // read back the updated states and the outputs
+    {
+        for (int il = 0; il < n_layer; ++il) {
+            for (int is = 0; is < 2; ++is) {
+                struct wsp_ggml_tensor * src = is == 0 ? beam.lstm_state.layer[il].h_state : beam.lstm_state.layer[il].c_state;
+                wsp_ggml_backend_tensor_get(src, inp_state.data(), 0, sizeof(float) * n_dim * n);
+                for (int j = 0; j < n; ++j) {
+                    std::copy(inp_state.begin() + (size_t) j * n_dim, inp_state.begin() + (size_t) (j + 1) * n_dim,
+                            lstm + (size_t) j * n_state + (size_t) (2*il + is) * n_dim);
+                }
+            }
+        }
+
+        const int n_pred = beam.pred_out->ne[0];
+        wsp_ggml_backend_tensor_get(beam.pred_out, pred, 0, sizeof(float) * n_pred * n);
+    }
+
+    pstate.t_beam_predict_us += wsp_ggml_time_us() - t_start_us;
+    pstate.n_beam_predict += n;
+
+    return !(abort_callback && abort_callback(abort_callback_data));
+}
+
+// Evaluate the joint network for n hypotheses, each at its own encoder frame
+// times[j] and with its own prediction network output pred[j]. The logits of
+// hypothesis j are written to row j of pstate.logits.
+static bool parakeet_joint_beam(
+         parakeet_context & pctx,
+           parakeet_state & pstate,
+           const int32_t  * times,
+              const float * pred,
+                      int   n,
+                const int   n_threads,
+      wsp_ggml_abort_callback   abort_callback,
+                     void * abort_callback_data) {
+    const int64_t t_start_us = wsp_ggml_time_us();
+
+    parakeet_threadpool_prepare(pstate.threadpool, pstate.backends, n_threads);
+
+    const auto & hparams = pctx.model.hparams;
+
+    auto & beam = pstate.beam;
+    const int n_beam = beam.n_beam;
+
+    PARAKEET_ASSERT(n >= 1 && n <= n_beam);
+
+    // set the inputs
+    {
+        auto & inp_time = beam.inp_time;
+        inp_time.assign(times, times + n);
+        inp_time.resize(n_beam, times[n - 1]);
+
+        struct wsp_ggml_tensor * time_inp = wsp_ggml_graph_get_tensor(beam.gf_joint, "time_inp");
+        wsp_ggml_backend_tensor_set(time_inp, inp_time.data(), 0, wsp_ggml_nbytes(time_inp));
+
+        const int n_pred = beam.pred_out->ne[0];
+        wsp_ggml_backend_tensor_set(beam.pred_out, pred, 0, sizeof(float) * n_pred * n);
+    }
+
+    struct wsp_ggml_tensor * logits = wsp_ggml_graph_node(beam.gf_joint, -1);
+
+    if (!wsp_ggml_graph_compute_helper(beam.sched_joint.sched, beam.gf_joint, n_threads, false)) {
+        beam.gf_joint = nullptr;
+        return false;
     }
 
+    const int n_logits = hparams.n_vocab + hparams.n_tdt_durations + 1; // one for the blank token
+    pstate.logits.resize((size_t) n * n_logits);
+    wsp_ggml_backend_tensor_get(logits, pstate.logits.data(), 0, sizeof(float) * n_logits * n);
+
+    pstate.t_beam_joint_us += wsp_ggml_time_us() - t_start_us;
+    pstate.n_beam_joint += n;
+
     return !(abort_callback && abort_callback(abort_callback_data));
 }
 
@@ -2420,7 +3250,7 @@ static void refine_timestamps_tdt(parakeet_vocab & vocab, std::vector<parakeet_t
 
 static parakeet_token_data create_token_data(
             parakeet_context & pctx,
-              parakeet_state & pstate,
+                 const float * logits,
                parakeet_token   token_id,
                           int   duration_idx,
                           int   duration_value,
@@ -2430,7 +3260,7 @@ static parakeet_token_data create_token_data(
 
     float token_sum = 0.0f;
     for (int i = 0; i < n_vocab_logits; ++i) {
-        token_sum += expf(pstate.logits[i]);
+        token_sum += expf(logits[i]);
     }
     float token_p = expf(token_logit) / token_sum;
 
@@ -2448,25 +3278,403 @@ static parakeet_token_data create_token_data(
     return token_data;
 }
 
+struct parakeet_beam_hyp {
+    std::vector<parakeet_token>      tokens;
+    std::vector<parakeet_token_data> token_data;
+
+    std::vector<float> lstm; // LSTM state, [layer][h, c][n_pred_dim]
+    std::vector<float> pred; // projected prediction network output
+
+    double   score          = 0.0; // sum of the token and duration log probabilities
+    uint64_t hash           = 0;   // hash of the tokens, used for hypothesis merging
+    int      t              = 0;   // current encoder frame
+    int      tokens_emitted = 0;   // number of tokens emitted at frame t
+};
+
+struct parakeet_beam_candidate {
+    int      i_hyp;          // parent hypothesis
+    int      row;            // row of the parent in pstate.logits (-1 if the parent is finished)
+    int      token;          // emitted token, blank, or -1 to keep a finished hypothesis
+    int      duration_idx;
+    int      t;
+    int      tokens_emitted;
+    double   score;
+    uint64_t hash;
+    size_t   n_tokens;
+};
+
+static uint64_t parakeet_beam_hash(uint64_t hash, parakeet_token token) {
+    // FNV-1a over the token ids
+    hash ^= (uint64_t) (uint32_t) token;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+static double parakeet_log_add(double a, double b) {
+    const double m = std::max(a, b);
+    return m + std::log(std::exp(a - m) + std::exp(b - m));
+}
+
+// Beam search for the TDT transducer.
+//
+// Every hypothesis carries its own encoder frame, token sequence and LSTM
+// state. In each step all unfinished hypotheses are expanded with the
+// top-k tokens (including blank) combined with every duration, the joint
+// network being evaluated for all of them in a single batched call.
+// Candidates with the same token sequence that end up at the same frame
+// describe the same prediction network state and are merged by adding their
+// probabilities. The best beam_size candidates are kept and the prediction
+// network is advanced for the ones that emitted a token, again in a single
+// batched call. The search ends when all kept hypotheses reached the end of
+// the encoder output; the hypothesis with the best length-normalized score wins.
+static bool parakeet_decode_beam_search(
+              parakeet_context & pctx,
+                parakeet_state & pstate,
+                     const int   n_threads,
+    const parakeet_full_params & params) {
+    const auto & hparams       = pctx.model.hparams;
+    const auto & tdt_durations = pctx.model.tdt_durations;
+
+    const int  n_tdt_durations          = hparams.n_tdt_durations;
+    const int  n_frames                 = pstate.n_frames;
+    const int  blank_id                 = pctx.vocab.token_blank;
+    const int  n_vocab_logits           = blank_id + 1;
+    const int  n_logits                 = n_vocab_logits + n_tdt_durations;
+    const int  max_tokens_per_timestep = hparams.n_max_tokens;
+    const int  n_state                  = hparams.n_pred_layers * 2 * hparams.n_pred_dim;
+    const int  n_pred                   = hparams.n_pred_dim;
+    const int  beam_size                = std::max(1, std::min(params.beam_search.beam_size, PARAKEET_MAX_BEAMS));
+    const int  n_top_tokens             = std::min(beam_size, n_vocab_logits);
+
+    if (!parakeet_ensure_beam_graphs(pctx, pstate, beam_size)) {
+        PARAKEET_LOG_ERROR("%s: failed to allocate the beam search graphs\n", __func__);
+        return false;
+    }
+
+    std::vector<parakeet_beam_hyp> hyps(1);
+
+    // start from the current prediction network state, like greedy decoding
+    {
+        auto & hyp = hyps[0];
+        hyp.lstm.resize(n_state);
+        hyp.pred.resize(n_pred);
+
+        for (int il = 0; il < hparams.n_pred_layers; ++il) {
+            wsp_ggml_backend_tensor_get(pstate.lstm_state.layer[il].h_state, hyp.lstm.data() + (2*il + 0) * n_pred, 0, sizeof(float) * n_pred);
+            wsp_ggml_backend_tensor_get(pstate.lstm_state.layer[il].c_state, hyp.lstm.data() + (2*il + 1) * n_pred, 0, sizeof(float) * n_pred);
+        }
+
+        const parakeet_token token = blank_id;
+        if (!parakeet_predict_beam(pctx, pstate, &token, 1, hyp.lstm.data(), hyp.pred.data(), n_threads,
+                params.abort_callback, params.abort_callback_user_data)) {
+            return false;
+        }
+    }
+
+    std::vector<parakeet_beam_candidate> candidates;
+    std::vector<int32_t>                 times;
+    std::vector<float>                   preds;
+    std::vector<int>                     rows;
+    std::vector<std::pair<float, int>>   top_tokens;
+    std::vector<double>                  logp_dur(n_tdt_durations);
+
+    std::vector<parakeet_token> pred_tokens;
+    std::vector<float>          pred_lstm;
+    std::vector<float>          pred_out;
+
+    while (true) {
+        // evaluate the joint network for all unfinished hypotheses
+        times.clear();
+        preds.clear();
+        rows.assign(hyps.size(), -1);
+
+        for (size_t i = 0; i < hyps.size(); ++i) {
+            if (hyps[i].t < n_frames) {
+                rows[i] = (int) times.size();
+                times.push_back(hyps[i].t);
+                preds.insert(preds.end(), hyps[i].pred.begin(), hyps[i].pred.end());
+            }
+        }
+
+        if (times.empty()) {
+            break;
+        }
+
+        if (!parakeet_joint_beam(pctx, pstate, times.data(), preds.data(), (int) times.size(), n_threads,
+                params.abort_callback, params.abort_callback_user_data)) {
+            return false;
+        }
+
+        const int64_t t_start_sample_us = wsp_ggml_time_us();
+
+        // expand the hypotheses
+        candidates.clear();
+
+        for (size_t i = 0; i < hyps.size(); ++i) {
+            const auto & hyp = hyps[i];
+
+            if (rows[i] < 0) {
+                candidates.push_back({ (int) i, -1, -1, 0, hyp.t, hyp.tokens_emitted, hyp.score, hyp.hash, hyp.tokens.size() });
+                continue;
+            }
+
+            const float * logits = pstate.logits.data() + (size_t) rows[i] * n_logits;
+
+            // the joint network output is normalized over tokens and durations
+            // together, so normalize both parts separately
+            double max_tok = -INFINITY;
+            for (int k = 0; k < n_vocab_logits; ++k) {
+                max_tok = std::max(max_tok, (double) logits[k]);
+            }
+            double sum_tok = 0.0;
+            for (int k = 0; k < n_vocab_logits; ++k) {
+                sum_tok += std::exp(logits[k] - max_tok);
+            }
+            const double lse_tok = max_tok + std::log(sum_tok);
+
+            double max_dur = -INFINITY;
+            for (int k = 0; k < n_tdt_durations; ++k) {
+                max_dur = std::max(max_dur, (double) logits[n_vocab_logits + k]);
+            }
+            double sum_dur = 0.0;
+            for (int k = 0; k < n_tdt_durations; ++k) {
+                sum_dur += std::exp(logits[n_vocab_logits + k] - max_dur);
+            }
+            const double lse_dur = max_dur + std::log(sum_dur);
+
+            for (int k = 0; k < n_tdt_durations; ++k) {
+                logp_dur[k] = logits[n_vocab_logits + k] - lse_dur;
+            }
+
+            top_tokens.clear();
+            for (int k = 0; k < n_vocab_logits; ++k) {
+                top_tokens.emplace_back(logits[k], k);
+            }
+            std::partial_sort(top_tokens.begin(), top_tokens.begin() + n_top_tokens, top_tokens.end(),
+                    [](const std::pair<float, int> & a, const std::pair<float, int> & b) {
+                        return a.first > b.first;
+                    });
+
+            for (int it = 0; it < n_top_tokens; ++it) {
+                const int    token    = top_tokens[it].second;
+                const double logp_tok = top_tokens[it].first - lse_tok;
+
+                for (int k = 0; k < n_tdt_durations; ++k) {
+                    const int duration = tdt_durations[k];
+
+                    parakeet_beam_candidate cand;
+                    cand.i_hyp        = (int) i;
+                    cand.row          = rows[i];
+                    cand.token        = token;
+                    cand.duration_idx = k;
+                    cand.score        = hyp.score + logp_tok + logp_dur[k];
+
+                    if (token == blank_id) {
+                        // blanks always advance by at least one frame
+                        cand.t              = hyp.t + std::max(1, duration);
+                        cand.tokens_emitted = 0;
+                        cand.hash           = hyp.hash;
+                        cand.n_tokens       = hyp.tokens.size();
+                    } else {
+                        if (duration > 0) {
+                            cand.t              = hyp.t + duration;
+                            cand.tokens_emitted = 0;
+                        } else if (hyp.tokens_emitted + 1 >= max_tokens_per_timestep) {
+                            cand.t              = hyp.t + 1; // forced time advance, same as greedy
+                            cand.tokens_emitted = 0;
+                        } else {
+                            cand.t              = hyp.t;
+                            cand.tokens_emitted = hyp.tokens_emitted + 1;
+                        }
+                        cand.hash     = parakeet_beam_hash(hyp.hash, token);
+                        cand.n_tokens = hyp.tokens.size() + 1;
+                    }
+
+                    cand.t = std::min(cand.t, n_frames);
+
+                    candidates.push_back(cand);
+                }
+            }
+        }
+
+        // merge candidates with the same token sequence at the same frame
+        std::sort(candidates.begin(), candidates.end(),
+                [](const parakeet_beam_candidate & a, const parakeet_beam_candidate & b) {
+                    return a.score > b.score;
+                });
+
+        std::vector<parakeet_beam_candidate> merged;
+        for (const auto & cand : candidates) {
+            bool found = false;
+            for (auto & m : merged) {
+                if (m.hash == cand.hash && m.n_tokens == cand.n_tokens && m.t == cand.t && m.tokens_emitted == cand.tokens_emitted) {
+                    m.score = parakeet_log_add(m.score, cand.score);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                merged.push_back(cand);
+            }
+        }
+
+        std::sort(merged.begin(), merged.end(),
+                [](const parakeet_beam_candidate & a, const parakeet_beam_candidate & b) {
+                    return a.score > b.score;
+                });
+        if ((int) merged.size() > beam_size) {
+            merged.resize(beam_size);
+        }
+
+        // build the new hypotheses
+        std::vector<parakeet_beam_hyp> next(merged.size());
+
+        pred_tokens.clear();
+        pred_lstm.clear();
+
+        for (size_t j = 0; j < merged.size(); ++j) {
+            const auto & cand = merged[j];
+            auto & hyp = next[j];
+
+            hyp = hyps[cand.i_hyp];
+            hyp.score          = cand.score;
+            hyp.hash           = cand.hash;
+            hyp.t              = cand.t;
+            hyp.tokens_emitted = cand.tokens_emitted;
+
+            if (cand.token < 0 || cand.token == blank_id) {
+                continue;
+            }
+
+            const float * logits = pstate.logits.data() + (size_t) cand.row * n_logits;
+            const int     t_prev = hyps[cand.i_hyp].t;
+
+            hyp.tokens.push_back(cand.token);
+            hyp.token_data.push_back(create_token_data(pctx, logits, cand.token, cand.duration_idx,
+                    tdt_durations[cand.duration_idx], t_prev, logits[cand.token], n_vocab_logits));
+
+            pred_tokens.push_back(cand.token);
+            pred_lstm.insert(pred_lstm.end(), hyp.lstm.begin(), hyp.lstm.end());
+        }
+
+        pstate.t_sample_us += wsp_ggml_time_us() - t_start_sample_us;
+
+        // advance the prediction network of the hypotheses that emitted a token
+        if (!pred_tokens.empty()) {
+            const int n = (int) pred_tokens.size();
+            pred_out.resize((size_t) n * n_pred);
+
+            if (!parakeet_predict_beam(pctx, pstate, pred_tokens.data(), n, pred_lstm.data(), pred_out.data(), n_threads,
+                    params.abort_callback, params.abort_callback_user_data)) {
+                return false;
+            }
+
+            int k = 0;
+            for (size_t j = 0; j < merged.size(); ++j) {
+                if (merged[j].token < 0 || merged[j].token == blank_id) {
+                    continue;
+                }
+                auto & hyp = next[j];
+                std::copy(pred_lstm.begin() + (size_t) k * n_state, pred_lstm.begin() + (size_t) (k + 1) * n_state, hyp.lstm.begin());
+                std::copy(pred_out.begin()  + (size_t) k * n_pred,  pred_out.begin()  + (size_t) (k + 1) * n_pred,  hyp.pred.begin());
+                ++k;
+            }
+        }
+
+        hyps = std::move(next);
+    }
+
+    // pick the best hypothesis, normalizing the score by the sequence length
+    // so that longer transcriptions are not penalized
+    size_t i_best = 0;
+    double best_score = -INFINITY;
+    for (size_t i = 0; i < hyps.size(); ++i) {
+        const double score = hyps[i].score / (double) (hyps[i].tokens.size() + 1);
+        if (score > best_score) {
+            best_score = score;
+            i_best = i;
+        }
+    }
+
+    const auto & best = hyps[i_best];
+
+    for (size_t i = 0; i < best.tokens.size(); ++i) {
+        pstate.decoded_tokens.push_back(best.tokens[i]);
+        pstate.decoded_token_data.push_back(best.token_data[i]);
+        pstate.n_sample++;
+
+        if (params.new_token_callback) {
+            parakeet_token_data token_data = best.token_data[i];
+            params.new_token_callback(&pctx, &pstate, &token_data, params.new_token_callback_user_data);
+        }
+    }
+
+    // keep the prediction network state of the best hypothesis, so that
+    // decoding can continue from it like after greedy decoding
+    for (int il = 0; il < hparams.n_pred_layers; ++il) {
+        wsp_ggml_backend_tensor_set(pstate.lstm_state.layer[il].h_state, best.lstm.data() + (2*il + 0) * n_pred, 0, sizeof(float) * n_pred);
+        wsp_ggml_backend_tensor_set(pstate.lstm_state.layer[il].c_state, best.lstm.data() + (2*il + 1) * n_pred, 0, sizeof(float) * n_pred);
+    }
+    wsp_ggml_backend_tensor_set(pstate.pred_out, best.pred.data(), 0, sizeof(float) * n_pred);
+
+    return true;
+}
+
+// Position of the greedy decoder within the encoder output. Streaming keeps
+// one of these across encoder windows so that decoding continues from the
+// last time frame instead of starting over.
+struct parakeet_decode_cursor {
+    int  t              = 0;     // next encoder frame, relative to enc_out
+    int  t_end          = 0;     // decode the frames [t, t_end) of enc_out
+    int  t_offset       = 0;     // absolute index of enc_out frame 0, used for timestamps
+    int  tokens_emitted = 0;     // symbols emitted for frame t so far
+    bool primed         = false; // the prediction network has consumed the start blank
+};
+
 static bool parakeet_decode(
               parakeet_context & pctx,
                 parakeet_state & pstate,
                 parakeet_batch & batch,
                      const int   n_threads,
-    const parakeet_full_params * params = nullptr) {
+    const parakeet_full_params * params = nullptr,
+        parakeet_decode_cursor * cursor = nullptr) {
+    if (!cursor && params && params->strategy == PARAKEET_SAMPLING_BEAM_SEARCH && params->beam_search.beam_size > 1) {
+        return parakeet_decode_beam_search(pctx, pstate, n_threads, *params);
+    }
+
+    parakeet_decode_cursor cursor_full;
+    if (!cursor) {
+        cursor_full.t_end = pstate.n_frames;
+        cursor = &cursor_full;
+    }
+
     const auto & hparams       = pctx.model.hparams;
     const auto & tdt_durations = pctx.model.tdt_durations;
 
     const int  n_tdt_durations          = hparams.n_tdt_durations;
-    const int  n_frames                 = pstate.n_frames;
+    const int  n_frames                 = cursor->t_end;
     const int  blank_id                 = pctx.vocab.token_blank;
     const int  n_vocab_logits           = blank_id + 1;
+    const int  n_logits                 = n_vocab_logits + n_tdt_durations;
     const int  max_tokens_per_timestep = hparams.n_max_tokens;
 
+    // While the decoder is emitting blanks the prediction network output does
+    // not change, so the joint network is evaluated for a block of upcoming
+    // frames at once and the greedy/TDT logic walks over the cached logits.
+    const int  n_block = std::max(1, std::min(params ? params->n_joint_block : 1, hparams.n_audio_ctx));
+
+    // encoder frames [block_t0, block_t0 + block_n) have logits in pstate.logits
+    // computed against the current prediction network output
+    int block_t0 = 0;
+    int block_n  = 0;
+
+    // the last joint evaluation at the current prediction output was a blank
+    bool prev_blank = false;
+
     // time index into the encoder frame (current time frame)
-    int t = 0;
+    int t = cursor->t;
     // number of symbols emitted for the current time frame
-    int tokens_emitted = 0;
+    int tokens_emitted = cursor->tokens_emitted;
 
     // Start with the blank token (8192)
     parakeet_token last_token = blank_id;
@@ -2480,40 +3688,57 @@ static bool parakeet_decode(
 
     // run the prediction network for the initial blank token. This will
     // initialize the LSTM state and produce an initial hidden state that can
-    // be used in the joint network below.
-    if (!parakeet_predict(pctx, pstate, batch, n_threads,
-            params ? params->abort_callback           : nullptr,
-            params ? params->abort_callback_user_data : nullptr)) {
-        return false;
+    // be used in the joint network below. A resumed cursor already has the
+    // prediction output of its last emitted token in pstate.pred_out.
+    if (!cursor->primed) {
+        if (!parakeet_predict(pctx, pstate, batch, n_threads,
+                params ? params->abort_callback           : nullptr,
+                params ? params->abort_callback_user_data : nullptr)) {
+            return false;
+        }
+        cursor->primed = true;
     }
 
     // process all time frames of the encoder output
     while (t < n_frames) {
-        batch.n_tokens  = 1;
-        batch.i_time[0] = t;
-        batch.logits[0] = 1;
-
-        // Use the current encoder frame (t) and the output of the prediction to
-        // generate probabilities for the next token and duration. batch.i_time
-        // is used in to select the correct frame from the encoder output.
-        // The joint network outputs logits for all the tokens in the vocabulary
-        // plus the blank token, and also n_duration logits for the duration
-        // tokens which contain information about how many frames to skip/advance forward.
-        if (!parakeet_joint(pctx, pstate, batch, n_threads,
-                params ? params->abort_callback           : nullptr,
-                params ? params->abort_callback_user_data : nullptr)) {
-            return false;
+        if (t < block_t0 || t >= block_t0 + block_n) {
+            // Only look ahead once a blank has been seen at the current
+            // prediction output; right after a non-blank token the next
+            // frame is likely to emit again, which would discard the block.
+            const int n_eval = prev_blank ? std::min(n_block, n_frames - t) : 1;
+
+            batch.n_tokens = n_eval;
+            for (int i = 0; i < n_eval; ++i) {
+                batch.i_time[i] = t + i;
+                batch.logits[i] = 1;
+            }
+
+            // Use the current encoder frame (t) and the output of the prediction to
+            // generate probabilities for the next token and duration. batch.i_time
+            // is used in to select the correct frames from the encoder output.
+            // The joint network outputs logits for all the tokens in the vocabulary
+            // plus the blank token, and also n_duration logits for the duration
+            // tokens which contain information about how many frames to skip/advance forward.
+            if (!parakeet_joint(pctx, pstate, batch, n_block, n_threads,
+                    params ? params->abort_callback           : nullptr,
+                    params ? params->abort_callback_user_data : nullptr)) {
+                return false;
+            }
+
+            block_t0 = t;
+            block_n  = n_eval;
         }
 
+        const float * logits = pstate.logits.data() + (size_t) (t - block_t0) * n_logits;
+
         const int64_t t_start_sample_us = wsp_ggml_time_us();
 
         // find the best token (greedy).
-        // TODO: implement beam search?
         int best_token = 0;
         float max_logit = -1e10f;
         for (int i = 0; i < n_vocab_logits; ++i) {
-            if (pstate.logits[i] > max_logit) {
-                max_logit = pstate.logits[i];
+            if (logits[i] > max_logit) {
+                max_logit = logits[i];
                 best_token = i;
             }
         }
@@ -2523,8 +3748,8 @@ static bool parakeet_decode(
         int best_duration_idx = 0;
         float best_duration_logit = -1e10f;
         for (int i = 0; i < n_tdt_durations; ++i) {
-            if (pstate.logits[n_vocab_logits + i] > best_duration_logit) {
-                best_duration_logit = pstate.logits[n_vocab_logits + i];
+            if (logits[n_vocab_logits + i] > best_duration_logit) {
+                best_duration_logit = logits[n_vocab_logits + i];
                 best_duration_idx = i;
             }
         }
@@ -2540,6 +3765,7 @@ static bool parakeet_decode(
             t += duration;
             // reset symbols emitted counter
             tokens_emitted = 0;
+            prev_blank = true;
             // continue without predicting.
             continue;
         }
@@ -2550,7 +3776,7 @@ static bool parakeet_decode(
         pstate.n_sample++;
 
         parakeet_token_data token_data = create_token_data(
-            pctx, pstate, best_token, best_duration_idx, duration, t,
+            pctx, logits, best_token, best_duration_idx, duration, cursor->t_offset + t,
             max_logit, n_vocab_logits);
 
         pstate.decoded_token_data.push_back(token_data);
@@ -2562,7 +3788,12 @@ static bool parakeet_decode(
 
         last_token = best_token;
 
-        // advance predictor for the non-blank token.
+        // advance predictor for the non-blank token, which invalidates the
+        // logits of the current block.
+        block_n    = 0;
+        prev_blank = false;
+
+        batch.n_tokens = 1;
         batch.token[0] = last_token;
         if (!parakeet_predict(pctx, pstate, batch, n_threads,
                 params ? params->abort_callback           : nullptr,
@@ -2586,13 +3817,177 @@ static bool parakeet_decode(
         }
     }
 
+    cursor->t              = t;
+    cursor->tokens_emitted = tokens_emitted;
+
     return true;
 }
 
-//  500 -> 00:05.000
-// 6000 -> 01:00.000
-// naive Discrete Fourier Transform
-// input is real-valued
+// Greedy TDT decoding of the n_batch utterances of a batched encoder pass, in
+// lock-step. Utterance b uses the encoder frames [b*n_frames, b*n_frames + t_end[b])
+// of enc_out. In every step the joint network is evaluated for all utterances
+// that still have frames left, and the prediction network is advanced for all
+// utterances that emitted a token, each with one graph call through the beam
+// search graphs. The decoded tokens of utterance b are stored in hyps[b].
+static bool parakeet_decode_batch(
+              parakeet_context & pctx,
+                parakeet_state & pstate,
+                     const int   n_threads,
+    const parakeet_full_params & params,
+        const std::vector<int> & t_end,
+  std::vector<parakeet_beam_hyp> & hyps) {
+    const auto & hparams       = pctx.model.hparams;
+    const auto & tdt_durations = pctx.model.tdt_durations;
+
+    const int n_batch                 = (int) t_end.size();
+    const int n_tdt_durations         = hparams.n_tdt_durations;
+    const int blank_id                = pctx.vocab.token_blank;
+    const int n_vocab_logits          = blank_id + 1;
+    const int n_logits                = n_vocab_logits + n_tdt_durations;
+    const int max_tokens_per_timestep = hparams.n_max_tokens;
+    const int n_state                 = hparams.n_pred_layers * 2 * hparams.n_pred_dim;
+
+    if (!parakeet_ensure_beam_graphs(pctx, pstate, n_batch)) {
+        return false;
+    }
+
+    const int n_pred = pstate.beam.pred_out->ne[0];
+
+    hyps.assign(n_batch, parakeet_beam_hyp());
+
+    // host staging for the utterances evaluated in a step
+    std::vector<int>            idx;
+    std::vector<int32_t>        times;
+    std::vector<parakeet_token> tokens;
+    std::vector<float>          lstm;
+    std::vector<float>          pred((size_t) n_batch * n_pred);
+
+    // prime the prediction network of all utterances with the start blank
+    {
+        tokens.assign(n_batch, blank_id);
+        lstm.assign((size_t) n_batch * n_state, 0.0f);
+
+        if (!parakeet_predict_beam(pctx, pstate, tokens.data(), n_batch, lstm.data(), pred.data(), n_threads,
+                params.abort_callback, params.abort_callback_user_data)) {
+            return false;
+        }
+
+        for (int b = 0; b < n_batch; ++b) {
+            hyps[b].lstm.assign(lstm.begin() + (size_t) b * n_state, lstm.begin() + (size_t) (b + 1) * n_state);
+            hyps[b].pred.assign(pred.begin() + (size_t) b * n_pred,  pred.begin() + (size_t) (b + 1) * n_pred);
+        }
+    }
+
+    for (;;) {
+        idx.clear();
+        times.clear();
+        for (int b = 0; b < n_batch; ++b) {
+            if (hyps[b].t < t_end[b]) {
+                idx.push_back(b);
+                times.push_back(b * pstate.n_frames + hyps[b].t);
+            }
+        }
+
+        if (idx.empty()) {
+            break;
+        }
+
+        const int n_active = (int) idx.size();
+
+        for (int j = 0; j < n_active; ++j) {
+            std::copy(hyps[idx[j]].pred.begin(), hyps[idx[j]].pred.end(), pred.begin() + (size_t) j * n_pred);
+        }
+
+        if (!parakeet_joint_beam(pctx, pstate, times.data(), pred.data(), n_active, n_threads,
+                params.abort_callback, params.abort_callback_user_data)) {
+            return false;
+        }
+
+        const int64_t t_start_sample_us = wsp_ggml_time_us();
+
+        // utterances that emitted a token and need a prediction network step
+        int n_emit = 0;
+
+        for (int j = 0; j < n_active; ++j) {
+            auto & hyp = hyps[idx[j]];
+
+            const float * logits = pstate.logits.data() + (size_t) j * n_logits;
+
+            int best_token = 0;
+            float max_logit = -1e10f;
+            for (int i = 0; i < n_vocab_logits; ++i) {
+                if (logits[i] > max_logit) {
+                    max_logit = logits[i];
+                    best_token = i;
+                }
+            }
+
+            int best_duration_idx = 0;
+            float best_duration_logit = -1e10f;
+            for (int i = 0; i < n_tdt_durations; ++i) {
+                if (logits[n_vocab_logits + i] > best_duration_logit) {
+                    best_duration_logit = logits[n_vocab_logits + i];
+                    best_duration_idx = i;
+                }
+            }
+            int duration = tdt_durations[best_duration_idx];
+
+            if (best_token == blank_id) {
+                hyp.t += std::max(duration, 1);
+                hyp.tokens_emitted = 0;
+                continue;
+            }
+
+            hyp.tokens.push_back(best_token);
+            hyp.token_data.push_back(create_token_data(
+                pctx, logits, best_token, best_duration_idx, duration, hyp.t, max_logit, n_vocab_logits));
+            pstate.n_sample++;
+
+            // the frame is advanced now, the prediction network step below
+            // does not depend on it
+            if (duration > 0) {
+                hyp.t += duration;
+                hyp.tokens_emitted = 0;
+            } else if (++hyp.tokens_emitted >= max_tokens_per_timestep) {
+                hyp.t += 1; // forced blank/time advance behavior
+                hyp.tokens_emitted = 0;
+            }
+
+            idx[n_emit++] = idx[j];
+        }
+
+        pstate.t_sample_us += wsp_ggml_time_us() - t_start_sample_us;
+
+        if (n_emit == 0) {
+            continue;
+        }
+
+        tokens.resize(n_emit);
+        for (int j = 0; j < n_emit; ++j) {
+            const auto & hyp = hyps[idx[j]];
+            tokens[j] = hyp.tokens.back();
+            std::copy(hyp.lstm.begin(), hyp.lstm.end(), lstm.begin() + (size_t) j * n_state);
+        }
+
+        if (!parakeet_predict_beam(pctx, pstate, tokens.data(), n_emit, lstm.data(), pred.data(), n_threads,
+                params.abort_callback, params.abort_callback_user_data)) {
+            return false;
+        }
+
+        for (int j = 0; j < n_emit; ++j) {
+            auto & hyp = hyps[idx[j]];
+            std::copy(lstm.begin() + (size_t) j * n_state, lstm.begin() + (size_t) (j + 1) * n_state, hyp.lstm.begin());
+            std::copy(pred.begin() + (size_t) j * n_pred,  pred.begin() + (size_t) (j + 1) * n_pred,  hyp.pred.begin());
+        }
+    }
+
+    return true;
+}
+
+//  500 -> 00:05.000
+// 6000 -> 01:00.000
+// naive Discrete Fourier Transform
+// input is real-valued
 // output is complex-valued
 static void dft(const float* in, int N, float* out, const parakeet_mel_cache & cache) {
     const int sin_cos_step = cache.n_fft / N;
@@ -2941,7 +4336,7 @@ struct parakeet_state * parakeet_init_state(parakeet_context * ctx) {
     }
     state->sched_encode_n_audio_ctx = state->n_audio_ctx > 0 ? state->n_audio_ctx : ctx->model.hparams.n_audio_ctx;
 
-    if (!parakeet_lstm_state_init(*state, state->backends[0], ctx->model.hparams.n_pred_layers, ctx->model.hparams.n_pred_dim)) {
+    if (!parakeet_lstm_state_init(state->lstm_state, state->backends[0], ctx->model.hparams.n_pred_layers, ctx->model.hparams.n_pred_dim)) {
         PARAKEET_LOG_ERROR("%s: parakeet_lstm_states_init () failed\n", __func__);
         parakeet_free_state(state);
         return nullptr;
@@ -2969,24 +4364,22 @@ struct parakeet_state * parakeet_init_state(parakeet_context * ctx) {
 
     PARAKEET_LOG_INFO("%s: compute buffer (encode) = %7.2f MB\n", __func__, parakeet_sched_size(state->sched_encode) / 1e6);
 
+    // prediction/joint graphs
     {
-        bool ok = parakeet_sched_graph_init(state->sched_decode, state->backends,
-                [&]() {
-                    const auto & hparams = ctx->model.hparams;
-                    const int n_tokens = hparams.n_audio_ctx; // Use audio ctx for Parakeet
-
-                    parakeet_batch_prep_legacy(state->batch, nullptr, n_tokens, 0, 0);
-
-                    return parakeet_build_graph_prediction(*ctx, *state, state->batch, true);
-                });
+        if (!parakeet_ensure_predict_graph(*ctx, *state)) {
+            PARAKEET_LOG_ERROR("%s: failed to init prediction allocator\n", __func__);
+            parakeet_free_state(state);
+            return nullptr;
+        }
 
-        if (!ok) {
-            PARAKEET_LOG_ERROR("%s: failed to init decoder allocator\n", __func__);
+        if (!parakeet_ensure_joint_graph(*ctx, *state)) {
+            PARAKEET_LOG_ERROR("%s: failed to init joint allocator\n", __func__);
             parakeet_free_state(state);
             return nullptr;
         }
 
-        PARAKEET_LOG_INFO("%s: compute buffer (decode) = %7.2f MB\n", __func__, parakeet_sched_size(state->sched_decode) / 1e6);
+        PARAKEET_LOG_INFO("%s: compute buffer (decode) = %7.2f MB\n", __func__,
+                (parakeet_sched_size(state->sched_predict) + parakeet_sched_size(state->sched_joint)) / 1e6);
     }
 
     return state;
@@ -2996,12 +4389,42 @@ struct parakeet_context_params parakeet_context_default_params() {
     struct parakeet_context_params result = {
         /*.use_gpu              =*/ true,
         /*.gpu_device           =*/ 0,
+        /*.use_mmap             =*/ false,
     };
     return result;
 }
 
 struct parakeet_context * parakeet_init_from_file_with_params_no_state(const char * path_model, struct parakeet_context_params params) {
     PARAKEET_LOG_INFO("%s: loading model from '%s'\n", __func__, path_model);
+
+    if (params.use_mmap) {
+        auto mapping = parakeet_mmap::open(path_model);
+        if (mapping) {
+            parakeet_model_loader loader = {};
+
+            loader.context = mapping.get();
+            loader.read = parakeet_mmap_read;
+
+            loader.eof = [](void * ctx) {
+                parakeet_mmap * mapping = (parakeet_mmap *) ctx;
+                return mapping->pos >= mapping->size;
+            };
+
+            loader.close = [](void * /*ctx*/) { };
+
+            auto ctx = parakeet_init_with_params_no_state(&loader, params);
+
+            if (ctx) {
+                ctx->path_model = path_model;
+                if (ctx->model.buffer_mapped) {
+                    ctx->model.mapping = std::move(mapping);
+                }
+            }
+
+            return ctx;
+        }
+        PARAKEET_LOG_WARN("%s: failed to map '%s', reading it instead\n", __func__, path_model);
+    }
 #ifdef _MSC_VER
     // Convert UTF-8 path to wide string (UTF-16) for Windows, resolving character encoding issues.
     std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
@@ -3162,6 +4585,16 @@ struct parakeet_context * parakeet_init_with_params(struct parakeet_model_loader
     return ctx;
 }
 
+void parakeet_attach_threadpool(struct parakeet_context * ctx, wsp_ggml_threadpool_t threadpool) {
+    parakeet_attach_threadpool_with_state(ctx, ctx->state, threadpool);
+}
+
+void parakeet_attach_threadpool_with_state(struct parakeet_context * ctx, struct parakeet_state * state, wsp_ggml_threadpool_t threadpool) {
+    WSP_GGML_UNUSED(ctx);
+
+    parakeet_threadpool_attach(state->threadpool, state->backends, threadpool);
+}
+
 void parakeet_free_state(struct parakeet_state * state) {
     if (state) {
         wsp_ggml_backend_buffer_free(state->lstm_state.buffer);
@@ -3171,12 +4604,18 @@ void parakeet_free_state(struct parakeet_state * state) {
         parakeet_batch_free(state->batch);
 
         parakeet_sched_free(state->sched_encode);
-        parakeet_sched_free(state->sched_decode);
+        parakeet_sched_free(state->sched_predict);
+        parakeet_sched_free(state->sched_joint);
+        parakeet_sched_free(state->sched_joint_block);
+
+        parakeet_beam_state_free(state->beam);
 
         for (auto & backend : state->backends) {
             wsp_ggml_backend_free(backend);
         }
 
+        parakeet_threadpool_free_owned(state->threadpool);
+
         delete state;
     }
 }
@@ -3263,6 +4702,11 @@ int parakeet_set_mel(
 }
 
 int parakeet_encode_with_state(struct parakeet_context * ctx, struct parakeet_state * state, int offset, int n_threads) {
+    if (state->n_audio_batch != 1 && !parakeet_ensure_encode_sched(*ctx, *state, state->sched_encode_n_audio_ctx)) {
+        PARAKEET_LOG_ERROR("%s: failed to allocate encoder graph\n", __func__);
+        return -1;
+    }
+
     if (!parakeet_encode_internal(*ctx, *state, offset, n_threads, nullptr, nullptr)) {
         PARAKEET_LOG_ERROR("%s: failed to eval\n", __func__);
         return -1;
@@ -3272,12 +4716,7 @@ int parakeet_encode_with_state(struct parakeet_context * ctx, struct parakeet_st
 }
 
 int parakeet_encode(struct parakeet_context * ctx, int offset, int n_threads) {
-    if (!parakeet_encode_internal(*ctx, *ctx->state, offset, n_threads, nullptr, nullptr)) {
-        PARAKEET_LOG_ERROR("%s: failed to eval\n", __func__);
-        return -1;
-    }
-
-    return 0;
+    return parakeet_encode_with_state(ctx, ctx->state, offset, n_threads);
 }
 
 int parakeet_tokenize(struct parakeet_context * ctx, const char * text, parakeet_token * tokens, int n_max_tokens) {
@@ -3393,6 +4832,8 @@ struct parakeet_timings * parakeet_get_timings(struct parakeet_context * ctx) {
     timings->sample_ms = 1e-3f * ctx->state->t_sample_us / std::max(1, ctx->state->n_sample);
     timings->encode_ms = 1e-3f * ctx->state->t_encode_us / std::max(1, ctx->state->n_encode);
     timings->decode_ms = 1e-3f * ctx->state->t_decode_us / std::max(1, ctx->state->n_decode);
+    timings->beam_predict_ms = 1e-3f * ctx->state->t_beam_predict_us / std::max(1, ctx->state->n_beam_predict);
+    timings->beam_joint_ms   = 1e-3f * ctx->state->t_beam_joint_us   / std::max(1, ctx->state->n_beam_joint);
     return timings;
 }
 
@@ -3417,6 +4858,13 @@ void parakeet_print_timings(struct parakeet_context * ctx) {
         PARAKEET_LOG_INFO("%s:    - build     = %8.2f ms / %5d runs ( %8.2f ms per run)\n", __func__, 1e-3f * ctx->state->t_predict_build_us, n_predict, 1e-3f * ctx->state->t_predict_build_us / n_predict);
         PARAKEET_LOG_INFO("%s:    - alloc     = %8.2f ms / %5d runs ( %8.2f ms per run)\n", __func__, 1e-3f * ctx->state->t_predict_alloc_us, n_predict, 1e-3f * ctx->state->t_predict_alloc_us / n_predict);
         PARAKEET_LOG_INFO("%s:    - compute   = %8.2f ms / %5d runs ( %8.2f ms per run)\n", __func__, 1e-3f * ctx->state->t_predict_compute_us, n_predict, 1e-3f * ctx->state->t_predict_compute_us / n_predict);
+        if (ctx->state->n_beam_predict > 0 || ctx->state->n_beam_joint > 0) {
+            const int32_t n_beam_predict = std::max(1, ctx->state->n_beam_predict);
+            const int32_t n_beam_joint   = std::max(1, ctx->state->n_beam_joint);
+
+            PARAKEET_LOG_INFO("%s:  beam predict = %8.2f ms / %5d hyps ( %8.2f ms per hyp)\n", __func__, 1e-3f * ctx->state->t_beam_predict_us, n_beam_predict, 1e-3f * ctx->state->t_beam_predict_us / n_beam_predict);
+            PARAKEET_LOG_INFO("%s:    beam joint = %8.2f ms / %5d hyps ( %8.2f ms per hyp)\n", __func__, 1e-3f * ctx->state->t_beam_joint_us, n_beam_joint, 1e-3f * ctx->state->t_beam_joint_us / n_beam_joint);
+        }
 
     }
     PARAKEET_LOG_INFO("%s:    total time = %8.2f ms\n", __func__, (t_end_us - ctx->t_start_us)/1000.0f);
@@ -3433,7 +4881,11 @@ void parakeet_reset_timings(struct parakeet_context * ctx) {
         ctx->state->t_predict_build_us = 0;
         ctx->state->t_predict_alloc_us = 0;
         ctx->state->t_predict_compute_us = 0;
+        ctx->state->t_beam_predict_us = 0;
+        ctx->state->t_beam_joint_us = 0;
 
+        ctx->state->n_beam_predict = 0;
+        ctx->state->n_beam_joint = 0;
         ctx->state->n_sample = 0;
         ctx->state->n_encode = 0;
         ctx->state->n_decode = 0;
@@ -3489,6 +4941,12 @@ struct parakeet_full_params parakeet_full_default_params(enum parakeet_sampling_
         /*.duration_ms                      =*/ 0,
         /*.no_context                       =*/ true,
         /*.audio_ctx                        =*/ 0,
+        /*.n_joint_block                    =*/ 16,
+        /*.n_batch                          =*/ 8,
+        /*.n_stream_left_ctx                =*/ PARAKEET_LOCAL_ATTN_WINDOW,
+        /*.beam_search                      =*/ {
+            /*.beam_size                    =*/ 4,
+        },
         /*.new_token_callback               =*/ nullptr,
         /*.new_token_callback_user_data     =*/ nullptr,
         /*.new_segment_callback             =*/ nullptr,
@@ -3514,6 +4972,70 @@ static void parakeet_reset_state(struct parakeet_state * state) {
 
 }
 
+// Build a text segment from n decoded tokens. Returns false if the tokens
+// produce no text.
+static bool parakeet_build_segment(
+      struct parakeet_context   * ctx,
+     const parakeet_token_data  * token_data,
+                        size_t    n,
+                          bool    is_first,
+                       int64_t    t0,
+                       int64_t    t1,
+              parakeet_segment  & segment) {
+    std::string text;
+    std::vector<parakeet_token_data> result_tokens;
+
+    for (size_t i = 0; i < n; i++) {
+        const char * token_str = parakeet_token_to_str(ctx, token_data[i].id);
+        if (token_str) {
+            const bool is_first_piece = is_first && text.empty();
+            text += sentencepiece_piece_to_text(token_str, is_first_piece);
+        }
+
+        result_tokens.push_back(token_data[i]);
+    }
+
+    refine_timestamps_tdt(ctx->vocab, result_tokens);
+
+    if (text.empty()) {
+        return false;
+    }
+
+    segment.t0 = t0;
+    segment.t1 = t1;
+    segment.text = std::move(text);
+    segment.tokens = std::move(result_tokens);
+
+    return true;
+}
+
+// Collect the tokens decoded since tokens_before into a new text segment.
+static void parakeet_push_segment(
+      struct parakeet_context   * ctx,
+        struct parakeet_state   * state,
+    const parakeet_full_params  & params,
+                        size_t    tokens_before,
+                       int64_t    t0,
+                       int64_t    t1) {
+    const size_t tokens_after = state->decoded_tokens.size();
+    if (tokens_after == tokens_before) {
+        return;
+    }
+
+    // Use the stored token data from parakeet_decode
+    parakeet_segment segment;
+    if (!parakeet_build_segment(ctx, state->decoded_token_data.data() + tokens_before, tokens_after - tokens_before,
+                tokens_before == 0, t0, t1, segment)) {
+        return;
+    }
+
+    state->result_all.push_back(std::move(segment));
+
+    if (params.new_segment_callback) {
+        params.new_segment_callback(ctx, state, 1, params.new_segment_callback_user_data);
+    }
+}
+
 // Encode and decode the mel spectrogram already in state, without recomputing it.
 static int parakeet_chunk_with_state(
       struct parakeet_context   * ctx,
@@ -3590,38 +5112,7 @@ int parakeet_full_with_state(
         return -7;
     }
 
-    const size_t tokens_after    = state->decoded_tokens.size();
-    const size_t new_token_count = tokens_after - tokens_before;
-
-    if (new_token_count > 0) {
-        std::string text;
-        std::vector<parakeet_token_data> result_tokens;
-
-        for (size_t i = tokens_before; i < tokens_after; i++) {
-            const auto token_id  = state->decoded_tokens[i];
-            const char * tok_str = parakeet_token_to_str(ctx, token_id);
-            if (tok_str) {
-                const bool is_first = (tokens_before == 0) && text.empty();
-                text += sentencepiece_piece_to_text(tok_str, is_first);
-            }
-            result_tokens.push_back(state->decoded_token_data[i]);
-        }
-
-        refine_timestamps_tdt(ctx->vocab, result_tokens);
-
-        if (!text.empty()) {
-            parakeet_segment seg;
-            seg.t0     = 0;
-            seg.t1     = state->n_frames;
-            seg.text   = text;
-            seg.tokens = result_tokens;
-            state->result_all.push_back(std::move(seg));
-
-            if (params.new_segment_callback) {
-                params.new_segment_callback(ctx, state, 1, params.new_segment_callback_user_data);
-            }
-        }
-    }
+    parakeet_push_segment(ctx, state, params, tokens_before, 0, state->n_frames);
 
     return 0;
 }
@@ -3686,45 +5177,491 @@ int parakeet_chunk(
         return -7;
     }
 
-    const size_t tokens_after = state->decoded_tokens.size();
-    const size_t new_token_count = tokens_after - tokens_before;
+    // Caller tracks timing
+    parakeet_push_segment(ctx, state, params, tokens_before, 0, n_frames);
+
+    return 0;
+}
+
+int parakeet_full_batch_with_state(
+        struct parakeet_context * ctx,
+          struct parakeet_state * state,
+    struct parakeet_full_params   params,
+             const float * const * samples,
+                      const int * n_samples,
+                            int   n_utterances) {
+    state->result_all.clear();
+
+    if (n_utterances <= 0) {
+        return 0;
+    }
+
+    const int n_audio_ctx     = ctx->model.hparams.n_audio_ctx;
+    const int subsampl_factor = ctx->model.hparams.subsampling_factor;
+    const int n_batch_max     = std::max(1, params.n_batch);
+
+    std::vector<parakeet_mel> mels(n_utterances);
+    std::vector<int> n_len(n_utterances);
+    for (int i = 0; i < n_utterances; ++i) {
+        if (parakeet_pcm_to_mel_with_state(ctx, state, samples[i], n_samples[i], params.n_threads) != 0) {
+            PARAKEET_LOG_ERROR("%s: failed to compute log mel spectrogram\n", __func__);
+            return -2;
+        }
+        mels[i]  = std::move(state->mel);
+        n_len[i] = mels[i].n_len;
+    }
+
+    // Utterances of similar length are batched together to keep the padding
+    // small. Utterances longer than the audio context are transcribed on their own.
+    std::vector<int> order(n_utterances);
+    for (int i = 0; i < n_utterances; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return n_len[a] < n_len[b];
+    });
+
+    std::vector<parakeet_segment> results;
+    std::vector<parakeet_beam_hyp> hyps;
+    std::vector<int> t_end;
+
+    auto report_progress = [&](int n_done) {
+        if (params.progress_callback) {
+            params.progress_callback(ctx, state, 100 * n_done / n_utterances, params.progress_callback_user_data);
+        }
+    };
+
+    report_progress(0);
+
+    int n_done = 0;
+    while (n_done < n_utterances) {
+        const int i_first = order[n_done];
 
-    if (new_token_count > 0) {
-        std::string text;
-        std::vector<parakeet_token_data> result_tokens;
+        if (n_len[i_first] > n_audio_ctx || n_batch_max == 1 ||
+            (params.strategy == PARAKEET_SAMPLING_BEAM_SEARCH && params.beam_search.beam_size > 1)) {
+            state->mel = std::move(mels[i_first]);
 
-        for (size_t i = tokens_before; i < tokens_after; i++) {
-            const auto token_id = state->decoded_tokens[i];
-            const char * token_str = parakeet_token_to_str(ctx, token_id);
-            if (token_str) {
-                const bool is_first_piece = (tokens_before == 0) && text.empty();
-                text += sentencepiece_piece_to_text(token_str, is_first_piece);
+            parakeet_full_params params_one = params;
+            params_one.new_segment_callback = nullptr;
+            params_one.new_token_callback   = nullptr;
+            params_one.progress_callback    = nullptr;
+
+            const int ret = parakeet_full_with_state(ctx, state, params_one, nullptr, 0);
+            if (ret != 0) {
+                return ret;
+            }
+            for (auto & segment : state->result_all) {
+                segment.i_utterance = i_first;
+                results.push_back(std::move(segment));
             }
 
-            // Use the stored token data from parakeet_decode
-            result_tokens.push_back(state->decoded_token_data[i]);
+            n_done += 1;
+            report_progress(n_done);
+            continue;
         }
 
-        refine_timestamps_tdt(ctx->vocab, result_tokens);
+        const int n_len_max = std::min(n_audio_ctx, n_len[i_first] + n_len[i_first] * PARAKEET_BATCH_MAX_PAD / 100);
+
+        int n_batch = 0;
+        while (n_done + n_batch < n_utterances && n_batch < n_batch_max &&
+               n_len[order[n_done + n_batch]] <= n_len_max) {
+            n_batch += 1;
+        }
+
+        // the padding is masked, so the length is rounded up to reuse the
+        // encoder graph of the previous group more often
+        int n_batch_ctx = n_len[order[n_done + n_batch - 1]];
+        if (n_batch > 1) {
+            n_batch_ctx = std::min(n_audio_ctx, (n_batch_ctx + PARAKEET_BATCH_CTX_STEP - 1) / PARAKEET_BATCH_CTX_STEP * PARAKEET_BATCH_CTX_STEP);
+        }
+
+        // a group of one is encoded like a single utterance
+        state->mel_batch.resize(n_batch > 1 ? n_batch : 0);
+        for (int b = 0; b < n_batch; ++b) {
+            (n_batch > 1 ? state->mel_batch[b] : state->mel) = std::move(mels[order[n_done + b]]);
+        }
+
+        if (!parakeet_ensure_encode_sched(*ctx, *state, n_batch_ctx, n_batch)) {
+            PARAKEET_LOG_ERROR("%s: failed to allocate encoder graph for %d x %d mel frames\n",
+                    __func__, n_batch, n_batch_ctx);
+            return -6;
+        }
+
+        if (params.encoder_begin_callback) {
+            if (!params.encoder_begin_callback(ctx, state, params.encoder_begin_callback_user_data)) {
+                PARAKEET_LOG_ERROR("%s: encoder_begin_callback returned false - aborting\n", __func__);
+                return -6;
+            }
+        }
+
+        if (!parakeet_encode_internal(*ctx, *state, 0, params.n_threads, params.abort_callback, params.abort_callback_user_data)) {
+            PARAKEET_LOG_ERROR("%s: failed to encode\n", __func__);
+            return -6;
+        }
+
+        t_end.resize(n_batch);
+        for (int b = 0; b < n_batch; ++b) {
+            t_end[b] = std::min((n_len[order[n_done + b]] + subsampl_factor - 1) / subsampl_factor, state->n_frames);
+        }
+
+        if (!parakeet_decode_batch(*ctx, *state, params.n_threads, params, t_end, hyps)) {
+            PARAKEET_LOG_ERROR("%s: failed to decode\n", __func__);
+            return -7;
+        }
+
+        for (int b = 0; b < n_batch; ++b) {
+            const auto & hyp = hyps[b];
 
-        if (!text.empty()) {
             parakeet_segment segment;
-            segment.t0 = 0; // Caller tracks timing
-            segment.t1 = n_frames;
-            segment.text = text;
-            segment.tokens = result_tokens;
+            if (!parakeet_build_segment(ctx, hyp.token_data.data(), hyp.token_data.size(), true,
+                        0, n_len[order[n_done + b]], segment)) {
+                continue;
+            }
+            segment.i_utterance = order[n_done + b];
+            results.push_back(std::move(segment));
+        }
+
+        state->mel_batch.clear();
+
+        n_done += n_batch;
+        report_progress(n_done);
+    }
+
+    std::stable_sort(results.begin(), results.end(), [](const parakeet_segment & a, const parakeet_segment & b) {
+        return a.i_utterance < b.i_utterance;
+    });
+
+    state->result_all = std::move(results);
+
+    if (params.new_segment_callback && !state->result_all.empty()) {
+        params.new_segment_callback(ctx, state, (int) state->result_all.size(), params.new_segment_callback_user_data);
+    }
+
+    return 0;
+}
+
+int parakeet_full_batch(
+        struct parakeet_context * ctx,
+    struct parakeet_full_params   params,
+             const float * const * samples,
+                      const int * n_samples,
+                            int   n_utterances) {
+    return parakeet_full_batch_with_state(ctx, ctx->state, params, samples, n_samples, n_utterances);
+}
+
+//
+// Streaming
+//
+
+// Compute the log mel frames that the samples pushed so far make available.
+// The frames match the ones log_mel_spectrogram() produces for the whole
+// signal, before the per-feature normalization. On flush the right center
+// padding is appended and the remaining frames are computed.
+static void parakeet_stream_compute_mel(
+        parakeet_context & ctx,
+          parakeet_state & state,
+                    bool   flush) {
+    auto & stream = state.stream;
+
+    const int64_t t_start_us = wsp_ggml_time_us();
+
+    const auto & cache   = ctx.mel_cache;
+    const auto & filters = ctx.model.filters;
+
+    const int frame_size = ctx.model.hparams.n_fft;
+    const int frame_step = PARAKEET_HOP_LENGTH;
+    const int n_mel      = filters.n_mel;
+    const int pad        = frame_size / 2;
+
+    const float * window_func = cache.window.empty() ? cache.hann_window.data() : cache.window.data();
+    const int window_size = cache.window.empty() ? cache.n_fft : cache.window.size();
+
+    if (flush) {
+        stream.pcm.insert(stream.pcm.end(), pad, 0.0f);
+    }
+
+    // total (center padded) samples available and the number of complete frames
+    const int64_t n_padded = stream.pcm_offset + (int64_t) stream.pcm.size();
+    const int64_t n_ready  = n_padded >= frame_size ? (n_padded - frame_size) / frame_step + 1 : 0;
+
+    const int n_new = (int) (n_ready - stream.n_mel);
+    if (n_new <= 0) {
+        return;
+    }
 
-            state->result_all.push_back(std::move(segment));
+    const int64_t i0 = stream.n_mel * frame_step - stream.pcm_offset;
+    const std::vector<float> samples(
+            stream.pcm.begin() + i0,
+            stream.pcm.begin() + i0 + (int64_t) (n_new - 1) * frame_step + frame_size);
 
-            if (params.new_segment_callback) {
-                params.new_segment_callback(ctx, state, 1, params.new_segment_callback_user_data);
+    parakeet_mel mel;
+    mel.n_mel     = n_mel;
+    mel.n_len     = n_new;
+    mel.n_len_org = n_new;
+    mel.data.resize((size_t) n_mel * n_new);
+
+    // Worker Threads (STFT + Mel + Natural Log)
+    {
+        const int n_threads = std::max(1, std::min(stream.params.n_threads, n_new));
+
+        std::vector<std::thread> workers(n_threads - 1);
+        const mel_worker_params mel_params { 0, window_size, (int) samples.size(), frame_size, frame_step, n_threads };
+
+        for (int iw = 0; iw < n_threads - 1; ++iw) {
+            mel_worker_params params = mel_params;
+            params.ith = iw + 1;
+            workers[iw] = std::thread(log_mel_spectrogram_worker_thread,
+                    params,
+                    window_func,
+                    std::cref(samples),
+                    std::cref(filters),
+                    std::ref(mel),
+                    std::cref(cache));
+        }
+
+        log_mel_spectrogram_worker_thread(mel_params, window_func, samples, filters, mel, cache);
+
+        for (int iw = 0; iw < n_threads - 1; ++iw) {
+            workers[iw].join();
+        }
+    }
+
+    // like log_mel_spectrogram(), the statistics only cover frames centered
+    // on the pushed audio
+    const int64_t n_valid = stream.n_samples / frame_step;
+    for (int i = 0; i < n_new; ++i) {
+        if (stream.n_mel + i >= n_valid) {
+            break;
+        }
+        for (int j = 0; j < n_mel; ++j) {
+            const double v = mel.data[(size_t) i * n_mel + j];
+            stream.mel_sum[j]    += v;
+            stream.mel_sum_sq[j] += v * v;
+        }
+        stream.n_mel_stat++;
+    }
+
+    stream.mel.insert(stream.mel.end(), mel.data.begin(), mel.data.end());
+    stream.n_mel = n_ready;
+
+    // samples before the next frame are no longer needed
+    const int64_t n_drop = n_ready * frame_step - stream.pcm_offset;
+    stream.pcm.erase(stream.pcm.begin(), stream.pcm.begin() + n_drop);
+    stream.pcm_offset += n_drop;
+
+    state.t_mel_us += wsp_ggml_time_us() - t_start_us;
+}
+
+// Encode one window of the stream and decode its encoder frames
+// [n_enc_done, n_enc_done + n_commit). The window starts up to n_left_ctx
+// frames before the committed frames, so the encoder only ever runs over a
+// bounded amount of audio per step.
+static int parakeet_stream_step(
+        struct parakeet_context * ctx,
+          struct parakeet_state * state,
+                        int64_t   n_commit) {
+    auto & stream = state->stream;
+    const auto & params = stream.params;
+
+    const int n_mels    = ctx->model.hparams.n_mels;
+    const int subsampl  = ctx->model.hparams.subsampling_factor;
+    const int n_win_mel = (stream.n_left_ctx + PARAKEET_STREAM_CHUNK + PARAKEET_STREAM_RIGHT_CONTEXT) * subsampl;
+
+    const int64_t win_enc0 = std::max<int64_t>(0, stream.n_enc_done - stream.n_left_ctx);
+    const int64_t win_mel0 = win_enc0 * subsampl;
+    const int64_t win_mel1 = std::min<int64_t>(stream.n_mel, win_mel0 + n_win_mel);
+
+    // normalize the window with the statistics of the stream so far
+    {
+        const int n_len = (int) (win_mel1 - win_mel0);
+
+        state->mel.n_mel     = n_mels;
+        state->mel.n_len     = n_len;
+        state->mel.n_len_org = n_len;
+        state->mel.data.resize((size_t) n_mels * n_len);
+
+        const double eps = 1e-5;
+        const double n   = (double) std::max<int64_t>(stream.n_mel_stat, 1);
+
+        const float * src = stream.mel.data() + (size_t) (win_mel0 - stream.mel_offset) * n_mels;
+
+        for (int j = 0; j < n_mels; ++j) {
+            const double mean = stream.mel_sum[j] / n;
+            const double var  = n > 1.0 ? std::max(0.0, (stream.mel_sum_sq[j] - n * mean * mean) / (n - 1.0)) : 1.0;
+            const double denominator = std::sqrt(var) + eps;
+
+            for (int i = 0; i < n_len; ++i) {
+                state->mel.data[(size_t) i * n_mels + j] = (float) ((src[(size_t) i * n_mels + j] - mean) / denominator);
             }
         }
     }
 
+    if (!parakeet_ensure_encode_sched(*ctx, *state, n_win_mel)) {
+        PARAKEET_LOG_ERROR("%s: failed to allocate encoder graph for %d mel frames\n", __func__, n_win_mel);
+        return -6;
+    }
+
+    if (params.encoder_begin_callback) {
+        if (!params.encoder_begin_callback(ctx, state, params.encoder_begin_callback_user_data)) {
+            PARAKEET_LOG_ERROR("%s: encoder_begin_callback returned false - aborting\n", __func__);
+            return -6;
+        }
+    }
+
+    if (!parakeet_encode_internal(*ctx, *state, 0, params.n_threads, params.abort_callback, params.abort_callback_user_data)) {
+        PARAKEET_LOG_ERROR("%s: failed to encode\n", __func__);
+        return -6;
+    }
+
+    const size_t tokens_before = state->decoded_tokens.size();
+
+    parakeet_decode_cursor cursor;
+    cursor.t              = (int) (stream.t - win_enc0);
+    cursor.t_end          = (int) (stream.n_enc_done + n_commit - win_enc0);
+    cursor.t_offset       = (int) win_enc0;
+    cursor.tokens_emitted = stream.tokens_emitted;
+    cursor.primed         = stream.primed;
+
+    // a duration may have moved the decoder past the committed frames
+    if (cursor.t < cursor.t_end) {
+        if (!parakeet_decode(*ctx, *state, state->batch, params.n_threads, &params, &cursor)) {
+            PARAKEET_LOG_ERROR("%s: failed to decode\n", __func__);
+            return -7;
+        }
+
+        stream.t              = win_enc0 + cursor.t;
+        stream.tokens_emitted = cursor.tokens_emitted;
+        stream.primed         = cursor.primed;
+    }
+
+    const int64_t t0 = stream.n_enc_done * subsampl;
+    stream.n_enc_done += n_commit;
+
+    parakeet_push_segment(ctx, state, params, tokens_before, t0, stream.n_enc_done * subsampl);
+
+    // drop the mel frames that no later window will include
+    const int64_t keep_mel0 = std::max<int64_t>(0, stream.n_enc_done - stream.n_left_ctx) * subsampl;
+    if (keep_mel0 > stream.mel_offset) {
+        stream.mel.erase(stream.mel.begin(), stream.mel.begin() + (size_t) (keep_mel0 - stream.mel_offset) * n_mels);
+        stream.mel_offset = keep_mel0;
+    }
+
     return 0;
 }
 
+int parakeet_stream_begin_with_state(
+        struct parakeet_context * ctx,
+          struct parakeet_state * state,
+    struct parakeet_full_params   params) {
+    parakeet_reset_state(state);
+    state->result_all.clear();
+
+    const int n_mels   = ctx->model.hparams.n_mels;
+    const int pad      = ctx->model.hparams.n_fft / 2;
+
+    auto & stream = state->stream;
+    stream = parakeet_stream();
+
+    stream.active = true;
+    stream.params = params;
+    stream.n_left_ctx = std::max(0, std::min(params.n_stream_left_ctx, PARAKEET_LOCAL_ATTN_WINDOW));
+
+    // Parakeet Pytorch implementation uses centered contant padding.
+    stream.pcm.assign(pad, 0.0f);
+
+    stream.mel_sum.assign(n_mels, 0.0);
+    stream.mel_sum_sq.assign(n_mels, 0.0);
+
+    return 0;
+}
+
+int parakeet_stream_begin(
+        struct parakeet_context * ctx,
+    struct parakeet_full_params   params) {
+    return parakeet_stream_begin_with_state(ctx, ctx->state, params);
+}
+
+int parakeet_stream_push_pcm_with_state(
+        struct parakeet_context * ctx,
+          struct parakeet_state * state,
+                    const float * samples,
+                            int   n_samples) {
+    auto & stream = state->stream;
+    if (!stream.active) {
+        PARAKEET_LOG_ERROR("%s: no active stream, call parakeet_stream_begin() first\n", __func__);
+        return -1;
+    }
+
+    state->result_all.clear();
+
+    // Apply preemphasis filter (high-pass): x[i] = x[i] - 0.97 * x[i-1]
+    {
+        const float preemph = 0.97f;
+
+        stream.pcm.reserve(stream.pcm.size() + n_samples);
+        for (int i = 0; i < n_samples; ++i) {
+            stream.pcm.push_back(samples[i] - preemph * stream.pcm_last);
+            stream.pcm_last = samples[i];
+        }
+        stream.n_samples += n_samples;
+    }
+
+    parakeet_stream_compute_mel(*ctx, *state, false);
+
+    // only complete encoder frames followed by enough lookahead are committed
+    const int subsampl = ctx->model.hparams.subsampling_factor;
+    while (stream.n_mel / subsampl - stream.n_enc_done >= PARAKEET_STREAM_CHUNK + PARAKEET_STREAM_RIGHT_CONTEXT) {
+        const int ret = parakeet_stream_step(ctx, state, PARAKEET_STREAM_CHUNK);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+int parakeet_stream_push_pcm(
+        struct parakeet_context * ctx,
+                    const float * samples,
+                            int   n_samples) {
+    return parakeet_stream_push_pcm_with_state(ctx, ctx->state, samples, n_samples);
+}
+
+int parakeet_stream_flush_with_state(
+        struct parakeet_context * ctx,
+          struct parakeet_state * state) {
+    auto & stream = state->stream;
+    if (!stream.active) {
+        PARAKEET_LOG_ERROR("%s: no active stream, call parakeet_stream_begin() first\n", __func__);
+        return -1;
+    }
+
+    state->result_all.clear();
+
+    parakeet_stream_compute_mel(*ctx, *state, true);
+
+    // the encoder produces one frame per started subsampling block
+    const int subsampl = ctx->model.hparams.subsampling_factor;
+    const int64_t n_enc_total = (stream.n_mel + subsampl - 1) / subsampl;
+
+    while (stream.n_enc_done < n_enc_total) {
+        const int64_t n_commit = std::min<int64_t>(n_enc_total - stream.n_enc_done, PARAKEET_STREAM_CHUNK + PARAKEET_STREAM_RIGHT_CONTEXT);
+        const int ret = parakeet_stream_step(ctx, state, n_commit);
+        if (ret != 0) {
+            stream.active = false;
+            return ret;
+        }
+    }
+
+    stream.active = false;
+
+    return 0;
+}
+
+int parakeet_stream_flush(struct parakeet_context * ctx) {
+    return parakeet_stream_flush_with_state(ctx, ctx->state);
+}
+
 int parakeet_full_n_segments_from_state(struct parakeet_state * state) {
     return state->result_all.size();
 }
@@ -3749,6 +5686,14 @@ int64_t parakeet_full_get_segment_t1(struct parakeet_context * ctx, int i_segmen
     return parakeet_full_get_segment_t1_from_state(ctx->state, i_segment);
 }
 
+int parakeet_full_get_segment_utterance_from_state(struct parakeet_state * state, int i_segment) {
+    return state->result_all[i_segment].i_utterance;
+}
+
+int parakeet_full_get_segment_utterance(struct parakeet_context * ctx, int i_segment) {
+    return parakeet_full_get_segment_utterance_from_state(ctx->state, i_segment);
+}
+
 const char * parakeet_full_get_segment_text_from_state(struct parakeet_state * state, int i_segment) {
     return state->result_all[i_segment].text.c_str();
 }
@@ -48,6 +48,10 @@ extern "C" {
     struct parakeet_context_params {
         bool  use_gpu;
         int   gpu_device;  // CUDA device
+
+        // map the model file instead of reading it (parakeet_init_from_file_with_params only),
+        // weights placed in CPU buffers then point into the mapping
+        bool  use_mmap;
     };
 
     typedef struct parakeet_token_data {
@@ -91,6 +95,19 @@ extern "C" {
 
     PARAKEET_API struct parakeet_state * parakeet_init_state(struct parakeet_context * ctx);
 
+    // Use a caller-owned CPU threadpool (see wsp_ggml_threadpool_new() in ggml-cpu.h) for the graph
+    // computations of the state, instead of the threadpool each state creates on first use.
+    // A threadpool can be shared by several states and contexts, as long as they do not compute at
+    // the same time. Pass NULL to detach, the threadpool must stay alive until it is detached.
+    PARAKEET_API void parakeet_attach_threadpool(
+        struct parakeet_context * ctx,
+          wsp_ggml_threadpool_t   threadpool);
+
+    PARAKEET_API void parakeet_attach_threadpool_with_state(
+        struct parakeet_context * ctx,
+          struct parakeet_state * state,
+          wsp_ggml_threadpool_t   threadpool);
+
     // Frees all allocated memory
     PARAKEET_API void parakeet_free      (struct parakeet_context * ctx);
     PARAKEET_API void parakeet_free_state(struct parakeet_state * state);
@@ -195,6 +212,8 @@ extern "C" {
         float sample_ms;
         float encode_ms;
         float decode_ms;
+        float beam_predict_ms; // prediction network time per beam hypothesis
+        float beam_joint_ms;   // joint network time per beam hypothesis
     };
     PARAKEET_API struct parakeet_timings * parakeet_get_timings(struct parakeet_context * ctx);
     PARAKEET_API void parakeet_print_timings(struct parakeet_context * ctx);
@@ -206,6 +225,7 @@ extern "C" {
     // Available sampling strategies
     enum parakeet_sampling_strategy {
         PARAKEET_SAMPLING_GREEDY,
+        PARAKEET_SAMPLING_BEAM_SEARCH,
     };
 
     // Token callback.
@@ -244,6 +264,23 @@ extern "C" {
 
         int  audio_ctx;         // overwrite the audio context size (0 = use default)
 
+        // max number of encoder frames evaluated by a single joint network call
+        // while the decoder is emitting blanks (<= 1 = one frame per call)
+        int  n_joint_block;
+
+        // max number of utterances encoded and decoded together by parakeet_full_batch()
+        int  n_batch;
+
+        // encoder frames (80 ms each) of left context re-encoded with every 16 frame step of a stream,
+        // clamped to [0, 128]. The left context is not cached, so each second of audio costs
+        // (n_stream_left_ctx + 24) / 16 seconds of encoder work: 9.5x at the default of 128,
+        // 3.5x at 32. Less context is cheaper but lowers the accuracy at the start of each step
+        int  n_stream_left_ctx;
+
+        struct {
+            int beam_size;      // number of hypotheses kept by PARAKEET_SAMPLING_BEAM_SEARCH
+        } beam_search;
+
         // called for every newly generated text segment
         parakeet_new_segment_callback new_segment_callback;
         void * new_segment_callback_user_data;
@@ -296,6 +333,65 @@ extern "C" {
                             const float * samples,
                                    int    n_samples);
 
+    // Transcribe several independent utterances, for example the speech segments found by a VAD.
+    // The utterances are grouped by length, up to params.n_batch per group. The mel spectrograms of
+    // a group are padded to the longest one and encoded by one batched encoder graph, then the group
+    // is decoded greedily in lock-step with the prediction and joint networks evaluated for all of
+    // its utterances in one call. Utterances longer than the audio context, and all utterances when
+    // beam search is requested, are transcribed one by one like parakeet_full_with_state().
+    // Each utterance produces at most one segment, the segments are ordered by utterance (see
+    // parakeet_full_get_segment_utterance()). new_token_callback is not called.
+    // Not thread safe for same state
+    PARAKEET_API int parakeet_full_batch(
+                struct parakeet_context * ctx,
+            struct parakeet_full_params   params,
+                     const float * const * samples,
+                              const int * n_samples,
+                                    int   n_utterances);
+
+    PARAKEET_API int parakeet_full_batch_with_state(
+                struct parakeet_context * ctx,
+                  struct parakeet_state * state,
+            struct parakeet_full_params   params,
+                     const float * const * samples,
+                              const int * n_samples,
+                                    int   n_utterances);
+
+    // Streaming transcription
+    // Audio is pushed incrementally. The mel spectrogram is extended with the new samples only, the
+    // encoder runs over the new frames plus params.n_stream_left_ctx frames of left context (see
+    // parakeet_full_params for the encoder cost) and 8 frames of lookahead, and the decoder continues
+    // from the previous time frame and prediction network state, so the work per push does not grow
+    // with the length of the stream. The decoded text is reported through the callbacks in params
+    // and as the segments of the last push/flush call (see parakeet_full_n_segments()).
+    // Segment and token timestamps are counted from the start of the stream. Decoding is greedy.
+    // Not thread safe for same state
+    PARAKEET_API int parakeet_stream_begin(
+                struct parakeet_context * ctx,
+            struct parakeet_full_params   params);
+
+    PARAKEET_API int parakeet_stream_begin_with_state(
+                struct parakeet_context * ctx,
+                  struct parakeet_state * state,
+            struct parakeet_full_params   params);
+
+    // Push 16 kHz mono PCM samples. Audio is transcribed once enough of it has been buffered to
+    // fill an encoder step including its lookahead.
+    PARAKEET_API int parakeet_stream_push_pcm(
+                struct parakeet_context * ctx,
+                            const float * samples,
+                                    int   n_samples);
+
+    PARAKEET_API int parakeet_stream_push_pcm_with_state(
+                struct parakeet_context * ctx,
+                  struct parakeet_state * state,
+                            const float * samples,
+                                    int   n_samples);
+
+    // Transcribe the buffered audio and end the stream
+    PARAKEET_API int parakeet_stream_flush           (struct parakeet_context * ctx);
+    PARAKEET_API int parakeet_stream_flush_with_state(struct parakeet_context * ctx, struct parakeet_state * state);
+
     // Number of generated text segments
     PARAKEET_API int parakeet_full_n_segments           (struct parakeet_context * ctx);
     PARAKEET_API int parakeet_full_n_segments_from_state(struct parakeet_state * state);
@@ -307,6 +403,10 @@ extern "C" {
     PARAKEET_API int64_t parakeet_full_get_segment_t1           (struct parakeet_context * ctx, int i_segment);
     PARAKEET_API int64_t parakeet_full_get_segment_t1_from_state(struct parakeet_state * state, int i_segment);
 
+    // Get the index of the parakeet_full_batch() utterance the specified segment belongs to (0 otherwise)
+    PARAKEET_API int parakeet_full_get_segment_utterance           (struct parakeet_context * ctx, int i_segment);
+    PARAKEET_API int parakeet_full_get_segment_utterance_from_state(struct parakeet_state * state, int i_segment);
+
     // Get the text of the specified segment
     PARAKEET_API const char * parakeet_full_get_segment_text           (struct parakeet_context * ctx, int i_segment);
     PARAKEET_API const char * parakeet_full_get_segment_text_from_state(struct parakeet_state * state, int i_segment);
@@ -1,12 +1,29 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <mutex>
+#include <numeric>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include "rn-whisper.h"
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define DEFAULT_MAX_AUDIO_SEC 30;
 
+// Sinc zero crossings on each side of the resampling filter
+#define RESAMPLE_ZERO_CROSSINGS 8
+// Cutoff relative to the output Nyquist frequency, leaves room for the transition band
+#define RESAMPLE_ROLLOFF 0.94
+// Uncommon rate pairs have more phases than this, their positions are rounded
+#define RESAMPLE_MAX_PHASES 1024
+
 namespace rnwhisper {
 
 const char * system_info(void) {
@@ -61,6 +78,14 @@ std::string bench(struct whisper_context * ctx, int n_threads) {
         return "error: failed to encode: " + std::to_string(ret);
     }
 
+    // the timed encode must run the encoder, not reuse the warm-up window
+    const struct whisper_timings * encode_timings = whisper_get_timings(ctx);
+    const float encode_ms = encode_timings->encode_ms;
+    delete encode_timings;
+    if (encode_ms <= 0.0f) {
+        return "error: encode was skipped";
+    }
+
     // text-generation
     for (int i = 0; i < 256; i++) {
         if (int ret = whisper_decode(ctx, tokens, 1, i, n_threads) != 0) {
@@ -93,6 +118,431 @@ std::string bench(struct whisper_context * ctx, int n_threads) {
         std::to_string(timings->prompt_ms) + "]";
 }
 
+static inline int16_t pcm16_at(const uint8_t * pcm, size_t i) {
+    int16_t sample;
+    memcpy(&sample, pcm + i * sizeof(int16_t), sizeof(int16_t));
+    return sample;
+}
+
+void audio_pcm16_to_f32(const uint8_t * pcm, size_t n_samples, float * out) {
+    const float scale = 1.0f / 32767.0f;
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const float32x4_t vmin = vdupq_n_f32(-1.0f);
+    for (; i + 8 <= n_samples; i += 8) {
+        const int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(pcm + i * sizeof(int16_t)));
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(out + i,     vmaxq_f32(vmulq_f32(lo, vscale), vmin));
+        vst1q_f32(out + i + 4, vmaxq_f32(vmulq_f32(hi, vscale), vmin));
+    }
+#elif defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vmin = _mm_set1_ps(-1.0f);
+    for (; i + 8 <= n_samples; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (pcm + i * sizeof(int16_t)));
+        // Sign-extend by placing each sample in the high half and shifting back
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i,     _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), vscale), vmin));
+        _mm_storeu_ps(out + i + 4, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), vscale), vmin));
+    }
+#endif
+    for (; i < n_samples; ++i) {
+        out[i] = std::max(-1.0f, pcm16_at(pcm, i) * scale);
+    }
+}
+
+void audio_pcm16_downmix(const uint8_t * pcm, size_t n_frames, int n_channels, float * out) {
+    if (n_channels <= 1) {
+        audio_pcm16_to_f32(pcm, n_frames, out);
+        return;
+    }
+
+    const float scale = 1.0f / (32767.0f * n_channels);
+    size_t i = 0;
+    if (n_channels == 2) {
+        // Pairwise adds of interleaved L/R give L + R per frame
+#if defined(__ARM_NEON)
+        const float32x4_t vscale = vdupq_n_f32(scale);
+        const float32x4_t vmin = vdupq_n_f32(-1.0f);
+        for (; i + 4 <= n_frames; i += 4) {
+            const int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(pcm + i * 2 * sizeof(int16_t)));
+            const float32x4_t sum = vcvtq_f32_s32(vpaddlq_s16(v));
+            vst1q_f32(out + i, vmaxq_f32(vmulq_f32(sum, vscale), vmin));
+        }
+#elif defined(__SSE2__)
+        const __m128 vscale = _mm_set1_ps(scale);
+        const __m128 vmin = _mm_set1_ps(-1.0f);
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; i + 4 <= n_frames; i += 4) {
+            const __m128i v = _mm_loadu_si128((const __m128i *) (pcm + i * 2 * sizeof(int16_t)));
+            const __m128 sum = _mm_cvtepi32_ps(_mm_madd_epi16(v, ones));
+            _mm_storeu_ps(out + i, _mm_max_ps(_mm_mul_ps(sum, vscale), vmin));
+        }
+#endif
+    }
+    for (; i < n_frames; ++i) {
+        int32_t sum = 0;
+        for (int c = 0; c < n_channels; ++c) {
+            sum += pcm16_at(pcm, i * n_channels + c);
+        }
+        out[i] = std::max(-1.0f, sum * scale);
+    }
+}
+
+size_t audio_sample_size(audio_sample_format format) {
+    switch (format) {
+        case AUDIO_SAMPLE_U8:
+        case AUDIO_SAMPLE_ALAW:
+        case AUDIO_SAMPLE_MULAW:
+            return 1;
+        case AUDIO_SAMPLE_S16:
+            return 2;
+        case AUDIO_SAMPLE_S24:
+            return 3;
+        case AUDIO_SAMPLE_S32:
+        case AUDIO_SAMPLE_F32:
+            return 4;
+        case AUDIO_SAMPLE_F64:
+            return 8;
+    }
+    return 0;
+}
+
+// G.711 expansion to 16-bit linear, as in the ITU reference decoder
+static int16_t alaw_to_linear(uint8_t a) {
+    a ^= 0x55;
+    int t = (a & 0x0f) << 4;
+    const int seg = (a & 0x70) >> 4;
+    if (seg == 0) {
+        t += 8;
+    } else {
+        t = (t + 0x108) << (seg - 1);
+    }
+    return (int16_t) ((a & 0x80) ? t : -t);
+}
+
+static int16_t mulaw_to_linear(uint8_t u) {
+    u = ~u;
+    int t = (((u & 0x0f) << 3) + 0x84) << ((u & 0x70) >> 4);
+    return (int16_t) ((u & 0x80) ? (0x84 - t) : (t - 0x84));
+}
+
+struct g711_tables {
+    float alaw[256];
+    float mulaw[256];
+
+    g711_tables() {
+        for (int i = 0; i < 256; ++i) {
+            alaw[i] = alaw_to_linear((uint8_t) i) / 32767.0f;
+            mulaw[i] = mulaw_to_linear((uint8_t) i) / 32767.0f;
+        }
+    }
+};
+
+static const g711_tables & get_g711_tables() {
+    static const g711_tables tables;
+    return tables;
+}
+
+static inline float clamp_sample(float x) {
+    return std::max(-1.0f, std::min(1.0f, x));
+}
+
+// Decodes n samples without mixing
+static void audio_decode(const uint8_t * data, size_t n, audio_sample_format format, float * out) {
+    switch (format) {
+        case AUDIO_SAMPLE_U8:
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = std::max(-1.0f, (data[i] - 128) / 127.0f);
+            }
+            break;
+        case AUDIO_SAMPLE_S16:
+            audio_pcm16_to_f32(data, n, out);
+            break;
+        case AUDIO_SAMPLE_S24:
+            for (size_t i = 0; i < n; ++i) {
+                const uint8_t * p = data + i * 3;
+                // Sign-extend from the top byte
+                const int32_t v = (int32_t) ((uint32_t) p[0] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24) >> 8;
+                out[i] = std::max(-1.0f, v * (1.0f / 8388607.0f));
+            }
+            break;
+        case AUDIO_SAMPLE_S32:
+            for (size_t i = 0; i < n; ++i) {
+                int32_t v;
+                memcpy(&v, data + i * sizeof(int32_t), sizeof(int32_t));
+                out[i] = std::max(-1.0f, (float) v * (1.0f / 2147483647.0f));
+            }
+            break;
+        case AUDIO_SAMPLE_F32:
+            memcpy(out, data, n * sizeof(float));
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = clamp_sample(out[i]);
+            }
+            break;
+        case AUDIO_SAMPLE_F64:
+            for (size_t i = 0; i < n; ++i) {
+                double v;
+                memcpy(&v, data + i * sizeof(double), sizeof(double));
+                out[i] = clamp_sample((float) v);
+            }
+            break;
+        case AUDIO_SAMPLE_ALAW:
+        case AUDIO_SAMPLE_MULAW: {
+            const auto & tables = get_g711_tables();
+            const float * table = format == AUDIO_SAMPLE_ALAW ? tables.alaw : tables.mulaw;
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = table[data[i]];
+            }
+            break;
+        }
+    }
+}
+
+void audio_decode_downmix(const uint8_t * data, size_t n_frames, int n_channels, audio_sample_format format, float * out) {
+    if (format == AUDIO_SAMPLE_S16) {
+        audio_pcm16_downmix(data, n_frames, n_channels, out);
+        return;
+    }
+    if (n_channels <= 1) {
+        audio_decode(data, n_frames, format, out);
+        return;
+    }
+
+    // Decode interleaved frames into a small scratch buffer, then average
+    const size_t frame_size = audio_sample_size(format) * n_channels;
+    const size_t chunk_frames = 1024;
+    std::vector<float> scratch(chunk_frames * n_channels);
+    const float scale = 1.0f / n_channels;
+    for (size_t frame = 0; frame < n_frames; frame += chunk_frames) {
+        const size_t n = std::min(chunk_frames, n_frames - frame);
+        audio_decode(data + frame * frame_size, n * n_channels, format, scratch.data());
+        for (size_t i = 0; i < n; ++i) {
+            const float * samples = scratch.data() + i * n_channels;
+            float sum = 0.0f;
+            for (int c = 0; c < n_channels; ++c) {
+                sum += samples[c];
+            }
+            out[frame + i] = sum * scale;
+        }
+    }
+}
+
+static inline float dot_f32(const float * a, const float * b, int n) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    acc0 = vaddq_f32(acc0, acc1);
+    for (; i + 4 <= n; i += 4) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, acc0);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc0);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+audio_resampler::audio_resampler(uint32_t src_rate, uint32_t dst_rate) {
+    passthrough = src_rate == dst_rate || src_rate == 0 || dst_rate == 0;
+    if (passthrough) {
+        return;
+    }
+
+    // Output sample n sits at input position n * down / up
+    const uint32_t g = std::gcd(src_rate, dst_rate);
+    up = dst_rate / g;
+    down = src_rate / g;
+
+    // Low-pass at the lower Nyquist frequency, in cycles per input sample
+    const double cutoff = 0.5 * std::min(1.0, (double) dst_rate / src_rate) * RESAMPLE_ROLLOFF;
+    half = (int) std::ceil(RESAMPLE_ZERO_CROSSINGS / (2.0 * cutoff));
+    n_taps = 2 * half;
+    stride = (n_taps + 3) & ~3;
+    n_phases = (int) std::min<uint64_t>(up, RESAMPLE_MAX_PHASES);
+
+    // Tap j of a phase with fractional offset f weights input (base - half + 1 + j)
+    filters.assign((size_t) n_phases * stride, 0.0f);
+    for (int p = 0; p < n_phases; ++p) {
+        const double frac = (double) p / n_phases;
+        float * taps = filters.data() + (size_t) p * stride;
+        double sum = 0.0;
+        for (int j = 0; j < n_taps; ++j) {
+            const double x = (j - half + 1) - frac;
+            if (std::fabs(x) >= half) {
+                continue;
+            }
+            const double arg = 2.0 * cutoff * x;
+            const double sinc = arg == 0.0 ? 1.0 : std::sin(M_PI * arg) / (M_PI * arg);
+            const double window = 0.42 + 0.5 * std::cos(M_PI * x / half) + 0.08 * std::cos(2.0 * M_PI * x / half);
+            const double h = sinc * window;
+            taps[j] = (float) h;
+            sum += h;
+        }
+        // Unity gain at DC for every phase
+        for (int j = 0; j < n_taps; ++j) {
+            taps[j] = (float) (taps[j] / sum);
+        }
+    }
+
+    // Zeros before the first sample
+    buffer.assign(half, 0.0f);
+    buffer_start = -half;
+}
+
+void audio_resampler::window(uint64_t n, int64_t & start, int & phase) const {
+    const uint64_t pos = n * down;
+    int64_t base = (int64_t) (pos / up);
+    const uint64_t rem = pos % up;
+    phase = (int) rem;
+    if ((uint64_t) n_phases != up) {
+        phase = (int) ((rem * n_phases + up / 2) / up);
+        if (phase == n_phases) {
+            phase = 0;
+            base += 1;
+        }
+    }
+    start = base - half + 1;
+}
+
+void audio_resampler::emit(uint64_t n_target, std::vector<float> & out) {
+    const int64_t buffer_end = buffer_start + (int64_t) buffer.size();
+    for (; n_out < n_target; ++n_out) {
+        int64_t start;
+        int phase;
+        window(n_out, start, phase);
+        if (start + stride > buffer_end) {
+            break;
+        }
+        out.push_back(dot_f32(
+            filters.data() + (size_t) phase * stride,
+            buffer.data() + (start - buffer_start),
+            stride));
+    }
+}
+
+void audio_resampler::push(const float * samples, size_t n_samples, std::vector<float> & out) {
+    if (passthrough) {
+        out.insert(out.end(), samples, samples + n_samples);
+        return;
+    }
+
+    buffer.insert(buffer.end(), samples, samples + n_samples);
+    n_in += n_samples;
+    emit(n_in * up / down, out);
+
+    // Drop the input no later output reads
+    int64_t start;
+    int phase;
+    window(n_out, start, phase);
+    const int64_t n_drop = std::min<int64_t>(start - buffer_start, (int64_t) buffer.size());
+    if (n_drop > 0) {
+        buffer.erase(buffer.begin(), buffer.begin() + n_drop);
+        buffer_start += n_drop;
+    }
+}
+
+void audio_resampler::finish(std::vector<float> & out) {
+    if (passthrough || n_in == 0) {
+        return;
+    }
+
+    // Zeros after the last sample
+    buffer.insert(buffer.end(), stride + 1, 0.0f);
+    emit(std::max<uint64_t>(1, n_in * up / down), out);
+}
+
+std::vector<float> audio_resample(const float * samples, size_t n_samples, uint32_t src_rate, uint32_t dst_rate) {
+    if (n_samples == 0 || src_rate == 0 || dst_rate == 0) {
+        return {};
+    }
+
+    std::vector<float> out;
+    out.reserve((size_t) ((uint64_t) n_samples * dst_rate / src_rate) + 1);
+    audio_resampler resampler(src_rate, dst_rate);
+    resampler.push(samples, n_samples, out);
+    resampler.finish(out);
+    return out;
+}
+
+int transcribe_batch(
+    whisper_context * ctx,
+    whisper_state * state,
+    whisper_full_params params,
+    const std::vector<batch_clip> & clips,
+    std::vector<batch_result> & results,
+    void (*on_progress)(int progress, void * user_data),
+    void * on_progress_user_data) {
+    results.assign(clips.size(), batch_result());
+
+    // The text of one clip must not prompt the next one, the context still carries within a clip
+    params.no_context = true;
+    params.progress_callback = nullptr;
+    params.new_segment_callback = nullptr;
+
+    for (size_t k = 0; k < clips.size(); ++k) {
+        if (params.abort_callback && params.abort_callback(params.abort_callback_user_data)) {
+            break;
+        }
+
+        const auto & clip = clips[k];
+        const int ret = state
+            ? whisper_full_with_state(ctx, state, params, clip.samples, (int) clip.n_samples)
+            : whisper_full(ctx, params, clip.samples, (int) clip.n_samples);
+        if (ret != 0) {
+            return ret;
+        }
+
+        auto & result = results[k];
+        const int lang_id = state ? whisper_full_lang_id_from_state(state) : whisper_full_lang_id(ctx);
+        const char * language = whisper_lang_str(lang_id);
+        result.language = language ? language : "";
+
+        const int n_segments = state ? whisper_full_n_segments_from_state(state) : whisper_full_n_segments(ctx);
+        result.segments.reserve(n_segments);
+        for (int i = 0; i < n_segments; ++i) {
+            const char * text = state ? whisper_full_get_segment_text_from_state(state, i) : whisper_full_get_segment_text(ctx, i);
+            result.segments.push_back({
+                text ? text : "",
+                state ? whisper_full_get_segment_t0_from_state(state, i) : whisper_full_get_segment_t0(ctx, i),
+                state ? whisper_full_get_segment_t1_from_state(state, i) : whisper_full_get_segment_t1(ctx, i),
+            });
+        }
+
+        if (on_progress) {
+            on_progress((int) ((k + 1) * 100 / clips.size()), on_progress_user_data);
+        }
+    }
+
+    return 0;
+}
+
 bool job::is_aborted() {
     return aborted;
 }
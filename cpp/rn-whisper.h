@@ -1,6 +1,8 @@
 #ifndef RNWHISPER_H
 #define RNWHISPER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "whisper.h"
@@ -10,6 +12,89 @@ namespace rnwhisper {
 
 std::string bench(whisper_context * ctx, int n_threads);
 
+// Audio ingest, `pcm` is little-endian signed 16-bit PCM and may be unaligned
+void audio_pcm16_to_f32(const uint8_t * pcm, size_t n_samples, float * out);
+void audio_pcm16_downmix(const uint8_t * pcm, size_t n_frames, int n_channels, float * out);
+
+enum audio_sample_format {
+    AUDIO_SAMPLE_U8,
+    AUDIO_SAMPLE_S16,
+    AUDIO_SAMPLE_S24,
+    AUDIO_SAMPLE_S32,
+    AUDIO_SAMPLE_F32,
+    AUDIO_SAMPLE_F64,
+    AUDIO_SAMPLE_ALAW,
+    AUDIO_SAMPLE_MULAW,
+};
+
+size_t audio_sample_size(audio_sample_format format);
+// Decodes interleaved little-endian frames to [-1, 1] floats and averages the channels
+void audio_decode_downmix(const uint8_t * data, size_t n_frames, int n_channels, audio_sample_format format, float * out);
+
+// Band-limited (windowed-sinc, polyphase) sample rate conversion over blocks of
+// input. n input samples give max(1, n * dst_rate / src_rate) output samples.
+struct audio_resampler {
+    audio_resampler(uint32_t src_rate, uint32_t dst_rate);
+
+    // Appends the output samples whose filter window is complete
+    void push(const float * samples, size_t n_samples, std::vector<float> & out);
+    // Appends the remaining output samples, zero padding the end
+    void finish(std::vector<float> & out);
+
+private:
+    void window(uint64_t n, int64_t & start, int & phase) const;
+    void emit(uint64_t n_target, std::vector<float> & out);
+
+    bool passthrough = true;
+    uint64_t up = 1;
+    uint64_t down = 1;
+    int half = 0;
+    int n_taps = 0;
+    int stride = 0;
+    int n_phases = 0;
+    std::vector<float> filters;
+    // Input samples from the absolute index buffer_start
+    std::vector<float> buffer;
+    int64_t buffer_start = 0;
+    uint64_t n_in = 0;
+    uint64_t n_out = 0;
+};
+
+std::vector<float> audio_resample(const float * samples, size_t n_samples, uint32_t src_rate, uint32_t dst_rate);
+
+struct batch_clip {
+    const float * samples;
+    size_t n_samples;
+};
+
+struct batch_segment {
+    std::string text;
+    // Relative to the clip, in centiseconds
+    int64_t t0;
+    int64_t t1;
+};
+
+struct batch_result {
+    std::vector<batch_segment> segments;
+    std::string language;
+};
+
+// Transcribes each clip with its own whisper_full call on one state, so every
+// clip gets its own decoder context, language and segments. `no_context` is
+// forced so the text of a clip never prompts the next one, the progress and new
+// segment callbacks of `params` are not called. Set `audio_ctx_auto` to keep the
+// encoder cost of short clips down. Uses the context's default state when
+// `state` is null. Returns the first non-zero whisper_full code, `on_progress`
+// gets the share of clips done (0-100).
+int transcribe_batch(
+    whisper_context * ctx,
+    whisper_state * state,
+    whisper_full_params params,
+    const std::vector<batch_clip> & clips,
+    std::vector<batch_result> & results,
+    void (*on_progress)(int progress, void * user_data) = nullptr,
+    void * on_progress_user_data = nullptr);
+
 struct vad_params {
     bool use_vad = false;
     float vad_thold = 0.6f;
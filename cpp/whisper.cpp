@@ -26,6 +26,7 @@
 #include <cstring>
 #include <fstream>
 #include <functional>
+#include <list>
 #include <map>
 #include <random>
 #include <regex>
@@ -38,6 +39,14 @@
 #include <codecvt>
 #endif
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(WHISPER_BIG_ENDIAN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WHISPER_USE_MMAP
+#endif
+
 #if defined(WHISPER_BIG_ENDIAN)
 template<typename T>
 static T byteswap(T value) {
@@ -141,11 +150,17 @@ static void whisper_log_callback_default(wsp_ggml_log_level level, const char *
 
 #define WHISPER_MAX_DECODERS 8
 
+// self-attention cache sequence that keeps the cells of the last decoded prompt
+#define WHISPER_PROMPT_SEQ (2*WHISPER_MAX_DECODERS)
+
 // temperature below which we condition on past text history
 static constexpr float WHISPER_HISTORY_CONDITIONING_TEMP_CUTOFF = 0.5f;
 
 #define WHISPER_MAX_NODES 4096
 
+// number of VAD windows processed by a single graph (the unrolled LSTM needs ~20 nodes per window)
+#define WHISPER_VAD_N_BATCH 64
+
 static std::string format(const char * fmt, ...) {
     va_list ap;
     va_list ap2;
@@ -165,26 +180,126 @@ static std::string format(const char * fmt, ...) {
 // ggml helpers
 //
 
+static void * whisper_cpu_get_proc_address(const char * name) {
+    wsp_ggml_backend_dev_t dev = wsp_ggml_backend_dev_by_type(WSP_GGML_BACKEND_DEVICE_TYPE_CPU);
+    wsp_ggml_backend_reg_t reg = dev ? wsp_ggml_backend_dev_backend_reg(dev) : nullptr;
+
+    return reg ? wsp_ggml_backend_reg_get_proc_address(reg, name) : nullptr;
+}
+
+typedef wsp_ggml_threadpool_t (*whisper_threadpool_new_t)(struct wsp_ggml_threadpool_params * params);
+typedef void (*whisper_threadpool_free_t)(wsp_ggml_threadpool_t threadpool);
+typedef void (*whisper_backend_cpu_set_threadpool_t)(wsp_ggml_backend_t backend, wsp_ggml_threadpool_t threadpool);
+
+// CPU threadpool kept across graph computations, without it the CPU backend spawns and joins its
+// worker threads for every graph
+struct whisper_threadpool {
+    wsp_ggml_threadpool_t owned    = nullptr; // created on first use, grown when more threads are requested
+    wsp_ggml_threadpool_t attached = nullptr; // set by the user, not owned
+
+    wsp_ggml_threadpool_t current  = nullptr; // threadpool the CPU backends currently use
+
+    int n_threads = 0; // size of the owned threadpool
+};
+
+static void whisper_threadpool_set(
+                    whisper_threadpool & tp,
+    const std::vector<wsp_ggml_backend_t> & backends,
+                 wsp_ggml_threadpool_t   threadpool) {
+    if (tp.current == threadpool) {
+        return;
+    }
+
+    auto * fn_set_threadpool = (whisper_backend_cpu_set_threadpool_t) whisper_cpu_get_proc_address("wsp_ggml_backend_cpu_set_threadpool");
+    if (fn_set_threadpool == nullptr) {
+        return;
+    }
+
+    for (auto * backend : backends) {
+        wsp_ggml_backend_dev_t dev = wsp_ggml_backend_get_device(backend);
+        if (dev && wsp_ggml_backend_dev_type(dev) == WSP_GGML_BACKEND_DEVICE_TYPE_CPU) {
+            fn_set_threadpool(backend, threadpool);
+        }
+    }
+
+    tp.current = threadpool;
+}
+
+static void whisper_threadpool_free_owned(whisper_threadpool & tp) {
+    if (tp.owned == nullptr) {
+        return;
+    }
+
+    auto * fn_free = (whisper_threadpool_free_t) whisper_cpu_get_proc_address("wsp_ggml_threadpool_free");
+    if (fn_free) {
+        fn_free(tp.owned);
+    }
+
+    tp.owned     = nullptr;
+    tp.n_threads = 0;
+}
+
+// make the CPU backends use the attached threadpool, or the owned one with at least n_threads threads
+static void whisper_threadpool_prepare(
+                    whisper_threadpool & tp,
+    const std::vector<wsp_ggml_backend_t> & backends,
+                                   int   n_threads) {
+    if (tp.attached) {
+        whisper_threadpool_set(tp, backends, tp.attached);
+        return;
+    }
+
+    if (tp.owned == nullptr || tp.n_threads < n_threads) {
+        auto * fn_new = (whisper_threadpool_new_t) whisper_cpu_get_proc_address("wsp_ggml_threadpool_new");
+        if (fn_new == nullptr) {
+            return;
+        }
+
+        // the backends must not point to the threadpool that is replaced
+        whisper_threadpool_set(tp, backends, nullptr);
+        whisper_threadpool_free_owned(tp);
+
+        struct wsp_ggml_threadpool_params params = wsp_ggml_threadpool_params_default(n_threads);
+        tp.owned     = fn_new(&params);
+        tp.n_threads = tp.owned ? n_threads : 0;
+    }
+
+    whisper_threadpool_set(tp, backends, tp.owned);
+}
+
+static void whisper_threadpool_attach(
+                    whisper_threadpool & tp,
+    const std::vector<wsp_ggml_backend_t> & backends,
+                 wsp_ggml_threadpool_t   threadpool) {
+    tp.attached = threadpool;
+
+    // switch right away, so that a detached threadpool can be freed
+    if (threadpool) {
+        whisper_threadpool_set(tp, backends, threadpool);
+    } else if (tp.current != tp.owned) {
+        whisper_threadpool_set(tp, backends, nullptr);
+    }
+}
+
 static bool wsp_ggml_graph_compute_helper(
+              wsp_ggml_backend_t   backend,
           struct wsp_ggml_cgraph * graph,
                          int   n_threads,
          wsp_ggml_abort_callback   abort_callback,
                         void * abort_callback_data) {
-    wsp_ggml_backend_ptr backend { wsp_ggml_backend_init_by_type(WSP_GGML_BACKEND_DEVICE_TYPE_CPU, nullptr) };
-
-    auto * reg = wsp_ggml_backend_dev_backend_reg(wsp_ggml_backend_get_device(backend.get()));
+    auto * reg = wsp_ggml_backend_dev_backend_reg(wsp_ggml_backend_get_device(backend));
 
     auto * set_abort_callback_fn = (wsp_ggml_backend_set_abort_callback_t) wsp_ggml_backend_reg_get_proc_address(reg, "wsp_ggml_backend_set_abort_callback");
     if (set_abort_callback_fn) {
-        set_abort_callback_fn(backend.get(), abort_callback, abort_callback_data);
+        set_abort_callback_fn(backend, abort_callback, abort_callback_data);
     }
 
     auto wsp_ggml_backend_set_n_threads_fn = (wsp_ggml_backend_set_n_threads_t) wsp_ggml_backend_reg_get_proc_address(reg, "wsp_ggml_backend_set_n_threads");
     if (wsp_ggml_backend_set_n_threads_fn) {
-        wsp_ggml_backend_set_n_threads_fn(backend.get(), n_threads);
+        wsp_ggml_backend_set_n_threads_fn(backend, n_threads);
     }
 
-    return wsp_ggml_backend_graph_compute(backend.get(), graph) == WSP_GGML_STATUS_SUCCESS;
+    return wsp_ggml_backend_graph_compute(backend, graph) == WSP_GGML_STATUS_SUCCESS;
 }
 
 static bool wsp_ggml_graph_compute_helper(
@@ -716,6 +831,50 @@ struct whisper_kv_cache {
     std::vector<uint8_t> ctx_buf;
 };
 
+// read-only mapping of a model file, see whisper_context_params.use_mmap
+struct whisper_mmap {
+    uint8_t * addr = nullptr;
+    size_t    size = 0;
+    size_t    pos  = 0; // read position of the loader
+
+    whisper_mmap() = default;
+    whisper_mmap(const whisper_mmap &) = delete;
+    whisper_mmap & operator=(const whisper_mmap &) = delete;
+
+    ~whisper_mmap() {
+#ifdef WHISPER_USE_MMAP
+        if (addr) {
+            munmap(addr, size);
+        }
+#endif
+    }
+
+    static std::shared_ptr<whisper_mmap> open(const char * path) {
+#ifdef WHISPER_USE_MMAP
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        void * addr = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            return nullptr;
+        }
+        auto mapping = std::make_shared<whisper_mmap>();
+        mapping->addr = (uint8_t *) addr;
+        mapping->size = st.st_size;
+        return mapping;
+#else
+        WSP_GGML_UNUSED(path);
+        return nullptr;
+#endif
+    }
+};
+
 struct whisper_model {
     e_model type = MODEL_UNKNOWN;
 
@@ -756,6 +915,10 @@ struct whisper_model {
     // the model backend data is read-only and can be shared between processors
     std::vector<wsp_ggml_backend_buffer_t> buffers;
 
+    // weights of CPU buffers that point into the model file, kept mapped until the model is freed
+    std::shared_ptr<whisper_mmap> mapping;
+    wsp_ggml_backend_buffer_t     buffer_mapped = nullptr;
+
     // tensors
     int n_loaded;
     std::map<std::string, struct wsp_ggml_tensor *> tensors;
@@ -831,6 +994,33 @@ struct vad_time_mapping {
     int64_t original_time;   // Corresponding time in original audio
 };
 
+// identifies an encoder input window: hash of the padded mel window and the audio context
+struct whisper_encoder_key {
+    uint64_t hash  = 0;
+    int      n_ctx = 0;
+
+    bool operator==(const whisper_encoder_key & other) const {
+        return hash == other.hash && n_ctx == other.n_ctx;
+    }
+};
+
+struct whisper_encoder_cache_entry {
+    whisper_encoder_key  key;
+    std::vector<uint8_t> embd_enc;
+};
+
+static uint64_t whisper_mel_hash(const std::vector<float> & mel) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    const uint32_t * data = (const uint32_t *) mel.data();
+    for (size_t i = 0; i < mel.size(); ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
 struct whisper_state {
     int64_t t_sample_us = 0;
     int64_t t_encode_us = 0;
@@ -846,6 +1036,8 @@ struct whisper_state {
     int32_t n_prompt = 0; // number of decoder calls with n_tokens >  1  (prompt encoding)
     int32_t n_fail_p = 0; // number of logprob threshold failures
     int32_t n_fail_h = 0; // number of entropy threshold failures
+    int32_t n_draft  = 0; // number of tokens drafted for speculative decoding
+    int32_t n_accept = 0; // number of drafted tokens accepted
 
     // number of decoders for which we have constructed the KV cache
     int32_t kv_self_n_dec = 0;
@@ -868,6 +1060,8 @@ struct whisper_state {
 
     std::vector<wsp_ggml_backend_t> backends;
 
+    whisper_threadpool threadpool;
+
     // - stores meta info about the intermediate tensors into the `meta` buffers
     whisper_sched sched_conv;
     whisper_sched sched_encode;
@@ -878,6 +1072,16 @@ struct whisper_state {
     struct wsp_ggml_tensor * embd_conv = nullptr;
     struct wsp_ggml_tensor * embd_enc  = nullptr;
 
+    // encoder input that produced the current kv_cross contents
+    whisper_encoder_key kv_cross_key;
+
+    // prompt held by WHISPER_PROMPT_SEQ in kv_self, decoded against the kv_cross of kv_prompt_key
+    std::vector<whisper_token> kv_prompt;
+    whisper_encoder_key        kv_prompt_key;
+
+    // recent encoder outputs, most recently used first
+    std::list<whisper_encoder_cache_entry> encoder_cache;
+
     // helpers for GPU offloading
     std::vector<float> inp_mel;
     std::vector<float> inp_mask;
@@ -919,9 +1123,14 @@ struct whisper_state {
 
     // [EXPERIMENTAL] speed-up techniques
     int32_t exp_n_audio_ctx = 0; // 0 - use default
+    int32_t n_audio_ctx_last = 0; // audio context of the last encoded window
 
     whisper_vad_context * vad_context = nullptr;
 
+    // state of the draft model for speculative decoding, created on first use
+    whisper_context * draft_ctx   = nullptr;
+    whisper_state   * draft_state = nullptr;
+
     struct vad_segment_info {
         int64_t orig_start;
         int64_t orig_end;
@@ -965,10 +1174,121 @@ static void read_safe(whisper_model_loader * loader, T & dest) {
     BYTESWAP_VALUE(dest);
 }
 
+static size_t whisper_mmap_read(void * ctx, void * output, size_t read_size) {
+    whisper_mmap * mapping = (whisper_mmap *) ctx;
+
+    size_t n = std::min(read_size, mapping->size - mapping->pos);
+    memcpy(output, mapping->addr + mapping->pos, n);
+    mapping->pos += n;
+
+    return n;
+}
+
+// the CPU kernels access weights with at least the natural alignment of their type
+static size_t whisper_mmap_align(wsp_ggml_type type) {
+    switch (type) {
+        case WSP_GGML_TYPE_I8:
+            return 1;
+        case WSP_GGML_TYPE_F16:
+        case WSP_GGML_TYPE_BF16:
+        case WSP_GGML_TYPE_I16:
+        case WSP_GGML_TYPE_Q4_0:
+        case WSP_GGML_TYPE_Q4_1:
+        case WSP_GGML_TYPE_Q5_0:
+        case WSP_GGML_TYPE_Q5_1:
+        case WSP_GGML_TYPE_Q8_0:
+            return 2;
+        case WSP_GGML_TYPE_F64:
+        case WSP_GGML_TYPE_I64:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+// Points the CPU tensors straight at their data in the mapped file instead of
+// allocating and reading them. The ggml format does not align tensor data, so
+// tensors at an offset below the alignment of their type are left for the
+// regular allocation. Returns the number of mapped bytes.
+static size_t whisper_mmap_tensors(
+        whisper_mmap & mapping,
+        whisper_model & model,
+        const std::set<const wsp_ggml_tensor *> & cpu_tensors) {
+    size_t pos = mapping.pos;
+    size_t n_bytes = 0;
+
+    while (pos + 3*sizeof(int32_t) <= mapping.size) {
+        int32_t n_dims;
+        int32_t length;
+        memcpy(&n_dims, mapping.addr + pos, sizeof(n_dims));
+        memcpy(&length, mapping.addr + pos + sizeof(int32_t), sizeof(length));
+        pos += 3*sizeof(int32_t);
+
+        if (n_dims < 0 || n_dims > 4 || length < 0 || pos + n_dims*sizeof(int32_t) + length > mapping.size) {
+            break;
+        }
+        pos += n_dims*sizeof(int32_t);
+
+        const std::string name((const char *) mapping.addr + pos, length);
+        pos += length;
+
+        // unknown tensors and size mismatches are reported by the regular load
+        auto it = model.tensors.find(name);
+        if (it == model.tensors.end()) {
+            break;
+        }
+
+        wsp_ggml_tensor * tensor = it->second;
+        const size_t nbytes = wsp_ggml_nbytes(tensor);
+        if (pos + nbytes > mapping.size) {
+            break;
+        }
+
+        if (tensor->data == nullptr && cpu_tensors.count(tensor) && pos % whisper_mmap_align(tensor->type) == 0) {
+            if (!model.buffer_mapped) {
+                model.buffer_mapped = wsp_ggml_backend_cpu_buffer_from_ptr(mapping.addr, mapping.size);
+                if (!model.buffer_mapped) {
+                    return 0;
+                }
+            }
+            wsp_ggml_backend_tensor_alloc(model.buffer_mapped, tensor, mapping.addr + pos);
+            n_bytes += nbytes;
+        }
+
+        pos += nbytes;
+    }
+
+    return n_bytes;
+}
+
+// resolve a requested KV cache type, unsupported types fall back to F16
+static wsp_ggml_type whisper_kv_cache_type(wsp_ggml_type type, bool transposed, const char * name) {
+    switch (type) {
+        case WSP_GGML_TYPE_F16:
+        case WSP_GGML_TYPE_F32:
+            return type;
+        case WSP_GGML_TYPE_Q8_0:
+        case WSP_GGML_TYPE_Q5_0:
+        case WSP_GGML_TYPE_Q5_1:
+        case WSP_GGML_TYPE_Q4_0:
+        case WSP_GGML_TYPE_Q4_1:
+            if (!transposed) {
+                return type;
+            }
+            // the non-flash path stores V transposed, which can't be quantized per row
+            WHISPER_LOG_WARN("%s: quantized %s cache requires flash_attn - using f16\n", __func__, name);
+            return WSP_GGML_TYPE_F16;
+        default:
+            WHISPER_LOG_WARN("%s: unsupported %s cache type %s - using f16\n", __func__, name, wsp_ggml_type_name(type));
+            return WSP_GGML_TYPE_F16;
+    }
+}
+
 static bool whisper_kv_cache_init(
              struct whisper_kv_cache & cache,
                       wsp_ggml_backend_t   backend,
-                           wsp_ggml_type   wtype,
+                           wsp_ggml_type   type_k,
+                           wsp_ggml_type   type_v,
                              int64_t   n_text_state,
                              int64_t   n_text_layer,
                                  int   n_ctx) {
@@ -996,8 +1316,8 @@ static bool whisper_kv_cache_init(
         return false;
     }
 
-    cache.k = wsp_ggml_new_tensor_1d(ctx, wtype, n_elements);
-    cache.v = wsp_ggml_new_tensor_1d(ctx, wtype, n_elements);
+    cache.k = wsp_ggml_new_tensor_1d(ctx, type_k, n_elements);
+    cache.v = wsp_ggml_new_tensor_1d(ctx, type_v, n_elements);
 
     cache.buffer = wsp_ggml_backend_alloc_ctx_tensors(ctx, backend);
     if (!cache.buffer) {
@@ -1136,6 +1456,26 @@ static void whisper_kv_cache_seq_cp(
     }
 }
 
+static void whisper_kv_cache_seq_keep(
+        struct whisper_kv_cache & cache,
+                 whisper_seq_id   seq_id) {
+    uint32_t new_head = cache.size;
+
+    for (uint32_t i = 0; i < cache.size; ++i) {
+        if (cache.cells[i].has_seq_id(seq_id)) {
+            cache.cells[i].seq_id.clear();
+            cache.cells[i].seq_id.insert(seq_id);
+        } else {
+            cache.cells[i].pos = -1;
+            cache.cells[i].seq_id.clear();
+            if (new_head == cache.size) new_head = i;
+        }
+    }
+
+    // If we freed up a slot, set head to it so searching can start there.
+    if (new_head != cache.size) cache.head = new_head;
+}
+
 static uint32_t whisper_kv_cache_get_padding(const struct whisper_context & wctx) {
     if (!wctx.params.flash_attn || !wctx.params.use_gpu) {
         return 1u;
@@ -1845,6 +2185,24 @@ static bool whisper_model_load(struct whisper_model_loader * loader, whisper_con
         wsp_ggml_free(ctx);
     }
 
+    // map the weights of the CPU buffer from the model file
+    whisper_mmap * mapping = loader->read == whisper_mmap_read ? (whisper_mmap *) loader->context : nullptr;
+    if (mapping) {
+        std::set<const wsp_ggml_tensor *> cpu_tensors;
+        auto it = ctx_map.find(wsp_ggml_backend_cpu_buffer_type());
+        if (it != ctx_map.end()) {
+            for (auto * t = wsp_ggml_get_first_tensor(it->second); t != nullptr; t = wsp_ggml_get_next_tensor(it->second, t)) {
+                cpu_tensors.insert(t);
+            }
+        }
+
+        const size_t size_mapped = whisper_mmap_tensors(*mapping, model, cpu_tensors);
+        if (model.buffer_mapped) {
+            model.buffers.emplace_back(model.buffer_mapped);
+            WHISPER_LOG_INFO("%s: %12s total size = %8.2f MB\n", __func__, wsp_ggml_backend_buffer_name(model.buffer_mapped), size_mapped / 1e6);
+        }
+    }
+
     // allocate tensors in the backend buffers
     for (auto & p : ctx_map) {
         wsp_ggml_backend_buffer_type_t buft = p.first;
@@ -1919,7 +2277,10 @@ static bool whisper_model_load(struct whisper_model_loader * loader, whisper_con
                 return false;
             }
 
-            if (wsp_ggml_backend_buffer_is_host(tensor->buffer)) {
+            if (mapping && tensor->buffer == model.buffer_mapped) {
+                // already in place, see whisper_mmap_tensors
+                mapping->pos += wsp_ggml_nbytes(tensor);
+            } else if (wsp_ggml_backend_buffer_is_host(tensor->buffer)) {
                 // for the CPU and Metal backend, we can read directly into the tensor
                 loader->read(loader->context, tensor->data, wsp_ggml_nbytes(tensor));
                 BYTESWAP_TENSOR(tensor);
@@ -2319,15 +2680,15 @@ static struct wsp_ggml_cgraph * whisper_build_graph_cross(
 
         if (wctx.params.flash_attn) {
             k = wsp_ggml_view_1d(ctx0, wstate.kv_cross.k, n_state*n_ctx,
-                    (wsp_ggml_element_size(wstate.kv_cross.k)*n_state)*(il*n_ctx_pad));
+                    wsp_ggml_row_size(wstate.kv_cross.k->type, n_state)*(il*n_ctx_pad));
 
             v = wsp_ggml_view_1d(ctx0, wstate.kv_cross.v, n_state*n_ctx,
-                    (wsp_ggml_element_size(wstate.kv_cross.v)*n_state)*(il*n_ctx_pad));
+                    wsp_ggml_row_size(wstate.kv_cross.v->type, n_state)*(il*n_ctx_pad));
         } else {
             Vcross = wsp_ggml_transpose(ctx0, wsp_ggml_reshape_2d(ctx0, Vcross, n_state, n_ctx));
 
             k = wsp_ggml_view_1d(ctx0, wstate.kv_cross.k, n_state*n_ctx,
-                    (wsp_ggml_element_size(wstate.kv_cross.k)*n_state)*(il*n_ctx));
+                    wsp_ggml_row_size(wstate.kv_cross.k->type, n_state)*(il*n_ctx));
 
             v = wsp_ggml_view_2d(ctx0, wstate.kv_cross.v, n_ctx, n_state,
                     (   n_ctx)*wsp_ggml_element_size(wstate.kv_cross.v),
@@ -2364,6 +2725,64 @@ static bool whisper_encode_internal(
                    void * abort_callback_data) {
     const int64_t t_start_us = wsp_ggml_time_us();
 
+    whisper_threadpool_prepare(wstate.threadpool, wstate.backends, n_threads);
+
+    const int n_ctx = wstate.exp_n_audio_ctx > 0 ? wstate.exp_n_audio_ctx : wctx.model.hparams.n_audio_ctx;
+
+    // the mel window, zero padded to 2*n_ctx frames
+    {
+        const auto & mel_inp = wstate.mel;
+
+        assert(mel_inp.n_mel == wctx.model.hparams.n_mels);
+
+        wstate.inp_mel.assign(mel_inp.n_mel*2*n_ctx, 0.0f);
+
+        float * dst = wstate.inp_mel.data();
+
+        const int i0 = std::min(mel_offset,           mel_inp.n_len);
+        const int i1 = std::min(mel_offset + 2*n_ctx, mel_inp.n_len);
+
+        for (int j = 0; j < mel_inp.n_mel; ++j) {
+            for (int i = i0; i < i1; ++i) {
+                dst[j*2*n_ctx + (i - i0)] = mel_inp.data[j*mel_inp.n_len + i];
+            }
+        }
+    }
+
+    whisper_encoder_key key;
+    key.hash  = whisper_mel_hash(wstate.inp_mel);
+    key.n_ctx = n_ctx;
+
+    // the flash attention paths read the caches up to n_ctx padded to 256, rows past n_ctx may hold
+    // values written with another audio context
+    if (wctx.params.flash_attn && n_ctx != wstate.n_audio_ctx_last && n_ctx % 256 != 0) {
+        wsp_ggml_backend_buffer_clear(wstate.kv_cross.buffer, 0);
+        wsp_ggml_backend_buffer_clear(wstate.kv_pad.buffer, 0);
+        wstate.kv_cross_key = {};
+    }
+    wstate.n_audio_ctx_last = n_ctx;
+
+    // the same window was encoded last (e.g. language detection before the transcription)
+    if (wstate.kv_cross_key == key) {
+        WHISPER_LOG_DEBUG("%s: reusing the cross-attention cache of the last window\n", __func__);
+
+        wstate.t_encode_us += wsp_ggml_time_us() - t_start_us;
+        wstate.n_encode++;
+
+        return !(abort_callback && abort_callback(abort_callback_data));
+    }
+
+    wstate.kv_cross_key = {};
+
+    const whisper_encoder_cache_entry * cached = nullptr;
+    for (auto it = wstate.encoder_cache.begin(); it != wstate.encoder_cache.end(); ++it) {
+        if (it->key == key) {
+            wstate.encoder_cache.splice(wstate.encoder_cache.begin(), wstate.encoder_cache, it);
+            cached = &wstate.encoder_cache.front();
+            break;
+        }
+    }
+
     // conv
     {
         auto & sched = wstate.sched_conv.sched;
@@ -2377,32 +2796,15 @@ static bool whisper_encode_internal(
 
         struct wsp_ggml_tensor * mel = wsp_ggml_graph_get_tensor(gf, "mel");
 
-        // set the input
-        {
-            const auto & mel_inp = wstate.mel;
-            const int n_ctx      = wstate.exp_n_audio_ctx > 0 ? wstate.exp_n_audio_ctx : wctx.model.hparams.n_audio_ctx;
-
-            assert(mel->type == WSP_GGML_TYPE_F32);
-            assert(mel_inp.n_mel == wctx.model.hparams.n_mels);
-
-            wstate.inp_mel.resize(wsp_ggml_nelements(mel));
-
-            float * dst = wstate.inp_mel.data();
-            memset(dst, 0, wsp_ggml_nbytes(mel));
-
-            const int i0 = std::min(mel_offset,           mel_inp.n_len);
-            const int i1 = std::min(mel_offset + 2*n_ctx, mel_inp.n_len);
-
-            for (int j = 0; j < mel_inp.n_mel; ++j) {
-                for (int i = i0; i < i1; ++i) {
-                    dst[j*2*n_ctx + (i - i0)] = mel_inp.data[j*mel_inp.n_len + i];
-                }
-            }
+        assert(mel->type == WSP_GGML_TYPE_F32);
+        assert(wsp_ggml_nelements(mel) == (int64_t) wstate.inp_mel.size());
 
-            wsp_ggml_backend_tensor_set(mel, wstate.inp_mel.data(), 0, wsp_ggml_nelements(mel)*sizeof(float));
-        }
+        wsp_ggml_backend_tensor_set(mel, wstate.inp_mel.data(), 0, wsp_ggml_nelements(mel)*sizeof(float));
 
-        if (!whisper_encode_external(wstate)) {
+        if (cached) {
+            // embd_enc is restored from the cache below
+            wsp_ggml_backend_sched_reset(sched);
+        } else if (!whisper_encode_external(wstate)) {
             if (!wsp_ggml_graph_compute_helper(sched, gf, n_threads)) {
                 return false;
             }
@@ -2428,11 +2830,24 @@ static bool whisper_encode_internal(
             return false;
         }
 
-        if (!wsp_ggml_graph_compute_helper(sched, gf, n_threads)) {
+        if (cached) {
+            wsp_ggml_backend_sched_reset(sched);
+        } else if (!wsp_ggml_graph_compute_helper(sched, gf, n_threads)) {
             return false;
         }
     }
 
+    if (cached) {
+        wsp_ggml_backend_tensor_set(wstate.embd_enc, cached->embd_enc.data(), 0, cached->embd_enc.size());
+    } else if (wctx.params.encoder_cache_size > 0) {
+        if ((int) wstate.encoder_cache.size() >= wctx.params.encoder_cache_size) {
+            wstate.encoder_cache.pop_back();
+        }
+
+        wstate.encoder_cache.push_front({ key, std::vector<uint8_t>(wsp_ggml_nbytes(wstate.embd_enc)) });
+        wsp_ggml_backend_tensor_get(wstate.embd_enc, wstate.encoder_cache.front().embd_enc.data(), 0, wsp_ggml_nbytes(wstate.embd_enc));
+    }
+
     // cross
     {
         auto & sched = wstate.sched_cross.sched;
@@ -2449,6 +2864,8 @@ static bool whisper_encode_internal(
         }
     }
 
+    wstate.kv_cross_key = key;
+
     wstate.t_encode_us += wsp_ggml_time_us() - t_start_us;
     wstate.n_encode++;
 
@@ -2571,15 +2988,15 @@ static struct wsp_ggml_cgraph * whisper_build_graph_decoder(
 
                 if (wctx.params.flash_attn) {
                     k = wsp_ggml_view_1d(ctx0, kv_self.k, n_tokens*n_state,
-                            (wsp_ggml_element_size(kv_self.k)*n_state)*(il*n_ctx + kv_head));
+                            wsp_ggml_row_size(kv_self.k->type, n_state)*(il*n_ctx + kv_head));
 
                     v = wsp_ggml_view_1d(ctx0, kv_self.v, n_tokens*n_state,
-                            (wsp_ggml_element_size(kv_self.v)*n_state)*(il*n_ctx + kv_head));
+                            wsp_ggml_row_size(kv_self.v->type, n_state)*(il*n_ctx + kv_head));
                 } else {
                     Vcur = wsp_ggml_transpose(ctx0, wsp_ggml_reshape_2d(ctx0, Vcur, n_state, n_tokens));
 
                     k = wsp_ggml_view_1d(ctx0, kv_self.k, n_tokens*n_state,
-                            (wsp_ggml_element_size(kv_self.k)*n_state)*(il*n_ctx + kv_head));
+                            wsp_ggml_row_size(kv_self.k->type, n_state)*(il*n_ctx + kv_head));
 
                     v = wsp_ggml_view_2d(ctx0, kv_self.v, n_tokens, n_state,
                             (   n_ctx)*wsp_ggml_element_size(kv_self.v),
@@ -2600,17 +3017,17 @@ static struct wsp_ggml_cgraph * whisper_build_graph_decoder(
             struct wsp_ggml_tensor * K =
                 wsp_ggml_view_3d(ctx0, kv_self.k,
                         n_state_head, n_kv, n_head,
-                        wsp_ggml_element_size(kv_self.k)*n_state,
-                        wsp_ggml_element_size(kv_self.k)*n_state_head,
-                        wsp_ggml_element_size(kv_self.k)*n_state*n_ctx*il);
+                        wsp_ggml_row_size(kv_self.k->type, n_state),
+                        wsp_ggml_row_size(kv_self.k->type, n_state_head),
+                        wsp_ggml_row_size(kv_self.k->type, n_state)*n_ctx*il);
 
             if (wctx.params.flash_attn) {
                 struct wsp_ggml_tensor * V =
                     wsp_ggml_view_3d(ctx0, kv_self.v,
                             n_state_head, n_kv, n_head,
-                            wsp_ggml_element_size(kv_self.v)*n_state,
-                            wsp_ggml_element_size(kv_self.v)*n_state_head,
-                            wsp_ggml_element_size(kv_self.v)*n_state*n_ctx*il);
+                            wsp_ggml_row_size(kv_self.v->type, n_state),
+                            wsp_ggml_row_size(kv_self.v->type, n_state_head),
+                            wsp_ggml_row_size(kv_self.v->type, n_state)*n_ctx*il);
 
                 cur = wsp_ggml_flash_attn_ext(ctx0, Q, K, V, KQ_mask_f16, 1.0f, 0.0f, 0.0f);
 
@@ -2681,16 +3098,16 @@ static struct wsp_ggml_cgraph * whisper_build_graph_decoder(
                 struct wsp_ggml_tensor * Kcross =
                     wsp_ggml_view_3d(ctx0, wstate.kv_cross.k,
                             n_state_head, n_audio_ctx_pad, n_head,
-                            wsp_ggml_element_size(wstate.kv_cross.k)*n_state,
-                            wsp_ggml_element_size(wstate.kv_cross.k)*n_state_head,
-                            wsp_ggml_element_size(wstate.kv_cross.k)*n_state*n_audio_ctx_pad*il);
+                            wsp_ggml_row_size(wstate.kv_cross.k->type, n_state),
+                            wsp_ggml_row_size(wstate.kv_cross.k->type, n_state_head),
+                            wsp_ggml_row_size(wstate.kv_cross.k->type, n_state)*n_audio_ctx_pad*il);
 
                 struct wsp_ggml_tensor * Vcross =
                     wsp_ggml_view_3d(ctx0, wstate.kv_cross.v,
                             n_state_head, n_audio_ctx_pad, n_head,
-                            wsp_ggml_element_size(wstate.kv_cross.v)*n_state,
-                            wsp_ggml_element_size(wstate.kv_cross.v)*n_state_head,
-                            wsp_ggml_element_size(wstate.kv_cross.v)*n_state*n_audio_ctx_pad*il);
+                            wsp_ggml_row_size(wstate.kv_cross.v->type, n_state),
+                            wsp_ggml_row_size(wstate.kv_cross.v->type, n_state_head),
+                            wsp_ggml_row_size(wstate.kv_cross.v->type, n_state)*n_audio_ctx_pad*il);
 
                 cur = wsp_ggml_flash_attn_ext(ctx0, Q, Kcross, Vcross, nullptr, KQscale, 0.0f, 0.0f);
 
@@ -2699,9 +3116,9 @@ static struct wsp_ggml_cgraph * whisper_build_graph_decoder(
                 struct wsp_ggml_tensor * Kcross =
                     wsp_ggml_view_3d(ctx0, wstate.kv_cross.k,
                             n_state_head, n_audio_ctx, n_head,
-                            wsp_ggml_element_size(wstate.kv_cross.k)*n_state,
-                            wsp_ggml_element_size(wstate.kv_cross.k)*n_state_head,
-                            wsp_ggml_element_size(wstate.kv_cross.k)*n_state*n_audio_ctx*il);
+                            wsp_ggml_row_size(wstate.kv_cross.k->type, n_state),
+                            wsp_ggml_row_size(wstate.kv_cross.k->type, n_state_head),
+                            wsp_ggml_row_size(wstate.kv_cross.k->type, n_state)*n_audio_ctx*il);
 
                 struct wsp_ggml_tensor * Vcross =
                     wsp_ggml_view_3d(ctx0, wstate.kv_cross.v,
@@ -2863,6 +3280,8 @@ static bool whisper_decode_internal(
 
     auto & logits_out = wstate.logits;
 
+    whisper_threadpool_prepare(wstate.threadpool, wstate.backends, n_threads);
+
     struct wsp_ggml_tensor * logits;
 
     // find KV slot for the batch
@@ -3384,7 +3803,7 @@ struct whisper_state * whisper_init_state(whisper_context * ctx) {
     // at this point, we don't know yet how many decoders will be used
     // later during decoding, if more decoders are used, we will recreate the KV cache respectively
     state->kv_self_n_dec = 1;
-    if (!whisper_kv_cache_init(state->kv_self, state->backends[0], ctx->itype,
+    if (!whisper_kv_cache_init(state->kv_self, state->backends[0], ctx->params.type_k, ctx->params.type_v,
                 ctx->model.hparams.n_text_state,
                 ctx->model.hparams.n_text_layer,
                 WSP_GGML_PAD(ctx->model.hparams.n_text_ctx, 256))) {
@@ -3398,7 +3817,7 @@ struct whisper_state * whisper_init_state(whisper_context * ctx) {
         WHISPER_LOG_INFO("%s: kv self size  = %7.2f MB\n", __func__, memory_size / 1e6);
     }
 
-    if (!whisper_kv_cache_init(state->kv_cross, state->backends[0], ctx->itype,
+    if (!whisper_kv_cache_init(state->kv_cross, state->backends[0], ctx->params.type_k, ctx->params.type_v,
                 ctx->model.hparams.n_text_state,
                 ctx->model.hparams.n_text_layer,
                 WSP_GGML_PAD(ctx->model.hparams.n_audio_ctx, 256))) {
@@ -3412,7 +3831,7 @@ struct whisper_state * whisper_init_state(whisper_context * ctx) {
         WHISPER_LOG_INFO("%s: kv cross size = %7.2f MB\n", __func__, memory_size / 1e6);
     }
 
-    if (!whisper_kv_cache_init(state->kv_pad, state->backends[0], ctx->itype,
+    if (!whisper_kv_cache_init(state->kv_pad, state->backends[0], ctx->itype, ctx->itype,
                 ctx->model.hparams.n_audio_state,
                 1,
                 WSP_GGML_PAD(ctx->model.hparams.n_audio_ctx, 256))) {
@@ -3621,12 +4040,48 @@ struct whisper_context_params whisper_context_default_params() {
             /*.heads            =*/ NULL,
         },
         /*.dtw_mem_size         =*/ 1024*1024*128,
+
+        /*.use_mmap             =*/ false,
+
+        /*.type_k               =*/ WSP_GGML_TYPE_F16,
+        /*.type_v               =*/ WSP_GGML_TYPE_F16,
+
+        /*.encoder_cache_size   =*/ 0,
     };
     return result;
 }
 
 struct whisper_context * whisper_init_from_file_with_params_no_state(const char * path_model, struct whisper_context_params params) {
     WHISPER_LOG_INFO("%s: loading model from '%s'\n", __func__, path_model);
+
+    if (params.use_mmap) {
+        auto mapping = whisper_mmap::open(path_model);
+        if (mapping) {
+            whisper_model_loader loader = {};
+
+            loader.context = mapping.get();
+            loader.read = whisper_mmap_read;
+
+            loader.eof = [](void * ctx) {
+                whisper_mmap * mapping = (whisper_mmap *) ctx;
+                return mapping->pos >= mapping->size;
+            };
+
+            loader.close = [](void * /*ctx*/) { };
+
+            auto ctx = whisper_init_with_params_no_state(&loader, params);
+
+            if (ctx) {
+                ctx->path_model = path_model;
+                if (ctx->model.buffer_mapped) {
+                    ctx->model.mapping = std::move(mapping);
+                }
+            }
+
+            return ctx;
+        }
+        WHISPER_LOG_WARN("%s: failed to map '%s', reading it instead\n", __func__, path_model);
+    }
 #ifdef _MSC_VER
     // Convert UTF-8 path to wide string (UTF-16) for Windows, resolving character encoding issues.
     std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
@@ -3714,10 +4169,14 @@ struct whisper_context * whisper_init_with_params_no_state(struct whisper_model_
         params.dtw_token_timestamps = false;
     }
 
+    params.type_k = whisper_kv_cache_type(params.type_k, false, "K");
+    params.type_v = whisper_kv_cache_type(params.type_v, !params.flash_attn, "V");
+
     WHISPER_LOG_INFO("%s: use gpu    = %d\n", __func__, params.use_gpu);
     WHISPER_LOG_INFO("%s: flash attn = %d\n", __func__, params.flash_attn);
     WHISPER_LOG_INFO("%s: gpu_device = %d\n", __func__, params.gpu_device);
     WHISPER_LOG_INFO("%s: dtw        = %d\n", __func__, params.dtw_token_timestamps);
+    WHISPER_LOG_INFO("%s: kv type    = %s / %s\n", __func__, wsp_ggml_type_name(params.type_k), wsp_ggml_type_name(params.type_v));
     WHISPER_LOG_INFO("%s: devices    = %zu\n", __func__, wsp_ggml_backend_dev_count());
     WHISPER_LOG_INFO("%s: backends   = %zu\n", __func__, wsp_ggml_backend_reg_count());
 
@@ -3747,6 +4206,18 @@ struct whisper_context * whisper_init_with_params_no_state(struct whisper_model_
 
     loader->close(loader->context);
 
+    // quantized cache rows are split per head, so the head size must fill whole blocks
+    {
+        const int n_state_head = ctx->model.hparams.n_text_state/ctx->model.hparams.n_text_head;
+
+        for (wsp_ggml_type * type : { &ctx->params.type_k, &ctx->params.type_v }) {
+            if (n_state_head % wsp_ggml_blck_size(*type) != 0) {
+                WHISPER_LOG_WARN("%s: head size %d is not a multiple of the %s block size - using f16 kv cache\n", __func__, n_state_head, wsp_ggml_type_name(*type));
+                *type = WSP_GGML_TYPE_F16;
+            }
+        }
+    }
+
     return ctx;
 }
 
@@ -3819,6 +4290,16 @@ struct whisper_context * whisper_init_no_state(struct whisper_model_loader * loa
     return whisper_init_with_params_no_state(loader, whisper_context_default_params());
 }
 
+void whisper_attach_threadpool(struct whisper_context * ctx, wsp_ggml_threadpool_t threadpool) {
+    whisper_attach_threadpool_with_state(ctx, ctx->state, threadpool);
+}
+
+void whisper_attach_threadpool_with_state(struct whisper_context * ctx, struct whisper_state * state, wsp_ggml_threadpool_t threadpool) {
+    WSP_GGML_UNUSED(ctx);
+
+    whisper_threadpool_attach(state->threadpool, state->backends, threadpool);
+}
+
 void whisper_free_state(struct whisper_state * state) {
     if (state) {
         whisper_kv_cache_free(state->kv_self);
@@ -3850,6 +4331,8 @@ void whisper_free_state(struct whisper_state * state) {
             wsp_ggml_backend_free(backend);
         }
 
+        whisper_threadpool_free_owned(state->threadpool);
+
         // [EXPERIMENTAL] Token-level timestamps with DTW
         aheads_masks_free(state->aheads_masks);
 
@@ -3858,6 +4341,8 @@ void whisper_free_state(struct whisper_state * state) {
             state->vad_context = nullptr;
         }
 
+        whisper_free_state(state->draft_state);
+
         delete state;
     }
 }
@@ -3921,6 +4406,9 @@ int whisper_set_mel_with_state(
     state->mel.data.resize(n_len*n_mel);
     memcpy(state->mel.data.data(), data, n_len*n_mel*sizeof(float));
 
+    // a caller provided mel is always encoded again
+    state->kv_cross_key = {};
+
     return 0;
 }
 
@@ -4293,6 +4781,9 @@ void whisper_print_timings(struct whisper_context * ctx) {
         WHISPER_LOG_INFO("%s:   decode time = %8.2f ms / %5d runs ( %8.2f ms per run)\n", __func__, 1e-3f * ctx->state->t_decode_us, n_decode, 1e-3f * ctx->state->t_decode_us / n_decode);
         WHISPER_LOG_INFO("%s:   batchd time = %8.2f ms / %5d runs ( %8.2f ms per run)\n", __func__, 1e-3f * ctx->state->t_batchd_us, n_batchd, 1e-3f * ctx->state->t_batchd_us / n_batchd);
         WHISPER_LOG_INFO("%s:   prompt time = %8.2f ms / %5d runs ( %8.2f ms per run)\n", __func__, 1e-3f * ctx->state->t_prompt_us, n_prompt, 1e-3f * ctx->state->t_prompt_us / n_prompt);
+        if (ctx->state->n_draft > 0) {
+            WHISPER_LOG_INFO("%s:   draft accept = %5d / %5d tokens\n", __func__, ctx->state->n_accept, ctx->state->n_draft);
+        }
     }
     WHISPER_LOG_INFO("%s:    total time = %8.2f ms\n", __func__, (t_end_us - ctx->t_start_us)/1000.0f);
 }
@@ -4311,6 +4802,11 @@ void whisper_reset_timings(struct whisper_context * ctx) {
         ctx->state->n_decode = 0;
         ctx->state->n_batchd = 0;
         ctx->state->n_prompt = 0;
+        ctx->state->n_draft = 0;
+        ctx->state->n_accept = 0;
+
+        // the next encode is timed, do not let it reuse the last window
+        ctx->state->kv_cross_key = {};
     }
 }
 
@@ -4432,6 +4928,7 @@ struct whisper_vad_context {
     int     n_threads;
 
     std::vector<wsp_ggml_backend_t> backends;
+    whisper_threadpool          threadpool;
     wsp_ggml_backend_buffer_t       buffer = nullptr;
     whisper_context_params      params;
     std::vector<uint8_t>        ctx_buf;
@@ -4441,6 +4938,7 @@ struct whisper_vad_context {
     std::string          path_model;
     struct wsp_ggml_tensor * h_state;
     struct wsp_ggml_tensor * c_state;
+    struct wsp_ggml_tensor * h_batch; // hidden states of the windows in the current batch
     std::vector<float>   probs;
 };
 
@@ -4470,7 +4968,7 @@ static int cs_to_samples(int64_t cs) {
     return (int)((cs / 100.0) * WHISPER_SAMPLE_RATE + 0.5);
 }
 
-static int64_t samples_to_cs(int samples) {
+static int64_t samples_to_cs(int64_t samples) {
     return (int64_t)((samples / (double)WHISPER_SAMPLE_RATE) * 100.0 + 0.5);
 }
 
@@ -4534,20 +5032,46 @@ static wsp_ggml_backend_buffer_type_t select_weight_buft(const whisper_vad_hpara
     return nullptr;
 }
 
+// conv_1d over a batch of independent sequences
+// b: [L, IC, N] -> [OL, OC, N] (wsp_ggml_conv_1d() only handles N == 1)
+static wsp_ggml_tensor * whisper_vad_conv_1d(wsp_ggml_context * ctx0,
+        wsp_ggml_tensor * a, wsp_ggml_tensor * b, int s0, int p0, int d0) {
+    wsp_ggml_tensor * im2col = wsp_ggml_im2col(ctx0, a, b, s0, 0, p0, 0, d0, 0, false, WSP_GGML_TYPE_F16); // [N, OL, IC * K]
+
+    const int64_t OL = im2col->ne[1];
+    const int64_t N  = im2col->ne[2];
+    const int64_t OC = a->ne[2];
+
+    wsp_ggml_tensor * cur =
+        wsp_ggml_mul_mat(ctx0,
+                wsp_ggml_reshape_2d(ctx0, im2col, im2col->ne[0], OL * N), // [N, OL, IC * K] => [N*OL, IC * K]
+                wsp_ggml_reshape_2d(ctx0, a, a->ne[0] * a->ne[1], OC));   // [OC, IC, K] => [OC, IC * K]
+
+    if (N == 1) {
+        return wsp_ggml_reshape_3d(ctx0, cur, OL, OC, 1);
+    }
+
+    // [OC, N*OL] => [N, OC, OL]
+    cur = wsp_ggml_reshape_3d(ctx0, cur, OL, N, OC);
+    cur = wsp_ggml_cont(ctx0, wsp_ggml_permute(ctx0, cur, 0, 2, 1, 3));
+
+    return cur;
+}
+
 static wsp_ggml_tensor * whisper_vad_build_stft_layer(wsp_ggml_context * ctx0,
         const whisper_vad_model & model, wsp_ggml_tensor * cur) {
     // Apply reflective padding to the input tensor
     wsp_ggml_tensor * padded = wsp_ggml_pad_reflect_1d(ctx0, cur, 64, 64);
 
-    struct wsp_ggml_tensor * stft = wsp_ggml_conv_1d(ctx0, model.stft_forward_basis, padded, model.hparams.lstm_input_size, 0, 1);
+    struct wsp_ggml_tensor * stft = whisper_vad_conv_1d(ctx0, model.stft_forward_basis, padded, model.hparams.lstm_input_size, 0, 1);
 
     // Calculate cutoff for real/imaginary parts
     int cutoff = model.stft_forward_basis->ne[2] / 2;
 
     // Extract real part (first half of the STFT output).
-    struct wsp_ggml_tensor * real_part = wsp_ggml_view_2d(ctx0, stft, 4, cutoff, stft->nb[1], 0);
+    struct wsp_ggml_tensor * real_part = wsp_ggml_view_3d(ctx0, stft, 4, cutoff, stft->ne[2], stft->nb[1], stft->nb[2], 0);
     // Extract imaginary part (second half of the STFT output).
-    struct wsp_ggml_tensor * img_part = wsp_ggml_view_2d(ctx0, stft, 4, cutoff, stft->nb[1], cutoff * stft->nb[1]);
+    struct wsp_ggml_tensor * img_part = wsp_ggml_view_3d(ctx0, stft, 4, cutoff, stft->ne[2], stft->nb[1], stft->nb[2], cutoff * stft->nb[1]);
 
     // Calculate magnitude: sqrt(real^2 + imag^2)
     struct wsp_ggml_tensor * real_squared = wsp_ggml_mul(ctx0, real_part, real_part);
@@ -4560,74 +5084,87 @@ static wsp_ggml_tensor * whisper_vad_build_stft_layer(wsp_ggml_context * ctx0,
 static wsp_ggml_tensor * whisper_vad_build_encoder_layer(wsp_ggml_context * ctx0,
         const whisper_vad_model & model, wsp_ggml_tensor * cur) {
     // First Conv1D: expands to 128 channels.
-    cur = wsp_ggml_conv_1d(ctx0, model.encoder_0_weight, cur, 1, 1, 1);
+    cur = whisper_vad_conv_1d(ctx0, model.encoder_0_weight, cur, 1, 1, 1);
     cur = wsp_ggml_add(ctx0, cur, wsp_ggml_reshape_3d(ctx0, model.encoder_0_bias, 1, 128, 1));
     cur = wsp_ggml_relu(ctx0, cur);
 
     // Second Conv1D: reduces to 64 channels.
-    cur = wsp_ggml_conv_1d(ctx0, model.encoder_1_weight, cur, 2, 1, 1);
+    cur = whisper_vad_conv_1d(ctx0, model.encoder_1_weight, cur, 2, 1, 1);
     cur = wsp_ggml_add(ctx0, cur, wsp_ggml_reshape_3d(ctx0, model.encoder_1_bias, 1, 64, 1));
     cur = wsp_ggml_relu(ctx0, cur);
 
     // Third Conv1D: maintains 64 channels
-    cur = wsp_ggml_conv_1d(ctx0, model.encoder_2_weight, cur, 2, 1, 1);
+    cur = whisper_vad_conv_1d(ctx0, model.encoder_2_weight, cur, 2, 1, 1);
     cur = wsp_ggml_add(ctx0, cur, wsp_ggml_reshape_3d(ctx0, model.encoder_2_bias, 1, 64, 1));
     cur = wsp_ggml_relu(ctx0, cur);
 
     // Fourth Conv1D: expands to 128 channels
-    cur = wsp_ggml_conv_1d(ctx0, model.encoder_3_weight, cur, 1, 1, 1);
+    cur = whisper_vad_conv_1d(ctx0, model.encoder_3_weight, cur, 1, 1, 1);
     cur = wsp_ggml_add(ctx0, cur, wsp_ggml_reshape_3d(ctx0, model.encoder_3_bias, 1, 128, 1));
     cur = wsp_ggml_relu(ctx0, cur);
 
     return cur;
 }
 
+// cur: [hdim, n_batch] LSTM inputs of consecutive windows
+// the input-to-hidden projection is computed for the whole batch, only the recurrence is unrolled
+// returns [hdim, 1, n_batch] hidden states (stored in vctx.h_batch)
 static wsp_ggml_tensor * whisper_vad_build_lstm_layer(wsp_ggml_context * ctx0,
         const whisper_vad_context & vctx, wsp_ggml_tensor * cur, wsp_ggml_cgraph * gf) {
     const whisper_vad_model & model = vctx.model;
-    const int hdim = model.hparams.lstm_hidden_size;
-
-    struct wsp_ggml_tensor * x_t = wsp_ggml_transpose(ctx0, cur);
+    const int hdim    = model.hparams.lstm_hidden_size;
+    const int n_batch = cur->ne[1];
 
     // Create operations using the input-to-hidden weights.
-    struct wsp_ggml_tensor * inp_gate = wsp_ggml_mul_mat(ctx0, model.lstm_ih_weight, x_t);
-    inp_gate = wsp_ggml_add(ctx0, inp_gate, model.lstm_ih_bias);
+    struct wsp_ggml_tensor * inp_gates = wsp_ggml_mul_mat(ctx0, model.lstm_ih_weight, cur);
+    inp_gates = wsp_ggml_add(ctx0, inp_gates, model.lstm_ih_bias);
+
+    struct wsp_ggml_tensor * h_t = vctx.h_state;
+    struct wsp_ggml_tensor * c_t = vctx.c_state;
+
+    for (int i = 0; i < n_batch; ++i) {
+        struct wsp_ggml_tensor * inp_gate = wsp_ggml_view_1d(ctx0, inp_gates, 4*hdim, i*inp_gates->nb[1]);
 
-    // Create operations using the hidden-to-hidden weights.
-    struct wsp_ggml_tensor * hid_gate = wsp_ggml_mul_mat(ctx0, model.lstm_hh_weight, vctx.h_state);
-    hid_gate = wsp_ggml_add(ctx0, hid_gate, model.lstm_hh_bias);
+        // Create operations using the hidden-to-hidden weights.
+        struct wsp_ggml_tensor * hid_gate = wsp_ggml_mul_mat(ctx0, model.lstm_hh_weight, h_t);
+        hid_gate = wsp_ggml_add(ctx0, hid_gate, model.lstm_hh_bias);
 
-    // Create add operation to get preactivations for all gates.
-    struct wsp_ggml_tensor * out_gate = wsp_ggml_add(ctx0, inp_gate, hid_gate);
+        // Create add operation to get preactivations for all gates.
+        struct wsp_ggml_tensor * out_gate = wsp_ggml_add(ctx0, inp_gate, hid_gate);
 
-    const size_t hdim_size = wsp_ggml_row_size(out_gate->type, hdim);
+        const size_t hdim_size = wsp_ggml_row_size(out_gate->type, hdim);
 
-    // Create sigmoid for input gate (using the first 128 bytes from the preactivations).
-    struct wsp_ggml_tensor * i_t = wsp_ggml_sigmoid(ctx0, wsp_ggml_view_1d(ctx0, out_gate, hdim, 0 * hdim_size));
+        // Create sigmoid for input gate (using the first 128 bytes from the preactivations).
+        struct wsp_ggml_tensor * i_t = wsp_ggml_sigmoid(ctx0, wsp_ggml_view_1d(ctx0, out_gate, hdim, 0 * hdim_size));
 
-    // Create sigmoid for the forget gate (using the second 128 bytes from the preactivations).
-    struct wsp_ggml_tensor * f_t = wsp_ggml_sigmoid(ctx0, wsp_ggml_view_1d(ctx0, out_gate, hdim, 1 * hdim_size));
+        // Create sigmoid for the forget gate (using the second 128 bytes from the preactivations).
+        struct wsp_ggml_tensor * f_t = wsp_ggml_sigmoid(ctx0, wsp_ggml_view_1d(ctx0, out_gate, hdim, 1 * hdim_size));
 
-    // Create sigmoid for the cell gate (using the third 128 bytes from the preactivations).
-    struct wsp_ggml_tensor * g_t = wsp_ggml_tanh(ctx0, wsp_ggml_view_1d(ctx0, out_gate, hdim, 2 * hdim_size));
+        // Create sigmoid for the cell gate (using the third 128 bytes from the preactivations).
+        struct wsp_ggml_tensor * g_t = wsp_ggml_tanh(ctx0, wsp_ggml_view_1d(ctx0, out_gate, hdim, 2 * hdim_size));
 
-    // Create sigmoid for the output gate (using the fourth 128 bytes from the preactivations).
-    struct wsp_ggml_tensor * o_t = wsp_ggml_sigmoid(ctx0, wsp_ggml_view_1d(ctx0, out_gate, hdim, 3 * hdim_size));
+        // Create sigmoid for the output gate (using the fourth 128 bytes from the preactivations).
+        struct wsp_ggml_tensor * o_t = wsp_ggml_sigmoid(ctx0, wsp_ggml_view_1d(ctx0, out_gate, hdim, 3 * hdim_size));
 
-    // Update cell state
-    struct wsp_ggml_tensor * c_out = wsp_ggml_add(ctx0,
-        wsp_ggml_mul(ctx0, f_t, vctx.c_state),
-        wsp_ggml_mul(ctx0, i_t, g_t));
-    wsp_ggml_build_forward_expand(gf, wsp_ggml_cpy(ctx0, c_out, vctx.c_state));
+        // Update cell state
+        c_t = wsp_ggml_add(ctx0,
+            wsp_ggml_mul(ctx0, f_t, c_t),
+            wsp_ggml_mul(ctx0, i_t, g_t));
 
-    // Update hidden state
-    struct wsp_ggml_tensor * out = wsp_ggml_mul(ctx0, o_t, wsp_ggml_tanh(ctx0, c_out));
-    wsp_ggml_build_forward_expand(gf, wsp_ggml_cpy(ctx0, out,   vctx.h_state));
+        // Update hidden state
+        h_t = wsp_ggml_mul(ctx0, o_t, wsp_ggml_tanh(ctx0, c_t));
+        wsp_ggml_build_forward_expand(gf, wsp_ggml_cpy(ctx0, h_t, wsp_ggml_view_1d(ctx0, vctx.h_batch, hdim, i*vctx.h_batch->nb[1])));
+    }
+
+    // carry the state over to the next batch
+    wsp_ggml_build_forward_expand(gf, wsp_ggml_cpy(ctx0, c_t, vctx.c_state));
+    wsp_ggml_build_forward_expand(gf, wsp_ggml_cpy(ctx0, h_t, vctx.h_state));
 
-    return out;
+    return wsp_ggml_view_3d(ctx0, vctx.h_batch, hdim, 1, n_batch, vctx.h_batch->nb[1], vctx.h_batch->nb[1], 0);
 }
 
-static struct wsp_ggml_cgraph * whisper_vad_build_graph(whisper_vad_context & vctx) {
+// n_batch consecutive windows are processed by a single graph
+static struct wsp_ggml_cgraph * whisper_vad_build_graph(whisper_vad_context & vctx, int n_batch) {
     const auto & model = vctx.model;
 
     struct wsp_ggml_init_params params = {
@@ -4638,9 +5175,9 @@ static struct wsp_ggml_cgraph * whisper_vad_build_graph(whisper_vad_context & vc
 
     struct wsp_ggml_context * ctx0 = wsp_ggml_init(params);
 
-    wsp_ggml_cgraph * gf = wsp_ggml_new_graph(ctx0);
+    wsp_ggml_cgraph * gf = wsp_ggml_new_graph_custom(ctx0, WHISPER_MAX_NODES, false);
 
-    struct wsp_ggml_tensor * frame = wsp_ggml_new_tensor_2d(ctx0, WSP_GGML_TYPE_F32, vctx.n_window, 1);
+    struct wsp_ggml_tensor * frame = wsp_ggml_new_tensor_3d(ctx0, WSP_GGML_TYPE_F32, vctx.n_window, 1, n_batch);
     wsp_ggml_set_name(frame, "frame");
     wsp_ggml_set_input(frame);
 
@@ -4652,11 +5189,12 @@ static struct wsp_ggml_cgraph * whisper_vad_build_graph(whisper_vad_context & vc
 
         // Extract the first element of the first dimension
         // (equivalent to pytorch's [:, :, 0])
-        cur = wsp_ggml_view_2d(ctx0, cur, 1, 128, cur->nb[1], 0);
+        cur = wsp_ggml_view_3d(ctx0, cur, 1, 128, n_batch, cur->nb[1], cur->nb[2], 0);
+        cur = wsp_ggml_reshape_2d(ctx0, wsp_ggml_cont(ctx0, cur), 128, n_batch);
 
         cur = whisper_vad_build_lstm_layer(ctx0, vctx, cur, gf);
         cur = wsp_ggml_relu(ctx0, cur);
-        cur = wsp_ggml_conv_1d(ctx0, model.final_conv_weight, cur, 1, 0, 1);
+        cur = whisper_vad_conv_1d(ctx0, model.final_conv_weight, cur, 1, 0, 1);
         cur = wsp_ggml_add(ctx0, cur, model.final_conv_bias);
         cur = wsp_ggml_sigmoid(ctx0, cur);
         wsp_ggml_set_name(cur, "prob");
@@ -4686,7 +5224,7 @@ static bool whisper_vad_init_context(whisper_vad_context * vctx) {
 
     const int32_t lstm_hidden_size = vctx->model.hparams.lstm_hidden_size;
 
-    vctx->ctx_buf.resize(2u*wsp_ggml_tensor_overhead());
+    vctx->ctx_buf.resize(3u*wsp_ggml_tensor_overhead());
 
     struct wsp_ggml_init_params params = {
         /*.mem_size   =*/ vctx->ctx_buf.size(),
@@ -4708,6 +5246,10 @@ static bool whisper_vad_init_context(whisper_vad_context * vctx) {
     vctx->c_state = wsp_ggml_new_tensor_1d(ctx, WSP_GGML_TYPE_F32, lstm_hidden_size);
     wsp_ggml_set_name(vctx->c_state, "c_state");
 
+    // LSTM outputs of a batch of windows
+    vctx->h_batch = wsp_ggml_new_tensor_2d(ctx, WSP_GGML_TYPE_F32, lstm_hidden_size, WHISPER_VAD_N_BATCH);
+    wsp_ggml_set_name(vctx->h_batch, "h_batch");
+
     vctx->buffer = wsp_ggml_backend_alloc_ctx_tensors(ctx, vctx->backends[0]);
     wsp_ggml_free(ctx);
     if (!vctx->buffer) {
@@ -4718,7 +5260,7 @@ static bool whisper_vad_init_context(whisper_vad_context * vctx) {
     {
         bool ok = whisper_sched_graph_init(vctx->sched, vctx->backends,
                 [&]() {
-                    return whisper_vad_build_graph(*vctx);
+                    return whisper_vad_build_graph(*vctx, WHISPER_VAD_N_BATCH);
                 });
 
         if (!ok) {
@@ -5120,60 +5662,64 @@ bool whisper_vad_detect_speech_no_reset(
     vctx->probs.resize(n_chunks);
     WHISPER_LOG_INFO("%s: props size: %u\n", __func__, n_chunks);
 
-    std::vector<float> window(vctx->n_window, 0.0f);
-
     auto & sched = vctx->sched.sched;
 
-    wsp_ggml_cgraph * gf = whisper_vad_build_graph(*vctx);
+    whisper_threadpool_prepare(vctx->threadpool, vctx->backends, vctx->n_threads);
 
-    if (!wsp_ggml_backend_sched_alloc_graph(sched, gf)) {
-        WHISPER_LOG_ERROR("%s: failed to allocate the compute buffer\n", __func__);
-        return false;
-    }
+    const int64_t t_start_vad_us = wsp_ggml_time_us();
 
-    struct wsp_ggml_tensor * frame = wsp_ggml_graph_get_tensor(gf, "frame");
-    struct wsp_ggml_tensor * prob  = wsp_ggml_graph_get_tensor(gf, "prob");
+    wsp_ggml_cgraph * gf = nullptr;
 
-    // we are going to reuse the graph multiple times for each chunk
-    const int64_t t_start_vad_us = wsp_ggml_time_us();
+    struct wsp_ggml_tensor * frame = nullptr;
+    struct wsp_ggml_tensor * prob  = nullptr;
+
+    int n_batch_cur = 0;
 
-    for (int i = 0; i < n_chunks; i++) {
-        const int idx_start = i * vctx->n_window;
-        const int idx_end = std::min(idx_start + vctx->n_window, n_samples);
+    // zero-padded windows of the last batch
+    std::vector<float> tail;
 
-        const int chunk_len = idx_end - idx_start;
+    // run the windows through the graph in batches of WHISPER_VAD_N_BATCH - the LSTM state is carried over
+    for (int i0 = 0; i0 < n_chunks; i0 += WHISPER_VAD_N_BATCH) {
+        const int n_batch = std::min(WHISPER_VAD_N_BATCH, n_chunks - i0);
 
-        if (chunk_len < vctx->n_window) {
-            WHISPER_LOG_INFO("%s: chunk_len: %d < n_window: %d\n", __func__, chunk_len, vctx->n_window);
-            std::vector<float> partial_chunk(vctx->n_window, 0.0f);
-            std::copy(samples + idx_start, samples + idx_end, partial_chunk.begin());
+        // we are going to reuse the graph for all batches of the same size
+        if (n_batch != n_batch_cur) {
+            wsp_ggml_backend_sched_reset(sched);
+
+            gf = whisper_vad_build_graph(*vctx, n_batch);
 
-            // Copy the zero-padded chunk to the window.
-            const int samples_to_copy_max = vctx->n_window;
-            const int samples_to_copy_cur = std::min(samples_to_copy_max, (int)partial_chunk.size());
-            std::copy(partial_chunk.begin(), partial_chunk.begin() + samples_to_copy_cur, window.begin());
-            if (samples_to_copy_cur < samples_to_copy_max) {
-                std::fill(window.begin() + samples_to_copy_cur, window.end(), 0.0f);
+            if (!wsp_ggml_backend_sched_alloc_graph(sched, gf)) {
+                WHISPER_LOG_ERROR("%s: failed to allocate the compute buffer\n", __func__);
+                return false;
             }
-        } else {
-            // Copy current frame samples to the window.
-            const int samples_to_copy = std::min(idx_end - idx_start, vctx->n_window);
-            std::copy(samples + idx_start, samples + idx_start + samples_to_copy, window.begin());
+
+            frame = wsp_ggml_graph_get_tensor(gf, "frame");
+            prob  = wsp_ggml_graph_get_tensor(gf, "prob");
+
+            n_batch_cur = n_batch;
         }
 
+        const int idx_start = i0 * vctx->n_window;
+        const int idx_end   = std::min(idx_start + n_batch * vctx->n_window, n_samples);
+
         // Set the frame tensor data with the samples.
-        wsp_ggml_backend_tensor_set(frame, window.data(), 0, wsp_ggml_nelements(frame) * sizeof(float));
+        if (idx_end - idx_start == n_batch * vctx->n_window) {
+            wsp_ggml_backend_tensor_set(frame, samples + idx_start, 0, wsp_ggml_nbytes(frame));
+        } else {
+            WHISPER_LOG_INFO("%s: chunk_len: %d < n_window: %d\n", __func__, (idx_end - idx_start) % vctx->n_window, vctx->n_window);
+            tail.assign(n_batch * vctx->n_window, 0.0f);
+            std::copy(samples + idx_start, samples + idx_end, tail.begin());
+            wsp_ggml_backend_tensor_set(frame, tail.data(), 0, wsp_ggml_nbytes(frame));
+        }
 
-        // do not reset the scheduler - we will reuse the graph in the next chunk
+        // do not reset the scheduler - we will reuse the graph in the next batch
         if (!wsp_ggml_graph_compute_helper(sched, gf, vctx->n_threads, false)) {
             WHISPER_LOG_ERROR("%s: failed to compute VAD graph\n", __func__);
             break;
         }
 
-        // Get the probability for this chunk.
-        wsp_ggml_backend_tensor_get(prob, &vctx->probs[i], 0, sizeof(float));
-
-        //WHISPER_LOG_DEBUG("chunk %d: p = %7.3f\n", i, probs[i]);
+        // Get the probabilities for this batch.
+        wsp_ggml_backend_tensor_get(prob, &vctx->probs[i0], 0, n_batch * sizeof(float));
     }
 
     vctx->t_vad_us += wsp_ggml_time_us() - t_start_vad_us;
@@ -5461,25 +6007,312 @@ struct whisper_vad_segments * whisper_vad_segments_from_samples(
     return whisper_vad_segments_from_probs(vctx, params);
 }
 
-void whisper_vad_free(whisper_vad_context * ctx) {
-    if (ctx) {
-        if (ctx->buffer) {
-            wsp_ggml_backend_buffer_free(ctx->buffer);
-        }
-        for (wsp_ggml_context * context : ctx->model.ctxs) {
-            wsp_ggml_free(context);
-        }
+//
+// streaming VAD
+//
 
-        for (wsp_ggml_backend_buffer_t buf : ctx->model.buffers) {
-            wsp_ggml_backend_buffer_free(buf);
-        }
+struct whisper_vad_stream_event {
+    bool  speech; // true: speech started at t0, false: the speech segment [t0, t1] ended
+    float t0;
+    float t1;
+};
 
-        wsp_ggml_backend_sched_free(ctx->sched.sched);
+struct whisper_vad_stream {
+    whisper_vad_context * vctx = nullptr;
+
+    // same rules as whisper_vad_segments_from_probs(), in samples
+    float   threshold;
+    float   neg_threshold;
+    int64_t min_silence_samples;
+    int64_t min_speech_samples;
+    int64_t speech_pad_samples;
+    int64_t max_speech_samples;
+    int64_t min_silence_samples_at_max_speech;
+    int64_t max_merge_gap_samples;
+
+    std::vector<float> pending; // samples that do not fill a window yet
+    int64_t n_samples = 0;      // samples processed by the VAD model so far (whole windows)
+
+    // detection state, see whisper_vad_segments_from_probs()
+    bool    is_speech_segment = false;
+    bool    has_curr_speech   = false;
+    int64_t temp_end          = 0;
+    int64_t prev_end          = 0;
+    int64_t next_start        = 0;
+    int64_t curr_speech_start = 0;
+
+    // detected speech that may still be merged with the next detection
+    bool    seg_open  = false;
+    int64_t seg_start = 0;
+    int64_t seg_end   = 0;
+
+    bool    speech    = false; // a start event was emitted without its end event
+    int64_t speech_t0 = 0;     // padded start of the current speech
+    int64_t last_end  = 0;     // padded end of the last emitted segment
+
+    std::vector<whisper_vad_stream_event> events;
+};
 
-        for (auto & backend : ctx->backends) {
-            wsp_ggml_backend_free(backend);
+struct whisper_vad_stream * whisper_vad_stream_init(
+        struct whisper_vad_context * vctx,
+         struct whisper_vad_params   params) {
+    whisper_vad_stream * stream = new whisper_vad_stream;
+    stream->vctx = vctx;
+
+    const int64_t sample_rate = WHISPER_SAMPLE_RATE;
+
+    stream->threshold           = params.threshold;
+    stream->neg_threshold       = std::max(params.threshold - 0.15f, 0.01f);
+    stream->min_silence_samples = sample_rate * params.min_silence_duration_ms / 1000;
+    stream->min_speech_samples  = sample_rate * params.min_speech_duration_ms / 1000;
+    stream->speech_pad_samples  = sample_rate * params.speech_pad_ms / 1000;
+
+    if (params.max_speech_duration_s > 100000.0f) {
+        stream->max_speech_samples = INT64_MAX / 2;
+    } else {
+        stream->max_speech_samples = sample_rate * (int64_t) params.max_speech_duration_s - vctx->n_window - 2 * stream->speech_pad_samples;
+        if (stream->max_speech_samples < 0) {
+            stream->max_speech_samples = INT64_MAX / 2;
+        }
+    }
+
+    stream->min_silence_samples_at_max_speech = sample_rate * 98 / 1000;
+    stream->max_merge_gap_samples             = sample_rate * 200 / 1000;
+
+    whisper_vad_reset_state(vctx);
+
+    return stream;
+}
+
+static void whisper_vad_stream_emit_start(whisper_vad_stream & stream, int64_t start) {
+    if (stream.speech) {
+        return;
+    }
+
+    stream.speech    = true;
+    stream.speech_t0 = std::max(start - stream.speech_pad_samples, stream.last_end);
+
+    stream.events.push_back({ true, (float) samples_to_cs(stream.speech_t0), -1.0f });
+}
+
+// emit the open segment, it can no longer be merged with a later detection
+static void whisper_vad_stream_close(whisper_vad_stream & stream) {
+    if (!stream.seg_open) {
+        return;
+    }
+
+    stream.seg_open = false;
+
+    if (stream.seg_end - stream.seg_start < stream.min_speech_samples && !stream.speech) {
+        return;
+    }
+
+    whisper_vad_stream_emit_start(stream, stream.seg_start);
+
+    const int64_t end = std::min(stream.seg_end + stream.speech_pad_samples, stream.n_samples);
+
+    stream.events.push_back({ false, (float) samples_to_cs(stream.speech_t0), (float) samples_to_cs(end) });
+    stream.speech   = false;
+    stream.last_end = end;
+}
+
+// a speech segment was detected, merge it with the open one if the gap is small
+static void whisper_vad_stream_add(whisper_vad_stream & stream, int64_t start, int64_t end) {
+    if (stream.seg_open && start - stream.seg_end < stream.max_merge_gap_samples) {
+        stream.seg_end = end;
+        return;
+    }
+
+    whisper_vad_stream_close(stream);
+
+    stream.seg_open  = true;
+    stream.seg_start = start;
+    stream.seg_end   = end;
+}
+
+// same state machine as the loop in whisper_vad_segments_from_probs()
+static void whisper_vad_stream_detect(whisper_vad_stream & stream, float curr_prob, int64_t curr_sample) {
+    if ((curr_prob >= stream.threshold) && stream.temp_end) {
+        stream.temp_end = 0;
+        if (stream.next_start < stream.prev_end) {
+            stream.next_start = curr_sample;
+        }
+    }
+
+    if ((curr_prob >= stream.threshold) && !stream.is_speech_segment) {
+        stream.is_speech_segment = true;
+        stream.curr_speech_start = curr_sample;
+        stream.has_curr_speech   = true;
+        return;
+    }
+
+    if (stream.is_speech_segment && (curr_sample - stream.curr_speech_start) > stream.max_speech_samples) {
+        if (stream.prev_end) {
+            whisper_vad_stream_add(stream, stream.curr_speech_start, stream.prev_end);
+            stream.has_curr_speech = true;
+
+            if (stream.next_start < stream.prev_end) {
+                stream.is_speech_segment = false;
+                stream.has_curr_speech   = false;
+            } else {
+                stream.curr_speech_start = stream.next_start;
+            }
+            stream.prev_end = stream.next_start = stream.temp_end = 0;
+        } else {
+            whisper_vad_stream_add(stream, stream.curr_speech_start, curr_sample);
+
+            stream.prev_end = stream.next_start = stream.temp_end = 0;
+            stream.is_speech_segment = false;
+            stream.has_curr_speech   = false;
+            return;
+        }
+    }
+
+    if ((curr_prob < stream.neg_threshold) && stream.is_speech_segment) {
+        if (!stream.temp_end) {
+            stream.temp_end = curr_sample;
+        }
+
+        if ((curr_sample - stream.temp_end) > stream.min_silence_samples_at_max_speech) {
+            stream.prev_end = stream.temp_end;
+        }
+
+        if ((curr_sample - stream.temp_end) >= stream.min_silence_samples) {
+            if ((stream.temp_end - stream.curr_speech_start) > stream.min_speech_samples) {
+                whisper_vad_stream_add(stream, stream.curr_speech_start, stream.temp_end);
+            }
+
+            stream.prev_end = stream.next_start = stream.temp_end = 0;
+            stream.is_speech_segment = false;
+            stream.has_curr_speech   = false;
+        }
+    }
+}
+
+static bool whisper_vad_stream_process(whisper_vad_stream & stream, const float * samples, int n_samples) {
+    whisper_vad_context * vctx = stream.vctx;
+
+    if (!whisper_vad_detect_speech_no_reset(vctx, samples, n_samples)) {
+        return false;
+    }
+
+    for (int i = 0; i < whisper_vad_n_probs(vctx); i++) {
+        const int64_t curr_sample = stream.n_samples;
+        stream.n_samples += vctx->n_window;
+
+        whisper_vad_stream_detect(stream, vctx->probs[i], curr_sample);
+
+        // a later detection can not start before this sample
+        const int64_t next_start = stream.is_speech_segment ? stream.curr_speech_start : stream.n_samples;
+        if (stream.seg_open && next_start - stream.seg_end >= stream.max_merge_gap_samples) {
+            whisper_vad_stream_close(stream);
+        }
+
+        // the current speech will be kept once it is longer than min_speech_samples
+        if (stream.is_speech_segment && !stream.temp_end && curr_sample - stream.curr_speech_start > stream.min_speech_samples) {
+            whisper_vad_stream_emit_start(stream, stream.seg_open ? stream.seg_start : stream.curr_speech_start);
+        } else if (stream.seg_open && stream.seg_end - stream.seg_start > stream.min_speech_samples) {
+            whisper_vad_stream_emit_start(stream, stream.seg_start);
+        }
+    }
+
+    return true;
+}
+
+int whisper_vad_stream_push(struct whisper_vad_stream * stream, const float * samples, int n_samples) {
+    const int n_window = stream->vctx->n_window;
+
+    stream->events.clear();
+    stream->pending.insert(stream->pending.end(), samples, samples + n_samples);
+
+    const int n_process = (int) stream->pending.size() / n_window * n_window;
+    if (n_process == 0) {
+        return 0;
+    }
+
+    if (!whisper_vad_stream_process(*stream, stream->pending.data(), n_process)) {
+        WHISPER_LOG_ERROR("%s: failed to detect speech\n", __func__);
+        return -1;
+    }
+
+    stream->pending.erase(stream->pending.begin(), stream->pending.begin() + n_process);
+
+    return (int) stream->events.size();
+}
+
+int whisper_vad_stream_flush(struct whisper_vad_stream * stream) {
+    stream->events.clear();
+
+    // the last window is padded with zeros
+    if (!stream->pending.empty()) {
+        if (!whisper_vad_stream_process(*stream, stream->pending.data(), (int) stream->pending.size())) {
+            WHISPER_LOG_ERROR("%s: failed to detect speech\n", __func__);
+            return -1;
+        }
+        stream->pending.clear();
+    }
+
+    if (stream->has_curr_speech && (stream->n_samples - stream->curr_speech_start) > stream->min_speech_samples) {
+        whisper_vad_stream_add(*stream, stream->curr_speech_start, stream->n_samples);
+    }
+    stream->is_speech_segment = false;
+    stream->has_curr_speech   = false;
+    stream->prev_end = stream->next_start = stream->temp_end = 0;
+
+    whisper_vad_stream_close(*stream);
+
+    return (int) stream->events.size();
+}
+
+int whisper_vad_stream_n_events(struct whisper_vad_stream * stream) {
+    return (int) stream->events.size();
+}
+
+bool whisper_vad_stream_get_event_speech(struct whisper_vad_stream * stream, int i_event) {
+    return stream->events[i_event].speech;
+}
+
+float whisper_vad_stream_get_event_t0(struct whisper_vad_stream * stream, int i_event) {
+    return stream->events[i_event].t0;
+}
+
+float whisper_vad_stream_get_event_t1(struct whisper_vad_stream * stream, int i_event) {
+    return stream->events[i_event].t1;
+}
+
+bool whisper_vad_stream_is_speech(struct whisper_vad_stream * stream) {
+    return stream->speech;
+}
+
+void whisper_vad_stream_free(struct whisper_vad_stream * stream) {
+    delete stream;
+}
+
+void whisper_vad_attach_threadpool(struct whisper_vad_context * ctx, wsp_ggml_threadpool_t threadpool) {
+    whisper_threadpool_attach(ctx->threadpool, ctx->backends, threadpool);
+}
+
+void whisper_vad_free(whisper_vad_context * ctx) {
+    if (ctx) {
+        if (ctx->buffer) {
+            wsp_ggml_backend_buffer_free(ctx->buffer);
+        }
+        for (wsp_ggml_context * context : ctx->model.ctxs) {
+            wsp_ggml_free(context);
+        }
+
+        for (wsp_ggml_backend_buffer_t buf : ctx->model.buffers) {
+            wsp_ggml_backend_buffer_free(buf);
+        }
+
+        wsp_ggml_backend_sched_free(ctx->sched.sched);
+
+        for (auto & backend : ctx->backends) {
+            wsp_ggml_backend_free(backend);
         }
 
+        whisper_threadpool_free_owned(ctx->threadpool);
+
         delete[] ctx->model.hparams.encoder_in_channels;
         delete[] ctx->model.hparams.encoder_out_channels;
         delete[] ctx->model.hparams.kernel_sizes;
@@ -5957,6 +6790,7 @@ struct whisper_full_params whisper_full_default_params(enum whisper_sampling_str
 
         /*.debug_mode        =*/ false,
         /*.audio_ctx         =*/ 0,
+        /*.audio_ctx_auto    =*/ false,
 
         /*.tdrz_enable       =*/ false,
 
@@ -5992,6 +6826,11 @@ struct whisper_full_params whisper_full_default_params(enum whisper_sampling_str
             /*.patience  =*/ -1.0f,
         },
 
+        /*.speculative      =*/ {
+            /*.draft_ctx =*/ nullptr,
+            /*.n_draft   =*/ 4,
+        },
+
         /*.new_segment_callback           =*/ nullptr,
         /*.new_segment_callback_user_data =*/ nullptr,
 
@@ -6814,6 +7653,143 @@ static bool whisper_vad(
     return true;
 }
 
+// decodes the prompt into sequence 0 of kv_self. the self-attention values of every layer past the first
+// depend on the cross-attention, so the cells of the last prompt are only reused while kv_cross holds the
+// same window (temperature fallbacks, language detection, re-transcribing cached audio). then only the
+// tokens after the longest common prefix are decoded, the last row of the batch holds the prompt logits
+static bool whisper_decode_prompt(
+              struct whisper_context & ctx,
+               struct whisper_state  & state,
+    const std::vector<whisper_token> & prompt,
+                                 int   n_threads,
+             wsp_ggml_abort_callback   abort_callback,
+                               void  * abort_callback_data) {
+    int n_keep = 0;
+    if (state.kv_cross_key.n_ctx > 0 && state.kv_prompt_key == state.kv_cross_key) {
+        const int n_max = std::min<int>(state.kv_prompt.size(), prompt.size() - 1);
+        while (n_keep < n_max && state.kv_prompt[n_keep] == prompt[n_keep]) {
+            n_keep++;
+        }
+    }
+
+    if (n_keep > 0) {
+        whisper_kv_cache_seq_keep(state.kv_self, WHISPER_PROMPT_SEQ);
+        whisper_kv_cache_seq_rm  (state.kv_self, WHISPER_PROMPT_SEQ, n_keep, -1);
+        whisper_kv_cache_seq_cp  (state.kv_self, WHISPER_PROMPT_SEQ, 0, -1, -1);
+
+        WHISPER_LOG_DEBUG("%s: reusing %d of %d prompt tokens\n", __func__, n_keep, (int) prompt.size());
+    } else {
+        whisper_kv_cache_clear(state.kv_self);
+    }
+
+    state.kv_prompt.clear();
+
+    whisper_batch_prep_legacy(state.batch, prompt.data() + n_keep, prompt.size() - n_keep, n_keep, 0);
+
+    if (!whisper_decode_internal(ctx, state, state.batch, n_threads, false, abort_callback, abort_callback_data)) {
+        return false;
+    }
+
+    // the cells of the kept prefix are already in the prompt sequence
+    whisper_kv_cache_seq_cp(state.kv_self, 0, WHISPER_PROMPT_SEQ, n_keep, -1);
+
+    state.kv_prompt     = prompt;
+    state.kv_prompt_key = state.kv_cross_key;
+
+    return true;
+}
+
+// speculative decoding step for the single active decoder
+//
+// catches the draft model up with the sampled tokens, lets it draft up to n_draft tokens and evaluates
+// the last sampled token followed by the drafts with the main model in one batch. row r of the main
+// logits follows drafts[r - 1] (row 0 the last sampled token), so every draft the sampler accepts saves
+// a decoder pass. cache cells of rejected drafts are removed from both KV caches first
+static bool whisper_speculative_decode(
+              struct whisper_context & ctx,
+               struct whisper_state  & state,
+              struct whisper_context & ctx_draft,
+               struct whisper_state  & state_draft,
+    const struct whisper_full_params & params,
+  const std::vector<whisper_token_data> & tokens,
+                                 int   n_prompt,
+                                 int & n_draft_past,
+          std::vector<whisper_token> & drafts) {
+    const int n_vocab = ctx.vocab.n_vocab;
+    const int n_past  = n_prompt + (int) tokens.size() - 1; // position of the last sampled token
+    const int n_draft = std::min(params.speculative.n_draft, whisper_n_text_ctx(&ctx) - 1 - n_past);
+
+    whisper_kv_cache_seq_rm(state.kv_self, 0, n_past, -1);
+
+    n_draft_past = std::min(n_draft_past, n_past);
+    whisper_kv_cache_seq_rm(state_draft.kv_self, 0, n_draft_past, -1);
+
+    drafts.clear();
+
+    if (n_draft > 0) {
+        auto & batch_draft = state_draft.batch;
+
+        std::vector<whisper_token> pending;
+        for (int pos = n_draft_past; pos <= n_past; ++pos) {
+            pending.push_back(tokens[pos - n_prompt].id);
+        }
+
+        whisper_batch_prep_legacy(batch_draft, pending.data(), pending.size(), n_draft_past, 0);
+
+        for (int i = 0; i < n_draft; ++i) {
+            if (!whisper_decode_internal(ctx_draft, state_draft, batch_draft, params.n_threads, false, params.abort_callback, params.abort_callback_user_data)) {
+                return false;
+            }
+
+            n_draft_past = n_past + i + 1;
+
+            const float * logits = state_draft.logits.data() + (batch_draft.n_tokens - 1)*n_vocab;
+            const whisper_token id = std::max_element(logits, logits + n_vocab) - logits;
+
+            drafts.push_back(id);
+
+            if (id == whisper_token_eot(&ctx)) {
+                break;
+            }
+
+            whisper_batch_prep_legacy(batch_draft, &id, 1, n_draft_past, 0);
+        }
+
+        state.n_draft += drafts.size();
+    }
+
+    auto & batch = state.batch;
+
+    batch.n_tokens = 0;
+
+    for (int i = 0; i <= (int) drafts.size(); ++i) {
+        const whisper_token id = i == 0 ? tokens.back().id : drafts[i - 1];
+
+        // nothing follows the end of text, an accepted eot completes the decoder
+        if (i > 0 && id == whisper_token_eot(&ctx)) {
+            break;
+        }
+
+        batch.token   [batch.n_tokens]    = id;
+        batch.pos     [batch.n_tokens]    = n_past + i;
+        batch.n_seq_id[batch.n_tokens]    = 1;
+        batch.seq_id  [batch.n_tokens][0] = 0;
+        batch.logits  [batch.n_tokens]    = 1;
+        batch.n_tokens++;
+    }
+
+    return whisper_decode_internal(ctx, state, batch, params.n_threads, false, params.abort_callback, params.abort_callback_user_data);
+}
+
+// audio context for a window with n_frames mel frames left, 0 for the full context
+// two frames per position plus 1 s of headroom, rounded up to 256 positions so a few buckets cover
+// all windows and the flash attention paths read no padding
+static int whisper_audio_ctx_auto(int n_frames, int n_audio_ctx, int n_min) {
+    const int n_ctx = std::max(n_min, (int) WSP_GGML_PAD((n_frames + 100 + 1)/2, 256));
+
+    return n_ctx < n_audio_ctx ? n_ctx : 0;
+}
+
 int whisper_full_with_state(
         struct whisper_context * ctx,
           struct whisper_state * state,
@@ -6833,6 +7809,14 @@ int whisper_full_with_state(
         }
     }
 
+    // language detection encodes the first window, use the context the transcription will use for it
+    if (params.audio_ctx_auto && params.audio_ctx <= whisper_n_audio_ctx(ctx)) {
+        const int n_frames = std::min(whisper_n_len_from_state(state), 100*WHISPER_CHUNK_SIZE);
+        const int n_ctx    = whisper_audio_ctx_auto(n_frames, whisper_n_audio_ctx(ctx), params.audio_ctx);
+
+        state->exp_n_audio_ctx = n_ctx > 0 ? n_ctx : params.audio_ctx;
+    }
+
     // auto-detect language if not specified
     if (params.language == nullptr || strlen(params.language) == 0 || strcmp(params.language, "auto") == 0 || params.detect_language) {
         std::vector<float> probs(whisper_lang_max_id() + 1, 0.0f);
@@ -6975,6 +7959,31 @@ int whisper_full_with_state(
     }
     state->exp_n_audio_ctx = params.audio_ctx;
 
+    // speculative decoding needs the audio for the mel spectrogram of the draft model
+    whisper_context * ctx_draft   = params.speculative.draft_ctx;
+    whisper_state   * state_draft = nullptr;
+
+    if (ctx_draft != nullptr && params.speculative.n_draft > 0 && n_samples > 0) {
+        if (ctx_draft->vocab.n_vocab != ctx->vocab.n_vocab || whisper_token_eot(ctx_draft) != whisper_token_eot(ctx)) {
+            WHISPER_LOG_WARN("%s: draft model vocabulary does not match - disabling speculative decoding\n", __func__);
+        } else {
+            if (state->draft_ctx != ctx_draft) {
+                whisper_free_state(state->draft_state);
+                state->draft_state = whisper_init_state(ctx_draft);
+                state->draft_ctx   = state->draft_state ? ctx_draft : nullptr;
+            }
+
+            state_draft = state->draft_state;
+
+            if (state_draft == nullptr || whisper_pcm_to_mel_with_state(ctx_draft, state_draft, samples, n_samples, params.n_threads) != 0) {
+                WHISPER_LOG_WARN("%s: failed to prepare the draft model - disabling speculative decoding\n", __func__);
+                state_draft = nullptr;
+            } else {
+                state_draft->exp_n_audio_ctx = std::min(params.audio_ctx, whisper_n_audio_ctx(ctx_draft));
+            }
+        }
+    }
+
     // these tokens determine the task that will be performed
     std::vector<whisper_token> prompt_init = { whisper_token_sot(ctx), };
 
@@ -7020,6 +8029,12 @@ int whisper_full_with_state(
     std::vector<std::vector<beam_candidate>> bc_per_dec(n_decoders);
     std::vector<beam_candidate> beam_candidates;
 
+    int seek_draft = -1; // window encoded by the draft model
+
+    std::vector<whisper_token> drafts; // drafts evaluated by the last speculative decode
+    int i_draft      = 0;              // next draft to compare with the sampled token
+    int n_draft_past = 0;              // positions in the draft KV cache
+
     // main loop
     while (true) {
         if (params.progress_callback) {
@@ -7041,6 +8056,20 @@ int whisper_full_with_state(
             }
         }
 
+        bool audio_ctx_reduced = false;
+
+        if (params.audio_ctx_auto) {
+            const int n_frames = std::min(seek_end - seek, 100*WHISPER_CHUNK_SIZE);
+            const int n_ctx    = whisper_audio_ctx_auto(n_frames, whisper_n_audio_ctx(ctx), params.audio_ctx);
+
+            audio_ctx_reduced = n_ctx > 0;
+
+            state->exp_n_audio_ctx = n_ctx > 0 ? n_ctx : params.audio_ctx;
+            if (state_draft) {
+                state_draft->exp_n_audio_ctx = std::min(state->exp_n_audio_ctx, whisper_n_audio_ctx(ctx_draft));
+            }
+        }
+
         // encode audio features starting at offset seek
         if (!whisper_encode_internal(*ctx, *state, seek, params.n_threads, params.abort_callback, params.abort_callback_user_data)) {
             WHISPER_LOG_ERROR("%s: failed to encode\n", __func__);
@@ -7080,6 +8109,8 @@ int whisper_full_with_state(
 
             n_decoders_cur = std::max(1, n_decoders_cur);
 
+            const bool speculative = state_draft != nullptr && n_decoders_cur == 1;
+
             WHISPER_LOG_DEBUG("\n%s: strategy = %d, decoding with %d decoders, temperature = %.2f\n", __func__, params.strategy, n_decoders_cur, t_cur);
 
             // TAGS: WHISPER_DECODER_INIT
@@ -7108,7 +8139,6 @@ int whisper_full_with_state(
             }
 
             // init prompt and kv cache for the current iteration
-            // TODO: do not recompute the prompt if it is the same as previous time
             {
                 prompt.clear();
 
@@ -7152,7 +8182,7 @@ int whisper_full_with_state(
                     // overallocate to workaround KV cache fragmentation issues
                     const int factor = n_decoders_cur > 1 ? n_decoders_cur + 2 : 1;
 
-                    if (!whisper_kv_cache_init(state->kv_self, state->backends[0], ctx->itype,
+                    if (!whisper_kv_cache_init(state->kv_self, state->backends[0], ctx->params.type_k, ctx->params.type_v,
                                 ctx->model.hparams.n_text_state,
                                 ctx->model.hparams.n_text_layer,
                                 WSP_GGML_PAD(ctx->model.hparams.n_text_ctx, 256)*factor)) {
@@ -7162,17 +8192,33 @@ int whisper_full_with_state(
                     }
 
                     state->kv_self_n_dec = n_decoders_cur;
+                    state->kv_prompt.clear();
                 }
 
-                whisper_kv_cache_clear(state->kv_self);
-
-                whisper_batch_prep_legacy(state->batch, prompt.data(), prompt.size(), 0, 0);
-
-                if (!whisper_decode_internal(*ctx, *state, state->batch, params.n_threads, false, params.abort_callback, params.abort_callback_user_data)) {
+                if (!whisper_decode_prompt(*ctx, *state, prompt, params.n_threads, params.abort_callback, params.abort_callback_user_data)) {
                     WHISPER_LOG_ERROR("%s: failed to decode\n", __func__);
                     return -8;
                 }
 
+                if (speculative) {
+                    if (seek_draft != seek) {
+                        if (!whisper_encode_internal(*ctx_draft, *state_draft, seek, params.n_threads, params.abort_callback, params.abort_callback_user_data)) {
+                            WHISPER_LOG_ERROR("%s: failed to encode with the draft model\n", __func__);
+                            return -6;
+                        }
+                        seek_draft = seek;
+                    }
+
+                    if (!whisper_decode_prompt(*ctx_draft, *state_draft, prompt, params.n_threads, params.abort_callback, params.abort_callback_user_data)) {
+                        WHISPER_LOG_ERROR("%s: failed to decode with the draft model\n", __func__);
+                        return -8;
+                    }
+
+                    drafts.clear();
+                    i_draft      = 0;
+                    n_draft_past = prompt.size();
+                }
+
                 // Calculate no_speech probability after first decode.
                 // This has to be done before any logit filtering. Hence we cannot use the probs from the whisper_process_logits.
                 {
@@ -7188,7 +8234,7 @@ int whisper_full_with_state(
                 {
                     const int64_t t_start_sample_us = wsp_ggml_time_us();
 
-                    state->decoders[0].i_batch = prompt.size() - 1;
+                    state->decoders[0].i_batch = state->batch.n_tokens - 1;
 
                     whisper_process_logits(*ctx, *state, state->decoders[0], params, t_cur);
 
@@ -7451,6 +8497,32 @@ int whisper_full_with_state(
 
                 state->t_sample_us += wsp_ggml_time_us() - t_start_sample_us;
 
+                // obtain logits for the next token from an accepted draft, or draft and verify the next ones
+                if (speculative) {
+                    auto & decoder = state->decoders[0];
+
+                    if (i_draft < (int) drafts.size() && drafts[i_draft] == decoder.sequence.tokens.back().id) {
+                        decoder.i_batch = ++i_draft;
+                        state->n_accept++;
+                    } else {
+                        if (!whisper_speculative_decode(*ctx, *state, *ctx_draft, *state_draft, params,
+                                    decoder.sequence.tokens, prompt.size(), n_draft_past, drafts)) {
+                            WHISPER_LOG_ERROR("%s: failed to decode\n", __func__);
+                            return -9;
+                        }
+                        decoder.i_batch = 0;
+                        i_draft = 0;
+                    }
+
+                    const int64_t t_start_sample_us = wsp_ggml_time_us();
+
+                    whisper_process_logits(*ctx, *state, decoder, params, t_cur);
+
+                    state->t_sample_us += wsp_ggml_time_us() - t_start_sample_us;
+
+                    continue;
+                }
+
                 // obtain logits for the next token
                 {
                     auto & batch = state->batch;
@@ -7568,6 +8640,33 @@ int whisper_full_with_state(
                 WHISPER_LOG_DEBUG("%s: best decoder = %d\n", __func__, best_decoder_id);
             }
 
+            // the shortened audio context of a window that decodes poorly may be the cause, encode it
+            // again with the full context and retry the same temperature
+            if (audio_ctx_reduced) {
+                const auto & decoder = state->decoders[best_decoder_id];
+
+                if (decoder.failed ||
+                    (decoder.sequence.avg_logprobs < params.logprob_thold && state->no_speech_prob < params.no_speech_thold)) {
+                    WHISPER_LOG_DEBUG("%s: failed with audio_ctx = %d, retrying with the full context\n", __func__, state->exp_n_audio_ctx);
+
+                    audio_ctx_reduced = false;
+                    state->exp_n_audio_ctx = 0;
+                    if (state_draft) {
+                        // the draft encodes the window again with the full context before its next prompt
+                        state_draft->exp_n_audio_ctx = std::min(whisper_n_audio_ctx(ctx_draft), whisper_n_audio_ctx(ctx));
+                        seek_draft = -1;
+                    }
+
+                    if (!whisper_encode_internal(*ctx, *state, seek, params.n_threads, params.abort_callback, params.abort_callback_user_data)) {
+                        WHISPER_LOG_ERROR("%s: failed to encode\n", __func__);
+                        return -6;
+                    }
+
+                    --it;
+                    continue;
+                }
+            }
+
             bool success = true;
 
             // was the decoding successful for the current temperature?
@@ -8185,6 +9284,379 @@ float whisper_full_get_segment_no_speech_prob_from_state(struct whisper_state *
 
 // =================================================================================================
 
+//
+// Streaming transcription
+//
+
+struct whisper_stream_segment_data {
+    std::string text;
+
+    int64_t t0;
+    int64_t t1;
+};
+
+struct whisper_stream {
+    whisper_context * ctx   = nullptr;
+    whisper_state   * state = nullptr;
+
+    whisper_full_params   params;
+    whisper_stream_params sparams;
+
+    // language detected in the first window, reused for the following ones
+    std::string language;
+
+    // samples in reflect padded coordinates: pcm[0] is padded sample pcm_offset. Until the
+    // first WHISPER_N_FFT/2 + 1 samples have arrived the left padding is not known yet and
+    // pcm holds the raw samples.
+    std::vector<float> pcm;
+    int64_t pcm_offset = WHISPER_N_FFT/2;
+    int64_t n_samples  = 0;
+    bool    padded     = false;
+
+    // raw log10 mel frames [mel_offset, n_mel), stored frame by frame
+    std::vector<float> mel;
+    int64_t mel_offset = 0;
+    int64_t n_mel      = 0;
+
+    int64_t t_window  = 0; // first mel frame of the current window
+    int64_t t_decoded = 0; // n_mel when the window was last transcribed
+
+    // initial prompt followed by the tokens of the committed segments
+    std::vector<whisper_token> prompt;
+
+    std::vector<whisper_stream_segment_data> committed;
+};
+
+struct whisper_stream_params whisper_stream_default_params(void) {
+    struct whisper_stream_params result = {
+        /*.step_ms                     =*/ 1000,
+        /*.length_ms                   =*/ 10000,
+        /*.segments_callback           =*/ nullptr,
+        /*.segments_callback_user_data =*/ nullptr,
+    };
+
+    return result;
+}
+
+struct whisper_stream * whisper_stream_init_with_state(
+        struct whisper_context * ctx,
+          struct whisper_state * state,
+    struct whisper_full_params   params,
+  struct whisper_stream_params   stream_params) {
+    whisper_stream * stream = new whisper_stream;
+
+    stream->ctx     = ctx;
+    stream->state   = state;
+    stream->params  = params;
+    stream->sparams = stream_params;
+
+    stream->sparams.step_ms   = std::max(stream->sparams.step_ms, 100);
+    stream->sparams.length_ms = std::max(std::min(stream->sparams.length_ms, 100*WHISPER_CHUNK_SIZE*10), stream->sparams.step_ms);
+
+    if (params.initial_prompt && strlen(params.initial_prompt) > 0) {
+        stream->prompt.resize(1024);
+        int n_needed = whisper_tokenize(ctx, params.initial_prompt, stream->prompt.data(), stream->prompt.size());
+        if (n_needed < 0) {
+            stream->prompt.resize(-n_needed);
+            n_needed = whisper_tokenize(ctx, params.initial_prompt, stream->prompt.data(), stream->prompt.size());
+        }
+        stream->prompt.resize(std::max(n_needed, 0));
+    }
+
+    // the window and the prompt are owned by the stream
+    stream->params.initial_prompt  = nullptr;
+    stream->params.prompt_tokens   = nullptr;
+    stream->params.prompt_n_tokens = 0;
+    stream->params.no_context      = true;
+    stream->params.single_segment  = false;
+    stream->params.offset_ms       = 0;
+    stream->params.duration_ms     = 0;
+    stream->params.detect_language = false;
+    stream->params.vad             = false;
+
+    // token timestamps need the signal energy of the whole window
+    stream->params.token_timestamps = false;
+
+    stream->params.new_segment_callback           = nullptr;
+    stream->params.new_segment_callback_user_data = nullptr;
+    stream->params.progress_callback              = nullptr;
+    stream->params.progress_callback_user_data    = nullptr;
+
+    return stream;
+}
+
+struct whisper_stream * whisper_stream_init(
+        struct whisper_context * ctx,
+    struct whisper_full_params   params,
+  struct whisper_stream_params   stream_params) {
+    return whisper_stream_init_with_state(ctx, ctx->state, params, stream_params);
+}
+
+void whisper_stream_free(struct whisper_stream * stream) {
+    delete stream;
+}
+
+// Compute the raw log10 mel frames that the samples pushed so far make available. On flush the
+// audio is followed by zeros, like the padding log_mel_spectrogram() adds, so that the frames
+// overlapping the end of the audio are computed as well.
+static void whisper_stream_compute_mel(whisper_stream & stream, bool flush) {
+    const int64_t t_start_us = wsp_ggml_time_us();
+
+    const int frame_size = WHISPER_N_FFT;
+    const int frame_step = WHISPER_HOP_LENGTH;
+    const int pad        = frame_size / 2;
+
+    const auto & filters = stream.ctx->model.filters;
+    const int n_mel = filters.n_mel;
+
+    // reflective pad at the beginning of the audio
+    if (!stream.padded && (stream.n_samples > pad || flush)) {
+        std::vector<float> prefix(pad, 0.0f);
+        for (int i = 0; i < pad && i + 1 < (int) stream.pcm.size(); ++i) {
+            prefix[pad - 1 - i] = stream.pcm[i + 1];
+        }
+        stream.pcm.insert(stream.pcm.begin(), prefix.begin(), prefix.end());
+        stream.pcm_offset = 0;
+        stream.padded     = true;
+    }
+
+    if (!stream.padded) {
+        return;
+    }
+
+    if (flush) {
+        stream.pcm.insert(stream.pcm.end(), frame_size, 0.0f);
+    }
+
+    const int64_t n_padded = stream.pcm_offset + (int64_t) stream.pcm.size();
+    const int64_t n_ready  = n_padded >= frame_size ? (n_padded - frame_size) / frame_step + 1 : 0;
+
+    const int n_new = (int) (n_ready - stream.n_mel);
+    if (n_new <= 0) {
+        return;
+    }
+
+    const int64_t i0 = stream.n_mel * frame_step - stream.pcm_offset;
+    const std::vector<float> samples(
+            stream.pcm.begin() + i0,
+            stream.pcm.begin() + i0 + (int64_t) (n_new - 1) * frame_step + frame_size);
+
+    whisper_mel mel;
+    mel.n_mel     = n_mel;
+    mel.n_len     = n_new;
+    mel.n_len_org = n_new;
+    mel.data.resize((size_t) n_mel * n_new);
+
+    {
+        const int n_threads = std::max(1, std::min(stream.params.n_threads, n_new));
+        const int n_frame_samples = (int) samples.size();
+
+        std::vector<std::thread> workers(n_threads - 1);
+        for (int iw = 0; iw < n_threads - 1; ++iw) {
+            workers[iw] = std::thread(
+                    log_mel_spectrogram_worker_thread, iw + 1, global_cache.hann_window, std::cref(samples),
+                    n_frame_samples, frame_size, frame_step, n_threads,
+                    std::cref(filters), std::ref(mel));
+        }
+
+        // main thread
+        log_mel_spectrogram_worker_thread(0, global_cache.hann_window, samples, n_frame_samples, frame_size, frame_step, n_threads, filters, mel);
+
+        for (int iw = 0; iw < n_threads - 1; ++iw) {
+            workers[iw].join();
+        }
+    }
+
+    // whisper_mel is stored band by band, the stream keeps whole frames
+    const size_t n_prev = stream.mel.size();
+    stream.mel.resize(n_prev + (size_t) n_mel * n_new);
+    for (int i = 0; i < n_new; ++i) {
+        for (int j = 0; j < n_mel; ++j) {
+            stream.mel[n_prev + (size_t) i * n_mel + j] = mel.data[(size_t) j * n_new + i];
+        }
+    }
+    stream.n_mel = n_ready;
+
+    // samples before the next frame are no longer needed
+    const int64_t n_drop = n_ready * frame_step - stream.pcm_offset;
+    stream.pcm.erase(stream.pcm.begin(), stream.pcm.begin() + n_drop);
+    stream.pcm_offset += n_drop;
+
+    stream.state->t_mel_us += wsp_ggml_time_us() - t_start_us;
+}
+
+// Transcribe the current window and commit its finished segments
+static int whisper_stream_decode(whisper_stream & stream, bool flush) {
+    auto * ctx   = stream.ctx;
+    auto * state = stream.state;
+
+    const int n_mel = ctx->model.filters.n_mel;
+    const int n_win = (int) (stream.n_mel - stream.t_window);
+
+    stream.t_decoded = stream.n_mel;
+
+    // whisper_full() skips anything shorter than 100 ms
+    if (n_win < 10) {
+        return 0;
+    }
+
+    // clamp and normalize the window like log_mel_spectrogram(), including the 30 s of
+    // silence that follow the audio
+    {
+        const int n_pad = 100*WHISPER_CHUNK_SIZE;
+        const int n_len = n_win + n_pad;
+
+        const float * src = stream.mel.data() + (size_t) (stream.t_window - stream.mel_offset) * n_mel;
+
+        double mmax = log10(1e-10);
+        for (size_t i = 0; i < (size_t) n_win * n_mel; ++i) {
+            mmax = std::max<double>(mmax, src[i]);
+        }
+        mmax -= 8.0;
+
+        const float pad_value = (float) ((std::max(log10(1e-10), mmax) + 4.0)/4.0);
+
+        // after flush the last frames extend into the padding, whisper_full() only seeks up to
+        // the frames that are fully covered by audio
+        int n_len_org = n_win;
+        if (flush) {
+            const int64_t n_complete = 1 + (stream.n_samples + WHISPER_N_FFT/2 - WHISPER_N_FFT)/WHISPER_HOP_LENGTH;
+            n_len_org = (int) std::max<int64_t>(0, std::min<int64_t>(n_win, n_complete - stream.t_window));
+        }
+
+        auto & mel = state->mel;
+        mel.n_mel     = n_mel;
+        mel.n_len     = n_len;
+        mel.n_len_org = n_len_org;
+        mel.data.resize((size_t) n_mel * n_len);
+
+        for (int j = 0; j < n_mel; ++j) {
+            float * dst = mel.data.data() + (size_t) j * n_len;
+            for (int i = 0; i < n_win; ++i) {
+                dst[i] = (float) ((std::max<double>(src[(size_t) i * n_mel + j], mmax) + 4.0)/4.0);
+            }
+            std::fill(dst + n_win, dst + n_len, pad_value);
+        }
+    }
+
+    whisper_full_params params = stream.params;
+    params.prompt_tokens   = stream.prompt.empty() ? nullptr : stream.prompt.data();
+    params.prompt_n_tokens = (int) stream.prompt.size();
+    if (!stream.language.empty()) {
+        params.language = stream.language.c_str();
+    }
+
+    const int ret = whisper_full_with_state(ctx, state, params, nullptr, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (stream.language.empty()) {
+        const char * language = whisper_lang_str(state->lang_id);
+        stream.language = language ? language : "";
+    }
+
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    const bool commit_all = flush || n_win >= stream.sparams.length_ms/10;
+    const int n_commit = commit_all ? n_segments : std::max(0, n_segments - 1);
+
+    std::vector<whisper_stream_segment> segments;
+    segments.reserve(n_segments);
+
+    const size_t n_committed_prev = stream.committed.size();
+
+    for (int i = 0; i < n_segments; ++i) {
+        const auto & segment = state->result_all[i];
+
+        const int64_t t0 = stream.t_window + std::max<int64_t>(0, std::min<int64_t>(segment.t0, n_win));
+        const int64_t t1 = stream.t_window + std::max<int64_t>(0, std::min<int64_t>(segment.t1, n_win));
+
+        if (i < n_commit) {
+            stream.committed.push_back({ segment.text, t0, t1 });
+
+            for (const auto & token : segment.tokens) {
+                if (token.id < whisper_token_eot(ctx)) {
+                    stream.prompt.push_back(token.id);
+                }
+            }
+        } else {
+            segments.push_back({ segment.text.c_str(), t0, t1, false });
+        }
+    }
+
+    // keep the prompt within the text context of the decoder
+    const size_t n_prompt_max = whisper_n_text_ctx(ctx)/2;
+    if (stream.prompt.size() > n_prompt_max) {
+        stream.prompt.erase(stream.prompt.begin(), stream.prompt.end() - n_prompt_max);
+    }
+
+    // move the window past the committed audio, a full window is dropped if nothing was committed
+    const int64_t t_window_prev = stream.t_window;
+    if (n_commit > 0) {
+        stream.t_window = stream.committed.back().t1;
+    }
+    if (commit_all && stream.t_window <= t_window_prev) {
+        stream.t_window = stream.n_mel;
+    }
+
+    const int64_t keep = stream.t_window - stream.mel_offset;
+    if (keep > 0) {
+        stream.mel.erase(stream.mel.begin(), stream.mel.begin() + (size_t) keep * n_mel);
+        stream.mel_offset = stream.t_window;
+    }
+
+    if (stream.sparams.segments_callback) {
+        std::vector<whisper_stream_segment> all;
+        all.reserve(stream.committed.size() - n_committed_prev + segments.size());
+        for (size_t i = n_committed_prev; i < stream.committed.size(); ++i) {
+            const auto & segment = stream.committed[i];
+            all.push_back({ segment.text.c_str(), segment.t0, segment.t1, true });
+        }
+        all.insert(all.end(), segments.begin(), segments.end());
+
+        stream.sparams.segments_callback(&stream, all.data(), (int) all.size(), stream.sparams.segments_callback_user_data);
+    }
+
+    return 0;
+}
+
+int whisper_stream_push_pcm(struct whisper_stream * stream, const float * samples, int n_samples) {
+    stream->pcm.insert(stream->pcm.end(), samples, samples + n_samples);
+    stream->n_samples += n_samples;
+
+    whisper_stream_compute_mel(*stream, false);
+
+    if (stream->n_mel - stream->t_decoded >= stream->sparams.step_ms/10) {
+        return whisper_stream_decode(*stream, false);
+    }
+
+    return 0;
+}
+
+int whisper_stream_flush(struct whisper_stream * stream) {
+    whisper_stream_compute_mel(*stream, true);
+
+    return whisper_stream_decode(*stream, true);
+}
+
+int whisper_stream_n_segments(struct whisper_stream * stream) {
+    return stream->committed.size();
+}
+
+const char * whisper_stream_get_segment_text(struct whisper_stream * stream, int i_segment) {
+    return stream->committed[i_segment].text.c_str();
+}
+
+int64_t whisper_stream_get_segment_t0(struct whisper_stream * stream, int i_segment) {
+    return stream->committed[i_segment].t0;
+}
+
+int64_t whisper_stream_get_segment_t1(struct whisper_stream * stream, int i_segment) {
+    return stream->committed[i_segment].t1;
+}
+
+// =================================================================================================
+
 //
 // Temporary interface needed for exposing ggml interface
 // Will be removed in the future when ggml becomes a separate library
@@ -8364,6 +9836,11 @@ WHISPER_API const char * whisper_bench_wsp_ggml_mul_mat_str(int n_threads) {
     // when F16 is used, there is an extra work buffer of size N*N*sizeof(float)
     std::vector<uint8_t> buf(3llu*N_max*N_max*sizeof(float) + 3*wsp_ggml_tensor_overhead() + wsp_ggml_graph_overhead());
 
+    // one CPU backend and threadpool for all runs, so thread creation is not part of the timings
+    std::vector<wsp_ggml_backend_t> backends = { wsp_ggml_backend_init_by_type(WSP_GGML_BACKEND_DEVICE_TYPE_CPU, nullptr) };
+    whisper_threadpool threadpool;
+    whisper_threadpool_prepare(threadpool, backends, n_threads);
+
     for (int j = 0; j < (int) sizes.size(); j++) {
         int n_q4_0 = 0;
         int n_q4_1 = 0;
@@ -8425,12 +9902,12 @@ WHISPER_API const char * whisper_bench_wsp_ggml_mul_mat_str(int n_threads) {
             double tsum = 0.0;
 
             // heat-up
-            wsp_ggml_graph_compute_helper(gf, n_threads, nullptr, nullptr);
+            wsp_ggml_graph_compute_helper(backends[0], gf, n_threads, nullptr, nullptr);
 
             for (int i = 0; i < n_max; ++i) {
                 const int64_t t0 = wsp_ggml_time_us();
 
-                wsp_ggml_graph_compute_helper(gf, n_threads, nullptr, nullptr);
+                wsp_ggml_graph_compute_helper(backends[0], gf, n_threads, nullptr, nullptr);
 
                 const int64_t t1 = wsp_ggml_time_us();
 
@@ -8463,6 +9940,9 @@ WHISPER_API const char * whisper_bench_wsp_ggml_mul_mat_str(int n_threads) {
         s += strbuf;
     }
 
+    wsp_ggml_backend_free(backends[0]);
+    whisper_threadpool_free_owned(threadpool);
+
     return s.c_str();
 }
 
@@ -9040,6 +10520,7 @@ static void whisper_exp_compute_token_level_timestamps_dtw(
     // Decoder already returns only alignment head QKs, already concatenated in
     // one tensor.
     whisper_kv_cache_clear(state->kv_self);
+    state->kv_prompt.clear();
     whisper_batch_prep_legacy(state->batch, tokens.data(), tokens.size(), 0, 0);
     whisper_kv_cache_seq_rm(state->kv_self, 0, 0, -1);
     if (!whisper_decode_internal(*ctx, *state, state->batch, n_threads, true, nullptr, nullptr)) {
@@ -9104,8 +10585,9 @@ static void whisper_exp_compute_token_level_timestamps_dtw(
     struct wsp_ggml_cgraph * gf = wsp_ggml_new_graph(gctx);
     wsp_ggml_build_forward_expand(gf, w);
 
-    wsp_ggml_backend_ptr backend { wsp_ggml_backend_init_by_type(WSP_GGML_BACKEND_DEVICE_TYPE_CPU, nullptr) };
-    wsp_ggml_backend_graph_compute(backend.get(), gf);
+    // the CPU backend of the state is the last one
+    whisper_threadpool_prepare(state->threadpool, state->backends, n_threads);
+    wsp_ggml_graph_compute_helper(state->backends.back(), gf, n_threads, nullptr, nullptr);
 
     wsp_ggml_tensor * alignment = dtw_and_backtrace(gctx, w);
 
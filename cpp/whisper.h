@@ -127,6 +127,20 @@ extern "C" {
         struct whisper_aheads dtw_aheads;
 
         size_t dtw_mem_size; // TODO: remove
+
+        // map the model file instead of reading it (whisper_init_from_file_with_params only),
+        // weights placed in CPU buffers then point into the mapping
+        bool use_mmap;
+
+        // KV cache types of the decoder self- and cross-attention, F16 by default.
+        // Q8_0, Q5_0, Q5_1, Q4_0 and Q4_1 are also accepted, a quantized V cache
+        // requires flash_attn and falls back to F16 otherwise
+        enum wsp_ggml_type type_k;
+        enum wsp_ggml_type type_v;
+
+        // encoder outputs kept per state (LRU), re-encoding an identical mel window restores the
+        // output instead. the last encoded window is always reused from the cross-attention cache
+        int encoder_cache_size;
     };
 
     typedef struct whisper_token_data {
@@ -265,6 +279,19 @@ extern "C" {
                     const char * device,
                     const char * cache_dir);
 
+    // Use a caller-owned CPU threadpool (see wsp_ggml_threadpool_new() in ggml-cpu.h) for the graph
+    // computations of the state, instead of the threadpool each state creates on first use.
+    // A threadpool can be shared by several states and contexts, as long as they do not compute at
+    // the same time. Pass NULL to detach, the threadpool must stay alive until it is detached.
+    WHISPER_API void whisper_attach_threadpool(
+        struct whisper_context * ctx,
+         wsp_ggml_threadpool_t   threadpool);
+
+    WHISPER_API void whisper_attach_threadpool_with_state(
+        struct whisper_context * ctx,
+          struct whisper_state * state,
+         wsp_ggml_threadpool_t   threadpool);
+
     // Frees all allocated memory
     WHISPER_API void whisper_free      (struct whisper_context * ctx);
     WHISPER_API void whisper_free_state(struct whisper_state * state);
@@ -514,6 +541,8 @@ extern "C" {
         // note: these can significantly reduce the quality of the output
         bool debug_mode;        // enable debug_mode provides extra info (eg. Dump log_mel)
         int  audio_ctx;         // overwrite the audio context size (0 = use default)
+        bool audio_ctx_auto;    // size the audio context to the audio left in each window, in steps of 256 (5.12 s)
+                                // with audio_ctx as the minimum. windows that decode poorly are retried with the full context
 
         // [EXPERIMENTAL] [TDRZ] tinydiarize
         bool tdrz_enable;       // enable tinydiarize speaker turn detection
@@ -559,6 +588,14 @@ extern "C" {
             float patience; // TODO: not implemented, ref: https://arxiv.org/pdf/2204.05424.pdf
         } beam_search;
 
+        // speculative decoding, used while a single decoder is active (greedy at temperature 0)
+        // draft_ctx is a smaller model with the same vocabulary, it drafts n_draft tokens that the
+        // main model verifies in one batched decode. the output is the same as without a draft model
+        struct {
+            struct whisper_context * draft_ctx;
+            int n_draft;
+        } speculative;
+
         // called for every newly generated text segment
         whisper_new_segment_callback new_segment_callback;
         void * new_segment_callback_user_data;
@@ -693,6 +730,68 @@ extern "C" {
     WHISPER_API int64_t whisper_full_get_vad_segment_t1           (struct whisper_context * ctx, int i);
     WHISPER_API int64_t whisper_full_get_vad_segment_t1_from_state(struct whisper_state * state, int i);
 
+    //
+    // Streaming transcription
+    //
+    // A stream owns the audio of its current window. Pushed audio extends the log mel spectrogram of the
+    // window without recomputing the frames already seen. Every step_ms of new audio the window is
+    // transcribed; all segments but the last one are committed, the window is moved past them and their
+    // tokens are kept as the decoder prompt for the following windows. The last segment is reported as a
+    // partial result until it is committed by a later step (or once the window reaches length_ms).
+    // Not thread safe for the same stream, and the state must not be used for anything else meanwhile.
+
+    struct whisper_stream;
+
+    struct whisper_stream_segment {
+        const char * text;
+        int64_t      t0;        // centiseconds from the start of the stream
+        int64_t      t1;
+        bool         committed; // false for a partial segment that may still change
+    };
+
+    // Called after every transcribed window with the newly committed segments followed by the partial ones
+    typedef void (*whisper_stream_segments_callback)(
+            struct whisper_stream * stream,
+            const struct whisper_stream_segment * segments,
+            int   n_segments,
+            void * user_data);
+
+    struct whisper_stream_params {
+        int step_ms;    // minimum amount of new audio between two transcriptions of the window
+        int length_ms;  // commit every segment once the window reaches this length (at most 30 s)
+
+        whisper_stream_segments_callback segments_callback;
+        void * segments_callback_user_data;
+    };
+
+    WHISPER_API struct whisper_stream_params whisper_stream_default_params(void);
+
+    // The decoding options come from params. Its segment and progress callbacks are not used.
+    WHISPER_API struct whisper_stream * whisper_stream_init(
+                struct whisper_context * ctx,
+            struct whisper_full_params   params,
+          struct whisper_stream_params   stream_params);
+
+    WHISPER_API struct whisper_stream * whisper_stream_init_with_state(
+                struct whisper_context * ctx,
+                  struct whisper_state * state,
+            struct whisper_full_params   params,
+          struct whisper_stream_params   stream_params);
+
+    // Push 16 kHz mono PCM samples. Returns 0 on success, or the whisper_full() error code.
+    WHISPER_API int whisper_stream_push_pcm(struct whisper_stream * stream, const float * samples, int n_samples);
+
+    // Transcribe and commit the remaining audio
+    WHISPER_API int whisper_stream_flush(struct whisper_stream * stream);
+
+    // Segments committed since the stream started
+    WHISPER_API int          whisper_stream_n_segments       (struct whisper_stream * stream);
+    WHISPER_API const char * whisper_stream_get_segment_text (struct whisper_stream * stream, int i_segment);
+    WHISPER_API int64_t      whisper_stream_get_segment_t0   (struct whisper_stream * stream, int i_segment);
+    WHISPER_API int64_t      whisper_stream_get_segment_t1   (struct whisper_stream * stream, int i_segment);
+
+    WHISPER_API void whisper_stream_free(struct whisper_stream * stream);
+
     //
     // Voice Activity Detection (VAD)
     //
@@ -747,6 +846,42 @@ extern "C" {
     WHISPER_API float whisper_vad_segments_get_segment_t0(struct whisper_vad_segments * segments, int i_segment);
     WHISPER_API float whisper_vad_segments_get_segment_t1(struct whisper_vad_segments * segments, int i_segment);
 
+    //
+    // Streaming VAD
+    //
+    // Push audio blocks of any size. Samples that do not fill a VAD window are kept for the next push and
+    // the LSTM state is carried over. Speech start/end events are emitted as soon as they are final, with
+    // the rules of whisper_vad_segments_from_probs() (thresholds, min speech/silence, max speech, merging
+    // of close segments and padding). Times are in centiseconds from the start of the stream.
+    // The stream uses the LSTM state of the VAD context, which must not be used for anything else meanwhile.
+
+    struct whisper_vad_stream;
+
+    WHISPER_API struct whisper_vad_stream * whisper_vad_stream_init(
+            struct whisper_vad_context * vctx,
+            struct whisper_vad_params    params);
+
+    // Push 16 kHz mono PCM samples. Returns the number of events emitted, or -1 on failure.
+    WHISPER_API int whisper_vad_stream_push(struct whisper_vad_stream * stream, const float * samples, int n_samples);
+
+    // Process the remaining samples and end the current speech. Returns the number of events emitted, or -1 on failure.
+    WHISPER_API int whisper_vad_stream_flush(struct whisper_vad_stream * stream);
+
+    // Events emitted by the last push/flush call
+    // speech: true when speech started at t0 (t1 is -1), false when the speech segment [t0, t1] ended
+    WHISPER_API int   whisper_vad_stream_n_events        (struct whisper_vad_stream * stream);
+    WHISPER_API bool  whisper_vad_stream_get_event_speech(struct whisper_vad_stream * stream, int i_event);
+    WHISPER_API float whisper_vad_stream_get_event_t0    (struct whisper_vad_stream * stream, int i_event);
+    WHISPER_API float whisper_vad_stream_get_event_t1    (struct whisper_vad_stream * stream, int i_event);
+
+    // Whether the stream is inside a speech segment (a start event was emitted without its end event)
+    WHISPER_API bool whisper_vad_stream_is_speech(struct whisper_vad_stream * stream);
+
+    WHISPER_API void whisper_vad_stream_free(struct whisper_vad_stream * stream);
+
+    // Same as whisper_attach_threadpool() for the VAD context
+    WHISPER_API void whisper_vad_attach_threadpool(struct whisper_vad_context * ctx, wsp_ggml_threadpool_t threadpool);
+
     WHISPER_API void whisper_vad_free_segments(struct whisper_vad_segments * segments);
     WHISPER_API void whisper_vad_free         (struct whisper_vad_context  * ctx);
 
@@ -149,6 +149,10 @@ WhisperContextInitResult hostInitWhisperContext(
     auto params = whisper_context_default_params();
     params.use_gpu = options.useGpu;
     params.flash_attn = options.useFlashAttn;
+    params.use_mmap = options.useMmap;
+    params.type_k = options.cacheTypeK;
+    params.type_v = options.cacheTypeV;
+    params.encoder_cache_size = options.encoderCacheSize;
     params.dtw_token_timestamps = false;
     params.use_coreml = options.useCoreMLIos;
 
@@ -225,6 +229,7 @@ ParakeetContextInitResult hostInitParakeetContext(
 
     auto params = parakeet_context_default_params();
     params.use_gpu = options.useGpu;
+    params.use_mmap = options.useMmap;
 
     auto metalAvailability = getMetalAvailability(params.use_gpu);
     if (!metalAvailability.available) {
@@ -261,6 +266,13 @@ std::vector<uint8_t> hostLoadFileBytes(const std::string &path) {
     return bytes;
 }
 
+std::string hostResolveLocalFilePath(const std::string &path) {
+    if (isRemoteUrl(path)) {
+        return downloadToCache(path, "");
+    }
+    return path;
+}
+
 void hostClearCache() {
     [[NSFileManager defaultManager] removeItemAtPath:cacheDirectoryPath() error:nil];
 }
@@ -236,6 +236,7 @@ patch -p0 -d ./cpp < ./scripts/patches/ggml-quants.c.patch
 patch -p0 -d ./cpp < ./scripts/patches/ggml.c.patch
 patch -p0 -d ./cpp < ./scripts/patches/whisper.h.patch
 patch -p0 -d ./cpp < ./scripts/patches/whisper.cpp.patch
+patch -p0 -d ./cpp < ./scripts/patches/parakeet.h.patch
 patch -p0 -d ./cpp < ./scripts/patches/parakeet.cpp.patch
 rm -rf ./cpp/*.orig
 
@@ -25,6 +25,13 @@ export type TranscribeOptions = {
   offset?: number
   /** Duration of audio to process in milliseconds */
   duration?: number
+  /** Override the audio context size of the encoder, 1500 is 30 seconds (Default: 0 for the model default) */
+  audioCtx?: number
+  /**
+   * Size the audio context to the audio left in each 30 second window, in steps of 5.12 seconds with `audioCtx` as the minimum (Default: false).
+   * Encodes short clips several times faster, windows that decode poorly are retried with the full context.
+   */
+  audioCtxAuto?: boolean
   /** Initial decoding temperature */
   temperature?: number
   /** Temperature fallback increment applied between decoding retries */
@@ -33,8 +40,39 @@ export type TranscribeOptions = {
   beamSize?: number
   /** Number of best candidates to keep */
   bestOf?: number
+  /**
+   * Tokens drafted per step when the context has a draft model (Default: 4).
+   * Set to 0 to decode without the draft model.
+   */
+  nDraft?: number
   /** Initial Prompt */
   prompt?: string
+  /**
+   * Return segments and tokens as typed arrays in `packed` instead of
+   * segment objects, only used by transcribe and transcribeData (Default: false)
+   */
+  packedResult?: boolean
+}
+
+/**
+ * Segments and tokens in typed arrays over one native buffer.
+ * Segment i spans `text[textOffsets[i]..textOffsets[i + 1])` and owns the
+ * tokens `tokenOffsets[i]..tokenOffsets[i + 1]`. Times are in 10 ms units,
+ * -1 when not computed (token t_dtw needs DTW, Parakeet has none).
+ */
+export type TranscribePackedResult = {
+  nSegments: number
+  nTokens: number
+  /** UTF-8 text of all segments */
+  text: Uint8Array
+  textOffsets: Uint32Array
+  /** t0, t1 of each segment */
+  segmentTimes: Int32Array
+  tokenOffsets: Uint32Array
+  tokenIds: Int32Array
+  /** t0, t1, t_dtw of each token */
+  tokenTimes: Int32Array
+  tokenProbs: Float32Array
 }
 
 export type TranscribeResult = {
@@ -45,20 +83,44 @@ export type TranscribeResult = {
     t0: number
     t1: number
   }>
+  /** Set with the `packedResult` option, `segments` is empty then */
+  packed?: TranscribePackedResult
   isAborted: boolean
 }
 
+/**
+ * Mono 16kHz audio: an ArrayBuffer or Int16Array of signed 16-bit PCM, or a
+ * Float32Array of samples in [-1, 1]. A Float32Array is read in place by the
+ * native side, so don't modify it until the call resolves.
+ */
+export type AudioData = ArrayBuffer | Int16Array | Float32Array
+
 export type CoreMLAsset = {
   uri: string
   filepath: string
 }
 
+export type KVCacheType =
+  | 'f16'
+  | 'f32'
+  | 'q8_0'
+  | 'q5_0'
+  | 'q5_1'
+  | 'q4_0'
+  | 'q4_1'
+
 export type NativeContextOptions = {
   filePath: string
   isBundleAsset: boolean
   useFlashAttn?: boolean
   useGpu?: boolean
+  useMmap?: boolean
+  cacheTypeK?: KVCacheType
+  cacheTypeV?: KVCacheType
+  encoderCacheSize?: number
+  draftFilePath?: string
   useCoreMLIos?: boolean
+  maxConcurrentTranscriptions?: number
   downloadCoreMLAssets?: boolean
   coreMLAssets?: CoreMLAsset[]
 }
@@ -74,6 +136,7 @@ export type NativeParakeetContextOptions = {
   filePath: string
   isBundleAsset: boolean
   useGpu?: boolean
+  useMmap?: boolean
 }
 
 export type NativeParakeetContext = {
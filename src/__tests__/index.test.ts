@@ -1,8 +1,10 @@
 import {
   initParakeet,
   initWhisper,
+  initWhisperVad,
   releaseAllParakeet,
   releaseAllWhisper,
+  setWorkerCount,
 } from '..'
 import type { ParakeetContext } from '..'
 import type { ParakeetContextLike } from '../realtime-transcription/types'
@@ -32,6 +34,9 @@ const parakeetMocks = {
   transcribeData: global.parakeetTranscribeData as jest.MockedFunction<
     typeof global.parakeetTranscribeData
   >,
+  transcribeBatch: global.parakeetTranscribeBatch as jest.MockedFunction<
+    typeof global.parakeetTranscribeBatch
+  >,
   abort: global.parakeetAbortTranscribe as jest.MockedFunction<
     typeof global.parakeetAbortTranscribe
   >,
@@ -57,6 +62,154 @@ test('provides the Whisper mock API', async () => {
   await releaseAllWhisper()
 })
 
+test('runs concurrent transcriptions on one context', async () => {
+  const context = await initWhisper({
+    filePath: 'test.bin',
+    maxConcurrentTranscriptions: 2,
+  })
+  expect(global.whisperInitContext).toHaveBeenLastCalledWith(
+    expect.any(Number),
+    expect.objectContaining({ maxConcurrentTranscriptions: 2 }),
+  )
+  const results = await Promise.all([
+    context.transcribe('a.wav').promise,
+    context.transcribe('b.wav').promise,
+  ])
+  expect(results.map(({ result }) => result)).toEqual([' Test', ' Test'])
+})
+
+test('loads a draft model for speculative decoding', async () => {
+  const context = await initWhisper({
+    filePath: 'test.bin',
+    draftFilePath: 'file:///models/draft.bin',
+  })
+  expect(global.whisperInitContext).toHaveBeenLastCalledWith(
+    expect.any(Number),
+    expect.objectContaining({ draftFilePath: '/models/draft.bin' }),
+  )
+  const { result } = await context.transcribe('a.wav', { nDraft: 6 }).promise
+  expect(result).toEqual(' Test')
+})
+
+test('passes cache options to the native context', async () => {
+  await initWhisper({
+    filePath: 'test.bin',
+    useFlashAttn: true,
+    cacheTypeK: 'q8_0',
+    cacheTypeV: 'q8_0',
+    encoderCacheSize: 2,
+  })
+  expect(global.whisperInitContext).toHaveBeenLastCalledWith(
+    expect.any(Number),
+    expect.objectContaining({
+      cacheTypeK: 'q8_0',
+      cacheTypeV: 'q8_0',
+      encoderCacheSize: 2,
+    }),
+  )
+})
+
+test('transcribes a batch of clips', async () => {
+  const context = await initWhisper({ filePath: 'test.bin' })
+  const onProgress = jest.fn()
+  const clips = [new Float32Array(32000), new Int16Array(48000)]
+  const results = await context.transcribeBatch(clips, {
+    language: 'en',
+    callbackIntervalMs: 200,
+    audioCtxAuto: true,
+    onProgress,
+  }).promise
+  expect(global.whisperTranscribeBatch).toHaveBeenLastCalledWith(
+    context.id,
+    expect.objectContaining({
+      language: 'en',
+      callbackIntervalMs: 200,
+      audioCtxAuto: true,
+      jobId: expect.any(Number),
+    }),
+    clips,
+  )
+  expect(results).toHaveLength(2)
+  expect(onProgress).toHaveBeenCalledWith(100)
+})
+
+test('returns packed segments and tokens', async () => {
+  const context = await initWhisper({ filePath: 'test.bin' })
+  const { result, segments, packed } = await context.transcribeData(
+    new Float32Array(16000),
+    { tokenTimestamps: true, packedResult: true },
+  ).promise
+  expect(result).toBe(' Test')
+  expect(segments).toEqual([])
+  expect(packed).toMatchObject({ nSegments: 1, nTokens: 1 })
+  expect(Array.from(packed!.textOffsets)).toEqual([0, 5])
+  expect(Array.from(packed!.segmentTimes)).toEqual([0, 33])
+  expect(Array.from(packed!.tokenOffsets)).toEqual([0, 1])
+  expect(Array.from(packed!.tokenIds)).toEqual([2425])
+  expect(Array.from(packed!.tokenTimes)).toEqual([0, 33, -1])
+  expect(packed!.tokenProbs[0]).toBe(0.5)
+  expect(String.fromCharCode(...packed!.text)).toBe(' Test')
+})
+
+test('streams audio through a native Whisper session', async () => {
+  const context = await initWhisper({ filePath: 'test.bin' })
+  const onSegments = jest.fn()
+  const stream = await context.transcribeStream({
+    language: 'en',
+    stepMs: 500,
+    onSegments,
+  })
+  expect(global.whisperStreamStart).toHaveBeenLastCalledWith(
+    context.id,
+    expect.objectContaining({ stepMs: 500, jobId: expect.any(Number) }),
+  )
+  expect(onSegments).toHaveBeenCalledWith({
+    committed: [],
+    partial: [{ text: ' Test', t0: 0, t1: 33 }],
+  })
+
+  const audioData = new ArrayBuffer(3200)
+  await stream.push(audioData)
+  expect(global.whisperStreamPush).toHaveBeenLastCalledWith(
+    context.id,
+    audioData,
+  )
+
+  expect((await stream.flush()).result).toBe(' Test')
+  await expect(stream.push(audioData)).rejects.toThrow(
+    'Stream is already finished',
+  )
+  await stream.stop()
+  expect(global.whisperAbortTranscribe).not.toHaveBeenCalled()
+  await context.release()
+})
+
+test('detects speech through a native VAD stream', async () => {
+  const context = await initWhisperVad({ filePath: 'vad.bin' })
+  const stream = await context.detectSpeechStream({ threshold: 0.6 })
+  expect(global.whisperVadStreamStart).toHaveBeenLastCalledWith(context.id, {
+    threshold: 0.6,
+  })
+
+  const audioData = new ArrayBuffer(3200)
+  expect(await stream.push(audioData)).toEqual([{ type: 'start', t0: 0.5 }])
+  expect(global.whisperVadStreamPush).toHaveBeenLastCalledWith(
+    context.id,
+    audioData,
+  )
+
+  expect(await stream.flush()).toEqual([{ type: 'end', t0: 0.5, t1: 2.3 }])
+  await expect(stream.push(audioData)).rejects.toThrow(
+    'Stream is already finished',
+  )
+  await context.release()
+})
+
+test('sets the native worker count', async () => {
+  await setWorkerCount(3)
+  expect(global.whisperSetWorkerCount).toHaveBeenCalledWith(3)
+})
+
 test('initializes and releases a Parakeet context', async () => {
   expect(parakeetContextIsRealtimeCompatible).toBe(true)
 
@@ -64,12 +217,14 @@ test('initializes and releases a Parakeet context', async () => {
     filePath: 'file:///models/parakeet.bin',
     isBundleAsset: true,
     useGpu: false,
+    useMmap: false,
   })
 
   expect(parakeetMocks.init).toHaveBeenCalledWith(context.id, {
     filePath: '/models/parakeet.bin',
     isBundleAsset: true,
     useGpu: false,
+    useMmap: false,
   })
   expect(context).toMatchObject({
     gpu: false,
@@ -88,13 +243,14 @@ test('transcribes Parakeet audio files and aborts the matching job', async () =>
   const task = context.transcribe('file:///audio/jfk.wav', {
     maxThreads: 3,
     audioCtx: 1500,
+    beamSize: 4,
   })
 
   expect(parakeetMocks.transcribeFile).toHaveBeenCalledTimes(1)
   const [contextId, path, options] = parakeetMocks.transcribeFile.mock.calls[0]!
   expect(contextId).toBe(context.id)
   expect(path).toBe('/audio/jfk.wav')
-  expect(options).toMatchObject({ maxThreads: 3, audioCtx: 1500 })
+  expect(options).toMatchObject({ maxThreads: 3, audioCtx: 1500, beamSize: 4 })
   expect(options.jobId).toEqual(expect.any(Number))
   await expect(task.promise).resolves.toEqual({
     language: '',
@@ -121,6 +277,27 @@ test('transcribes Parakeet ArrayBuffer and base64 audio data', async () => {
   await context.transcribeData('AAAAAA==').promise
   const decodedData = parakeetMocks.transcribeData.mock.calls[1]![2]
   expect(Array.from(new Uint8Array(decodedData))).toEqual([0, 0, 0, 0])
+
+  const floatData = new Float32Array([0, 0.25, -0.25])
+  await context.transcribeData(floatData).promise
+  expect(parakeetMocks.transcribeData.mock.calls[2]![2]).toBe(floatData)
+})
+
+test('transcribes a batch of Parakeet clips', async () => {
+  const context = await initParakeet({ filePath: 'parakeet.bin' })
+  const clips = [new Float32Array(16000), 'AAAAAA==']
+
+  const task = context.transcribeBatch(clips, { batchSize: 4 })
+  await expect(task.promise).resolves.toHaveLength(2)
+  const [contextId, options, audioData] =
+    parakeetMocks.transcribeBatch.mock.calls[0]!
+  expect(contextId).toBe(context.id)
+  expect(options).toMatchObject({ batchSize: 4, jobId: expect.any(Number) })
+  expect(audioData[0]).toBe(clips[0])
+  expect(audioData[1]).toBeInstanceOf(ArrayBuffer)
+
+  await task.stop()
+  expect(parakeetMocks.abort).toHaveBeenCalledWith(context.id, options.jobId)
 })
 
 test('rejects remote Parakeet models and audio files', async () => {
@@ -3,7 +3,9 @@ import { Buffer } from 'safe-buffer'
 import RNWhisper from './NativeRNWhisper'
 import './jsi'
 import type {
+  AudioData,
   CoreMLAsset,
+  KVCacheType,
   NativeParakeetContext,
   NativeParakeetContextOptions,
   NativeWhisperContext,
@@ -12,9 +14,11 @@ import type {
   NativeVadContextOptions,
   TranscribeOptions,
   TranscribeResult,
+  TranscribePackedResult,
   VadOptions,
   VadSegment,
 } from './NativeRNWhisper'
+import type { NativeTranscribeResult } from './jsi'
 import { version } from './version.json'
 
 type NativeConstants = {
@@ -39,19 +43,28 @@ const jsiBindingKeys = [
   'whisperReleaseAllContexts',
   'whisperTranscribeFile',
   'whisperTranscribeData',
+  'whisperTranscribeBatch',
   'whisperAbortTranscribe',
+  'whisperStreamStart',
+  'whisperStreamPush',
+  'whisperStreamFlush',
   'whisperBench',
   'parakeetInitContext',
   'parakeetReleaseContext',
   'parakeetReleaseAllContexts',
   'parakeetTranscribeFile',
   'parakeetTranscribeData',
+  'parakeetTranscribeBatch',
   'parakeetAbortTranscribe',
   'whisperInitVadContext',
   'whisperReleaseVadContext',
   'whisperReleaseAllVadContexts',
   'whisperVadDetectSpeech',
   'whisperVadDetectSpeechFile',
+  'whisperVadStreamStart',
+  'whisperVadStreamPush',
+  'whisperVadStreamFlush',
+  'whisperSetWorkerCount',
   'whisperToggleNativeLog',
 ] as const
 
@@ -110,6 +123,35 @@ const toArrayBuffer = (view: Uint8Array): ArrayBuffer =>
 const decodeBase64ToArrayBuffer = (data: string): ArrayBuffer =>
   toArrayBuffer(Buffer.from(data, 'base64') as unknown as Uint8Array)
 
+const toNativeAudioData = (data: string | AudioData): AudioData =>
+  typeof data === 'string' ? decodeBase64ToArrayBuffer(data) : data
+
+// Views over the sections of a packed result, see PackedResultData in RNWhisperJSI.cpp
+const unpackTranscribeResult = (
+  result: NativeTranscribeResult,
+): TranscribeResult => {
+  if (!result.packed) return result as TranscribeResult
+  const { buffer, nSegments, nTokens } = result.packed
+  let offset = 0
+  const section = (length: number) => {
+    const start = offset
+    offset += length * 4
+    return start
+  }
+  const packed: TranscribePackedResult = {
+    nSegments,
+    nTokens,
+    textOffsets: new Uint32Array(buffer, section(nSegments + 1), nSegments + 1),
+    segmentTimes: new Int32Array(buffer, section(nSegments * 2), nSegments * 2),
+    tokenOffsets: new Uint32Array(buffer, section(nSegments + 1), nSegments + 1),
+    tokenIds: new Int32Array(buffer, section(nTokens), nTokens),
+    tokenTimes: new Int32Array(buffer, section(nTokens * 3), nTokens * 3),
+    tokenProbs: new Float32Array(buffer, section(nTokens), nTokens),
+    text: new Uint8Array(buffer, offset),
+  }
+  return { ...result, packed }
+}
+
 const stripFileScheme = (path: string): string =>
   path.startsWith('file://') ? path.slice(7) : path
 
@@ -207,7 +249,10 @@ const emitNativeLog = (level: string, text: string) => {
 }
 
 export type {
+  AudioData,
+  KVCacheType,
   TranscribeOptions,
+  TranscribePackedResult,
   TranscribeResult,
   VadOptions,
   VadSegment,
@@ -223,8 +268,54 @@ export type TranscribeNewSegmentsResult = {
 export interface TranscribeFileOptions extends TranscribeOptions {
   /** Progress callback, the progress is between 0 and 100 */
   onProgress?: (progress: number) => void
-  /** Callback when new segments are transcribed */
+  /**
+   * Callback when new segments are transcribed. Segments that arrive while a
+   * callback is pending are merged into one call, so `nNew` may be more than 1.
+   */
   onNewSegments?: (result: TranscribeNewSegmentsResult) => void
+  /**
+   * Minimum time between two onProgress / onNewSegments calls, events in
+   * between are merged. The last events are always delivered before the
+   * result. (Default: 50)
+   */
+  callbackIntervalMs?: number
+}
+
+export interface TranscribeBatchOptions extends TranscribeOptions {
+  /** Size the audio context to each clip, see TranscribeOptions (Default: true) */
+  audioCtxAuto?: boolean
+  /** Progress callback, the share of finished clips between 0 and 100 */
+  onProgress?: (progress: number) => void
+  /** Minimum time between two onProgress calls (Default: 50) */
+  callbackIntervalMs?: number
+}
+
+export type TranscribeStreamSegments = {
+  /** Segments that are final and will not change anymore */
+  committed: TranscribeResult['segments']
+  /** Segments of the current window, may change with more audio */
+  partial: TranscribeResult['segments']
+}
+
+export interface TranscribeStreamOptions extends TranscribeOptions {
+  /** Transcribe the current window every `stepMs` of new audio (Default: 1000) */
+  stepMs?: number
+  /** Commit the window once it reaches `lengthMs`, up to 30000 (Default: 10000) */
+  lengthMs?: number
+  /** Callback with the committed and partial segments of each step */
+  onSegments?: (result: TranscribeStreamSegments) => void
+}
+
+export type TranscribeStream = {
+  /**
+   * Push mono 16kHz audio. While an earlier push is still being processed the
+   * audio is only queued for it and the returned promise resolves right away.
+   */
+  push: (data: AudioData) => Promise<void>
+  /** Transcribe the remaining audio and return all committed segments */
+  flush: () => Promise<TranscribeResult>
+  /** Abort the stream */
+  stop: () => Promise<void>
 }
 
 export type BenchResult = {
@@ -257,9 +348,9 @@ export class WhisperContext {
     this.reasonNoGPU = reasonNoGPU
   }
 
-  private runTranscription(
-    run: (jobId: number) => Promise<TranscribeResult>,
-  ): { stop: () => Promise<void>; promise: Promise<TranscribeResult> } {
+  private runTranscription<T = TranscribeResult>(
+    run: (jobId: number) => Promise<T>,
+  ): { stop: () => Promise<void>; promise: Promise<T> } {
     const { whisperAbortTranscribe } = getJsi()
     const jobId = Math.floor(Math.random() * 10000)
 
@@ -311,7 +402,7 @@ export class WhisperContext {
         ...rest,
         onProgress: progressCallback,
         jobId,
-      }),
+      }).then(unpackTranscribeResult),
     )
 
     return {
@@ -326,10 +417,10 @@ export class WhisperContext {
   }
 
   /**
-   * Transcribe audio data (base64 encoded float32 PCM data or ArrayBuffer)
+   * Transcribe audio data (base64 encoded 16-bit PCM data, ArrayBuffer, Int16Array or Float32Array)
    */
   transcribeData(
-    data: string | ArrayBuffer,
+    data: string | AudioData,
     options: TranscribeFileOptions = {},
   ): {
     stop: () => Promise<void>
@@ -344,8 +435,7 @@ export class WhisperContext {
           onProgress(progress)
         }
       : undefined
-    const audioData =
-      data instanceof ArrayBuffer ? data : decodeBase64ToArrayBuffer(data)
+    const audioData = toNativeAudioData(data)
 
     const task = this.runTranscription(
       (jobId) =>
@@ -353,7 +443,7 @@ export class WhisperContext {
           this.id,
           { ...rest, onProgress: progressCallback, jobId },
           audioData,
-        ),
+        ).then(unpackTranscribeResult),
     )
 
     return {
@@ -367,6 +457,65 @@ export class WhisperContext {
     }
   }
 
+  /**
+   * Transcribe many short clips (base64 encoded 16-bit PCM data, ArrayBuffer, Int16Array or Float32Array).
+   * Clips are packed into shared 30 second windows, so the encoder runs once per window
+   * instead of once per clip. Results are returned in the order of the clips.
+   */
+  transcribeBatch(
+    clips: Array<string | AudioData>,
+    options: TranscribeBatchOptions = {},
+  ): {
+    stop: () => Promise<void>
+    promise: Promise<TranscribeResult[]>
+  } {
+    const { whisperTranscribeBatch } = getJsi()
+    const audioData = clips.map(toNativeAudioData)
+
+    return this.runTranscription((jobId) =>
+      whisperTranscribeBatch(this.id, { ...options, jobId }, audioData),
+    )
+  }
+
+  /**
+   * Start a native streaming transcription. Mel and the committed text are
+   * kept natively, so each push only processes the new audio.
+   * The context can't be used for other transcriptions until the stream is flushed or stopped.
+   */
+  async transcribeStream(
+    options: TranscribeStreamOptions = {},
+  ): Promise<TranscribeStream> {
+    const {
+      whisperStreamStart,
+      whisperStreamPush,
+      whisperStreamFlush,
+      whisperAbortTranscribe,
+    } = getJsi()
+    const jobId = Math.floor(Math.random() * 10000)
+    let finished = false
+
+    await whisperStreamStart(this.id, { ...options, jobId })
+
+    const flush = async () => {
+      if (finished) throw new Error('Stream is already finished')
+      finished = true
+      return whisperStreamFlush(this.id)
+    }
+
+    return {
+      push: async (data: AudioData) => {
+        if (finished) throw new Error('Stream is already finished')
+        return whisperStreamPush(this.id, data)
+      },
+      flush,
+      stop: async () => {
+        if (finished) return
+        await whisperAbortTranscribe(this.id, jobId)
+        await flush()
+      },
+    }
+  }
+
   async bench(maxThreads: number): Promise<BenchResult> {
     const { whisperBench } = getJsi()
     const result = await whisperBench(this.id, maxThreads)
@@ -395,6 +544,39 @@ export type ContextOptions = {
   useGpu?: boolean
   /** Use Flash Attention, only recommended if GPU available */
   useFlashAttn?: boolean
+  /**
+   * Map the model file instead of reading it into memory (Default: true).
+   * Weights on the CPU then load lazily from the page cache, only for plain files, not Android assets.
+   */
+  useMmap?: boolean
+  /**
+   * Type of the decoder self- and cross-attention key cache (Default: 'f16').
+   * 'q8_0' halves the cache memory, 'q4_0' / 'q5_0' save more at some accuracy cost.
+   */
+  cacheTypeK?: KVCacheType
+  /**
+   * Type of the decoder value cache (Default: 'f16').
+   * Quantized types require `useFlashAttn`, otherwise f16 is used.
+   */
+  cacheTypeV?: KVCacheType
+  /**
+   * Number of encoder outputs kept per transcription state (Default: 0).
+   * Transcribing the same 30 second window again (e.g. re-running a clip with other options) then skips the encoder.
+   * Each entry takes n_audio_state * 1500 floats, about 2.3 MB for base and 7.7 MB for large models.
+   */
+  encoderCacheSize?: number
+  /**
+   * Smaller model with the same vocabulary for speculative decoding, e.g. large-v3-turbo for large-v3.
+   * It drafts a few tokens that the main model verifies in one pass, the result stays the same.
+   * Used while decoding with a single decoder (greedy without temperature fallback).
+   */
+  draftFilePath?: string | number
+  /**
+   * Number of `transcribe` / `transcribeData` calls that can run at the same time on this context (Default: 1).
+   * Each one shares the model weights but allocates its own KV cache and compute buffers.
+   * Calls with `nProcessors` > 1 still take the whole context.
+   */
+  maxConcurrentTranscriptions?: number
 }
 
 /**
@@ -409,6 +591,12 @@ export async function initWhisper({
   useGpu = true,
   useCoreMLIos = true,
   useFlashAttn = false,
+  useMmap = true,
+  cacheTypeK,
+  cacheTypeV,
+  encoderCacheSize,
+  draftFilePath,
+  maxConcurrentTranscriptions = 1,
 }: ContextOptions): Promise<WhisperContext> {
   await installJsi()
   const { whisperInitContext } = getJsi()
@@ -421,6 +609,13 @@ export async function initWhisper({
           filePath,
           'Transcribe remote file is not supported, please download it first',
         )
+  const draftPath =
+    draftFilePath !== undefined
+      ? resolveLocalInputPath(
+          draftFilePath,
+          'Remote draft model is not supported, please download it first',
+        )
+      : undefined
 
   const contextId = createContextId()
   const context = await whisperInitContext(contextId, {
@@ -428,7 +623,13 @@ export async function initWhisper({
     isBundleAsset: !!isBundleAsset,
     useFlashAttn,
     useGpu,
+    useMmap,
+    cacheTypeK,
+    cacheTypeV,
+    encoderCacheSize,
+    draftFilePath: draftPath,
     useCoreMLIos,
+    maxConcurrentTranscriptions,
     downloadCoreMLAssets: __DEV__ && !!coreMLAssets,
     coreMLAssets,
   } satisfies NativeContextOptions)
@@ -462,6 +663,8 @@ export type ParakeetContextOptions = {
   isBundleAsset?: boolean
   /** Use GPU acceleration if it is available. */
   useGpu?: boolean
+  /** Map the model file instead of reading it into memory (default: true). */
+  useMmap?: boolean
 }
 
 export type ParakeetTranscribeOptions = {
@@ -469,6 +672,15 @@ export type ParakeetTranscribeOptions = {
   maxThreads?: number
   /** Override the model audio context size (0 uses the model default). */
   audioCtx?: number
+  /** Use TDT beam search with the given beam size instead of greedy decoding (values <= 1 use greedy). */
+  beamSize?: number
+  /** Return segments and tokens as typed arrays in `packed`, only used by transcribe and transcribeData (default: false). */
+  packedResult?: boolean
+}
+
+export type ParakeetTranscribeBatchOptions = ParakeetTranscribeOptions & {
+  /** Max number of clips encoded and decoded together (default: 8, 1 transcribes the clips one by one). */
+  batchSize?: number
 }
 
 export class ParakeetContext {
@@ -484,9 +696,9 @@ export class ParakeetContext {
     this.reasonNoGPU = reasonNoGPU
   }
 
-  private runTranscription(
-    run: (jobId: number) => Promise<TranscribeResult>,
-  ): { stop: () => Promise<void>; promise: Promise<TranscribeResult> } {
+  private runTranscription<T = TranscribeResult>(
+    run: (jobId: number) => Promise<T>,
+  ): { stop: () => Promise<void>; promise: Promise<T> } {
     const { parakeetAbortTranscribe } = getJsi()
     const jobId = Math.floor(Math.random() * 10000)
 
@@ -519,24 +731,47 @@ export class ParakeetContext {
     }
 
     return this.runTranscription((jobId) =>
-      parakeetTranscribeFile(this.id, path, { ...options, jobId }),
+      parakeetTranscribeFile(this.id, path, { ...options, jobId }).then(
+        unpackTranscribeResult,
+      ),
     )
   }
 
-  /** Transcribe base64-encoded signed 16-bit PCM data or an ArrayBuffer. */
+  /** Transcribe base64-encoded signed 16-bit PCM data, an ArrayBuffer, Int16Array or Float32Array. */
   transcribeData(
-    data: string | ArrayBuffer,
+    data: string | AudioData,
     options: ParakeetTranscribeOptions = {},
   ): {
     stop: () => Promise<void>
     promise: Promise<TranscribeResult>
   } {
     const { parakeetTranscribeData } = getJsi()
-    const audioData =
-      data instanceof ArrayBuffer ? data : decodeBase64ToArrayBuffer(data)
+    const audioData = toNativeAudioData(data)
+
+    return this.runTranscription((jobId) =>
+      parakeetTranscribeData(this.id, { ...options, jobId }, audioData).then(
+        unpackTranscribeResult,
+      ),
+    )
+  }
+
+  /**
+   * Transcribe many short clips (base64-encoded signed 16-bit PCM data, ArrayBuffer, Int16Array or Float32Array).
+   * Clips of similar length are padded and encoded together, then decoded in lock-step.
+   * Results are returned in the order of the clips.
+   */
+  transcribeBatch(
+    clips: Array<string | AudioData>,
+    options: ParakeetTranscribeBatchOptions = {},
+  ): {
+    stop: () => Promise<void>
+    promise: Promise<TranscribeResult[]>
+  } {
+    const { parakeetTranscribeBatch } = getJsi()
+    const audioData = clips.map(toNativeAudioData)
 
     return this.runTranscription((jobId) =>
-      parakeetTranscribeData(this.id, { ...options, jobId }, audioData),
+      parakeetTranscribeBatch(this.id, { ...options, jobId }, audioData),
     )
   }
 
@@ -551,6 +786,7 @@ export async function initParakeet({
   filePath,
   isBundleAsset,
   useGpu = true,
+  useMmap = true,
 }: ParakeetContextOptions): Promise<ParakeetContext> {
   await installJsi()
   const { parakeetInitContext } = getJsi()
@@ -568,6 +804,7 @@ export async function initParakeet({
     filePath: path,
     isBundleAsset: !!isBundleAsset,
     useGpu,
+    useMmap,
   } satisfies NativeParakeetContextOptions)
 
   return new ParakeetContext(context)
@@ -594,6 +831,24 @@ export type VadContextOptions = {
   nThreads?: number
 }
 
+export type VadStreamEvent = {
+  /** `start` when speech starts at `t0`, `end` when the speech segment `t0`-`t1` ends */
+  type: 'start' | 'end'
+  t0: number
+  t1?: number
+}
+
+export type VadStream = {
+  /**
+   * Push mono 16kHz audio, resolves with the events detected in it. While an
+   * earlier push is still being processed the audio is only queued for it:
+   * that push reports its events and this one resolves with none.
+   */
+  push: (data: AudioData) => Promise<VadStreamEvent[]>
+  /** Process the remaining audio and end the current speech */
+  flush: () => Promise<VadStreamEvent[]>
+}
+
 export class WhisperVadContext {
   id: number
 
@@ -634,21 +889,46 @@ export class WhisperVadContext {
   }
 
   /**
-   * Detect speech segments in raw audio data (base64 encoded float32 PCM data or ArrayBuffer)
+   * Detect speech segments in raw audio data (base64 encoded 16-bit PCM data, ArrayBuffer, Int16Array or Float32Array)
    */
   async detectSpeechData(
-    audioData: string | ArrayBuffer,
+    audioData: string | AudioData,
     options: VadOptions = {},
   ): Promise<VadSegment[]> {
     const { whisperVadDetectSpeech } = getJsi()
-    const pcmData =
-      audioData instanceof ArrayBuffer
-        ? audioData
-        : decodeBase64ToArrayBuffer(audioData)
+    const pcmData = toNativeAudioData(audioData)
     const result = await whisperVadDetectSpeech(this.id, options, pcmData)
     return result.segments || []
   }
 
+  /**
+   * Start a native streaming speech detection. The model state and partial
+   * windows are kept natively, so each push only processes the new audio.
+   * The context can't be used for other detections until the stream is flushed.
+   */
+  async detectSpeechStream(options: VadOptions = {}): Promise<VadStream> {
+    const {
+      whisperVadStreamStart,
+      whisperVadStreamPush,
+      whisperVadStreamFlush,
+    } = getJsi()
+    let finished = false
+
+    await whisperVadStreamStart(this.id, options)
+
+    return {
+      push: async (data: AudioData) => {
+        if (finished) throw new Error('Stream is already finished')
+        return whisperVadStreamPush(this.id, data)
+      },
+      flush: async () => {
+        if (finished) throw new Error('Stream is already finished')
+        finished = true
+        return whisperVadStreamFlush(this.id)
+      },
+    }
+  }
+
   async release(): Promise<void> {
     const { whisperReleaseVadContext } = getJsi()
     return whisperReleaseVadContext(this.id)
@@ -698,6 +978,17 @@ export async function releaseAllWhisperVad(): Promise<void> {
   return whisperReleaseAllVadContexts()
 }
 
+/**
+ * Set the number of native worker threads running transcription and VAD tasks
+ * (0 for the default: 2-4 depending on the CPU cores).
+ * Increasing takes effect immediately, decreasing after all contexts are released.
+ */
+export async function setWorkerCount(count: number): Promise<void> {
+  await installJsi()
+  const { whisperSetWorkerCount } = getJsi()
+  return whisperSetWorkerCount(count)
+}
+
 let logInitialized = false
 
 /** Enable or disable native whisper.cpp logging */
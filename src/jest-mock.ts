@@ -7,6 +7,22 @@ const transcribeResult = {
   isAborted: false,
 }
 
+// transcribeResult with one token, laid out like PackedResultData in RNWhisperJSI.cpp
+const createPackedTranscribeResult = () => {
+  const text = Array.from(transcribeResult.result, (c) => c.charCodeAt(0))
+  const buffer = new ArrayBuffer(44 + text.length)
+  const words = new Int32Array(buffer, 0, 10)
+  words.set([0, text.length, 0, 33, 0, 1]) // text offsets, times, token offsets
+  words.set([2425, 0, 33, -1], 6) // token id, t0, t1, t_dtw
+  new Float32Array(buffer, 40, 1).set([0.5])
+  new Uint8Array(buffer, 44).set(text)
+  return {
+    ...transcribeResult,
+    segments: [],
+    packed: { buffer, nSegments: 1, nTokens: 1 },
+  }
+}
+
 const parakeetTranscribeResult = {
   language: '',
   result: ' Parakeet test',
@@ -47,15 +63,45 @@ global.whisperReleaseContext = jest.fn(async () => undefined)
 global.whisperReleaseAllContexts = jest.fn(async () => undefined)
 global.whisperTranscribeFile = jest.fn(async () => transcribeResult)
 global.whisperTranscribeData = jest.fn(
+  async (
+    _contextId: number,
+    options: {
+      onProgress?: (progress: number) => void
+      packedResult?: boolean
+    },
+  ) => {
+    options.onProgress?.(100)
+    return options.packedResult
+      ? createPackedTranscribeResult()
+      : transcribeResult
+  },
+)
+global.whisperTranscribeBatch = jest.fn(
   async (
     _contextId: number,
     options: { onProgress?: (progress: number) => void },
+    clips: unknown[],
   ) => {
     options.onProgress?.(100)
-    return transcribeResult
+    return clips.map(() => transcribeResult)
   },
 )
 global.whisperAbortTranscribe = jest.fn(async () => undefined)
+global.whisperStreamStart = jest.fn(
+  async (
+    _contextId: number,
+    options: {
+      onSegments?: (result: {
+        committed: typeof transcribeResult.segments
+        partial: typeof transcribeResult.segments
+      }) => void
+    },
+  ) => {
+    options.onSegments?.({ committed: [], partial: transcribeResult.segments })
+  },
+)
+global.whisperStreamPush = jest.fn(async () => undefined)
+global.whisperStreamFlush = jest.fn(async () => transcribeResult)
 global.whisperBench = jest.fn(async () =>
   JSON.stringify(['NEON', 1, 1, 1, 1, 1]),
 )
@@ -68,6 +114,10 @@ global.parakeetReleaseContext = jest.fn(async () => undefined)
 global.parakeetReleaseAllContexts = jest.fn(async () => undefined)
 global.parakeetTranscribeFile = jest.fn(async () => parakeetTranscribeResult)
 global.parakeetTranscribeData = jest.fn(async () => parakeetTranscribeResult)
+global.parakeetTranscribeBatch = jest.fn(
+  async (_contextId: number, _options: unknown, clips: unknown[]) =>
+    clips.map(() => parakeetTranscribeResult),
+)
 global.parakeetAbortTranscribe = jest.fn(async () => undefined)
 global.whisperInitVadContext = jest.fn(async (contextId: number) => ({
   contextId,
@@ -78,6 +128,14 @@ global.whisperReleaseVadContext = jest.fn(async () => undefined)
 global.whisperReleaseAllVadContexts = jest.fn(async () => undefined)
 global.whisperVadDetectSpeech = jest.fn(async () => vadResult)
 global.whisperVadDetectSpeechFile = jest.fn(async () => vadResult)
+global.whisperVadStreamStart = jest.fn(async () => undefined)
+global.whisperVadStreamPush = jest.fn(async () => [
+  { type: 'start' as const, t0: 0.5 },
+])
+global.whisperVadStreamFlush = jest.fn(async () => [
+  { type: 'end' as const, t0: 0.5, t1: 2.3 },
+])
+global.whisperSetWorkerCount = jest.fn(async () => undefined)
 global.whisperToggleNativeLog = jest.fn(async () => undefined)
 
 module.exports = jest.requireActual('./index')
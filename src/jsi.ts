@@ -1,5 +1,6 @@
 /* eslint-disable no-var */
 import type {
+  AudioData,
   NativeContextOptions,
   NativeParakeetContext,
   NativeParakeetContextOptions,
@@ -12,8 +13,17 @@ import type {
   VadSegment,
 } from './NativeRNWhisper'
 
+export type NativeTranscribeResult = Omit<TranscribeResult, 'packed'> & {
+  packed?: {
+    buffer: ArrayBuffer
+    nSegments: number
+    nTokens: number
+  }
+}
+
 type TranscribeCallbacks = {
   jobId?: number
+  callbackIntervalMs?: number
   onProgress?: (progress: number) => void
   onNewSegments?: (result: {
     nNew: number
@@ -23,10 +33,32 @@ type TranscribeCallbacks = {
   }) => void
 }
 
+type TranscribeStreamCallbacks = {
+  jobId?: number
+  stepMs?: number
+  lengthMs?: number
+  onSegments?: (result: {
+    committed: TranscribeResult['segments']
+    partial: TranscribeResult['segments']
+  }) => void
+}
+
+type VadStreamEvent = {
+  type: 'start' | 'end'
+  t0: number
+  t1?: number
+}
+
 type ParakeetTranscribeOptions = {
   jobId?: number
   maxThreads?: number
   audioCtx?: number
+  beamSize?: number
+  packedResult?: boolean
+}
+
+type ParakeetTranscribeBatchOptions = ParakeetTranscribeOptions & {
+  batchSize?: number
 }
 
 declare global {
@@ -44,16 +76,27 @@ declare global {
     contextId: number,
     pathOrBase64: string,
     options: TranscribeOptions & TranscribeCallbacks,
-  ) => Promise<TranscribeResult>
+  ) => Promise<NativeTranscribeResult>
   var whisperTranscribeData: (
     contextId: number,
     options: TranscribeOptions & TranscribeCallbacks,
-    data: ArrayBuffer,
-  ) => Promise<TranscribeResult>
+    data: AudioData,
+  ) => Promise<NativeTranscribeResult>
+  var whisperTranscribeBatch: (
+    contextId: number,
+    options: TranscribeOptions & Omit<TranscribeCallbacks, 'onNewSegments'>,
+    clips: AudioData[],
+  ) => Promise<TranscribeResult[]>
   var whisperAbortTranscribe: (
     contextId: number,
     jobId: number,
   ) => Promise<void>
+  var whisperStreamStart: (
+    contextId: number,
+    options: TranscribeOptions & TranscribeStreamCallbacks,
+  ) => Promise<void>
+  var whisperStreamPush: (contextId: number, data: AudioData) => Promise<void>
+  var whisperStreamFlush: (contextId: number) => Promise<TranscribeResult>
   var whisperBench: (contextId: number, maxThreads: number) => Promise<string>
   var parakeetInitContext: (
     contextId: number,
@@ -65,12 +108,17 @@ declare global {
     contextId: number,
     pathOrBase64: string,
     options: ParakeetTranscribeOptions,
-  ) => Promise<TranscribeResult>
+  ) => Promise<NativeTranscribeResult>
   var parakeetTranscribeData: (
     contextId: number,
     options: ParakeetTranscribeOptions,
-    data: ArrayBuffer,
-  ) => Promise<TranscribeResult>
+    data: AudioData,
+  ) => Promise<NativeTranscribeResult>
+  var parakeetTranscribeBatch: (
+    contextId: number,
+    options: ParakeetTranscribeBatchOptions,
+    clips: AudioData[],
+  ) => Promise<TranscribeResult[]>
   var parakeetAbortTranscribe: (
     contextId: number,
     jobId: number,
@@ -84,13 +132,23 @@ declare global {
   var whisperVadDetectSpeech: (
     contextId: number,
     options: VadOptions,
-    audioData: ArrayBuffer,
+    audioData: AudioData,
   ) => Promise<{ hasSpeech: boolean; segments: VadSegment[] }>
   var whisperVadDetectSpeechFile: (
     contextId: number,
     pathOrBase64: string,
     options: VadOptions,
   ) => Promise<{ hasSpeech: boolean; segments: VadSegment[] }>
+  var whisperVadStreamStart: (
+    contextId: number,
+    options: VadOptions,
+  ) => Promise<void>
+  var whisperVadStreamPush: (
+    contextId: number,
+    audioData: AudioData,
+  ) => Promise<VadStreamEvent[]>
+  var whisperVadStreamFlush: (contextId: number) => Promise<VadStreamEvent[]>
+  var whisperSetWorkerCount: (count: number) => Promise<void>
   var whisperToggleNativeLog: (
     enabled: boolean,
     onLog?: (level: string, text: string) => void,